@@ -0,0 +1,252 @@
+#include "include/backup-catalog.h"
+#include "include/backup-restore.h"
+#include "include/backup-delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*The catalog, loaded on first use*/
+static BackupCatalog catalog = { 0 };
+
+/*===== Internal helpers =====*/
+/*Making room for one more entry*/
+static bool catalog_reserve() {
+    if (catalog.count < catalog.capacity) {
+        return true;
+    }
+    int capacity = catalog.capacity ? catalog.capacity * 2 : 64;
+    BackupEntry* grown = realloc(catalog.entries, capacity * sizeof(BackupEntry));
+    if (!grown) {
+        return false;
+    }
+    catalog.entries = grown;
+    catalog.capacity = capacity;
+    return true;
+}
+
+/*Inserting an entry in timestamp order (normally at the end)*/
+static bool catalog_insert(const BackupEntry* entry) {
+    int existing = backup_catalog_find(entry->filename);
+    if (existing >= 0) {
+        catalog.entries[existing] = *entry; // Re-added: the newer record wins
+        return true;
+    }
+    if (!catalog_reserve()) {
+        return false;
+    }
+    int i = catalog.count;
+    while (i > 0 && catalog.entries[i - 1].timestamp > entry->timestamp) {
+        catalog.entries[i] = catalog.entries[i - 1];
+        i--;
+    }
+    catalog.entries[i] = *entry;
+    catalog.count++;
+    return true;
+}
+
+/*Dropping an entry from memory*/
+static void catalog_erase(int index) {
+    memmove(&catalog.entries[index], &catalog.entries[index + 1],
+        (catalog.count - index - 1) * sizeof(BackupEntry));
+    catalog.count--;
+}
+
+/*Writing one entry as a journal line*/
+static void write_catalog_line(FILE* fptr, const BackupEntry* e) {
+    fprintf(fptr, "%c %lld %lld %s %s %s\n", CATALOG_ADD_MARK,
+        (long long)e->timestamp, (long long)e->file_size,
+        e->is_valid ? e->checksum : "-",
+        e->parent[0] ? e->parent : "-",
+        e->filename);
+}
+
+/*Parsing one journal line into the in-memory catalog*/
+static void replay_catalog_line(const char* line) {
+    char name[256];
+    if (line[0] == CATALOG_REMOVE_MARK) {
+        if (sscanf(line + 1, "%255s", name) == 1) {
+            int index = backup_catalog_find(name);
+            if (index >= 0) {
+                catalog_erase(index);
+            }
+        }
+        return;
+    }
+
+    BackupEntry e = { 0 };
+    long long timestamp;
+    long long size;
+    char checksum[33];
+    char parent[256];
+    if (line[0] != CATALOG_ADD_MARK ||
+        sscanf(line + 1, "%lld %lld %32s %255s %255s", &timestamp, &size, checksum, parent, name) != 5) {
+        return; // Torn or foreign line: skipped
+    }
+    e.timestamp = (time_t)timestamp;
+    e.file_size = (size_t)size;
+    e.is_valid = strcmp(checksum, "-") != 0;
+    if (e.is_valid) {
+        snprintf(e.checksum, sizeof(e.checksum), "%s", checksum);
+    }
+    if (strcmp(parent, "-") != 0) {
+        snprintf(e.parent, sizeof(e.parent), "%s", parent);
+    }
+    snprintf(e.filename, sizeof(e.filename), "%s", name);
+    snprintf(e.path, sizeof(e.path), "%s/%s", BACKUP_DIR, name);
+    catalog_insert(&e);
+}
+
+/*Rewriting the catalog with only the live entries*/
+static bool compact_catalog() {
+    FILE* fptr = fopen(BACKUP_CATALOG_TEMP, "w");
+    if (!fptr) {
+        return false;
+    }
+    for (int i = 0; i < catalog.count; i++) {
+        write_catalog_line(fptr, &catalog.entries[i]);
+    }
+    if (fclose(fptr) != 0) {
+        remove(BACKUP_CATALOG_TEMP);
+        return false;
+    }
+#ifdef _WIN32
+    remove(BACKUP_CATALOG_FILE); // rename() does not overwrite on Windows
+#endif
+    if (rename(BACKUP_CATALOG_TEMP, BACKUP_CATALOG_FILE) != 0) {
+        return false;
+    }
+    catalog.journal_lines = catalog.count;
+    return true;
+}
+
+/*Building the catalog from the backup directory (first run, or catalog lost)*/
+static void scan_backup_dir() {
+    DIR* dir = opendir(BACKUP_DIR);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        time_t t = get_backup_timestamp(ent->d_name);
+        const char* ext = strrchr(ent->d_name, '.');
+        if (t == (time_t)-1 || !ext ||
+            (strcmp(ext, ".bak") != 0 && strcmp(ext, BACKUP_DELTA_EXT) != 0)) {
+            continue;
+        }
+
+        BackupEntry e = { 0 };
+        snprintf(e.filename, sizeof(e.filename), "%s", ent->d_name);
+        snprintf(e.path, sizeof(e.path), "%s/%s", BACKUP_DIR, ent->d_name);
+        e.timestamp = t;
+        struct stat st;
+        if (stat(e.path, &st) == 0) {
+            e.file_size = (size_t)st.st_size;
+        }
+        e.is_valid = backup_checksum_string(e.path, e.checksum, sizeof(e.checksum));
+        BackupManifest manifest;
+        if (load_backup_manifest(e.path, &manifest)) {
+            snprintf(e.parent, sizeof(e.parent), "%s", manifest.header.parent);
+            free_backup_manifest(&manifest);
+        }
+        catalog_insert(&e);
+    }
+    closedir(dir);
+}
+
+/*===== Catalog =====*/
+/*Getting the catalog, loading it (or rebuilding it from the directory) on first use*/
+BackupCatalog* backup_catalog_get() {
+    if (catalog.loaded) {
+        return &catalog;
+    }
+    catalog.loaded = true;
+
+    FILE* fptr = fopen(BACKUP_CATALOG_FILE, "r");
+    if (!fptr) {
+        scan_backup_dir();
+        compact_catalog();
+        return &catalog;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), fptr)) {
+        replay_catalog_line(line);
+        catalog.journal_lines++;
+    }
+    fclose(fptr);
+    return &catalog;
+}
+
+/*Recording a new backup*/
+bool backup_catalog_add(const BackupEntry* entry) {
+    backup_catalog_get();
+    if (!catalog_insert(entry)) {
+        return false;
+    }
+
+    FILE* fptr = fopen(BACKUP_CATALOG_FILE, "a");
+    if (!fptr) {
+        return false;
+    }
+    write_catalog_line(fptr, entry);
+    catalog.journal_lines++;
+    return fclose(fptr) == 0;
+}
+
+/*Recording that a backup was deleted*/
+bool backup_catalog_remove(const char* filename) {
+    backup_catalog_get();
+    int index = backup_catalog_find(filename);
+    if (index < 0) {
+        return false;
+    }
+    catalog_erase(index);
+
+    /*Removal lines pile up, so the journal is rewritten once they outnumber live entries*/
+    if (catalog.journal_lines + 1 > 2 * catalog.count + 16) {
+        return compact_catalog();
+    }
+    FILE* fptr = fopen(BACKUP_CATALOG_FILE, "a");
+    if (!fptr) {
+        return false;
+    }
+    fprintf(fptr, "%c %s\n", CATALOG_REMOVE_MARK, filename);
+    catalog.journal_lines++;
+    return fclose(fptr) == 0;
+}
+
+/*Finding a backup by file name (-1 if not catalogued)*/
+int backup_catalog_find(const char* filename) {
+    /*Names embed their timestamp, so a binary search lands on the right neighbourhood*/
+    time_t t = get_backup_timestamp(filename);
+    int lo = 0;
+    int hi = catalog.count;
+    if (t == (time_t)-1) {
+        hi = 0; // Not a timestamped name: plain scan below
+    }
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (catalog.entries[mid].timestamp < t) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    for (int i = lo; i < catalog.count; i++) {
+        if (t != (time_t)-1 && catalog.entries[i].timestamp != t) {
+            break;
+        }
+        if (strcmp(catalog.entries[i].filename, filename) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*Forgetting the in-memory catalog (it is reloaded on next use)*/
+void backup_catalog_reset() {
+    free(catalog.entries);
+    memset(&catalog, 0, sizeof(catalog));
+}
@@ -0,0 +1,482 @@
+#include "include/backup-delta.h"
+#include "include/backup-catalog.h"
+#include "include/backup-restore.h"
+#include "include/inventory.h"
+#include "include/crc32c.h"
+#include "include/file-copy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*64-bit seeks, so multi-GB backups work on every platform*/
+#ifdef _WIN32
+#define backup_seek _fseeki64
+#define backup_tell _ftelli64
+#else
+#define backup_seek fseeko
+#define backup_tell ftello
+#endif
+
+/*Delta file header (followed by changed_blocks DeltaEntry + block data)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    char name[BACKUP_NAME_LEN];
+    char parent[BACKUP_NAME_LEN];
+    long long file_size; // inventory.dat size captured by the delta
+    long long changed_blocks;
+} DeltaHeader;
+
+/*One changed block inside a delta file*/
+typedef struct {
+    long long index;
+    int length; // Bytes of block data that follow
+    int reserved;
+} DeltaEntry;
+
+/*===== Internal helpers =====*/
+/*Getting the file name part of a path*/
+static const char* path_basename(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* backslash = strrchr(path, '\\');
+    if (backslash && (!slash || backslash > slash)) {
+        slash = backslash;
+    }
+    return slash ? slash + 1 : path;
+}
+
+/*Building the manifest path that goes with a backup file*/
+static void manifest_path_for(const char* backup_path, char* out, size_t size) {
+    snprintf(out, size, "%s", backup_path);
+    char* dot = strrchr(out, '.');
+    if (dot && dot > path_basename(out)) {
+        *dot = '\0';
+    }
+    strncat(out, BACKUP_MANIFEST_EXT, size - strlen(out) - 1);
+}
+
+/*Hashing every block of inventory.dat, writing changed ones to delta (if given)*/
+static bool hash_inventory(unsigned long long** checksums, long long* file_size,
+    FILE* delta, const BackupManifest* parent, long long* changed, unsigned int* delta_crc) {
+    *checksums = NULL;
+    *file_size = 0;
+    if (changed) {
+        *changed = 0;
+    }
+
+    FILE* src = fopen(FILENAME, "rb");
+    if (!src) {
+        return false;
+    }
+
+    unsigned char* block = malloc(BACKUP_BLOCK_SIZE);
+    long long capacity = 0;
+    long long count = 0;
+    bool ok = block != NULL;
+    size_t length;
+
+    while (ok && (length = fread(block, 1, BACKUP_BLOCK_SIZE, src)) > 0) {
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            unsigned long long* grown = realloc(*checksums, capacity * sizeof(unsigned long long));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            *checksums = grown;
+        }
+        unsigned long long sum = backup_block_checksum(block, length);
+        (*checksums)[count] = sum;
+
+        /*A block is new if the parent did not have it or it hashes differently*/
+        if (delta && (count >= parent->header.block_count || parent->checksums[count] != sum ||
+            (count == parent->header.block_count - 1 &&
+                parent->header.file_size - count * BACKUP_BLOCK_SIZE != (long long)length))) {
+            DeltaEntry entry = { .index = count, .length = (int)length };
+            ok = fwrite(&entry, sizeof(entry), 1, delta) == 1 &&
+                fwrite(block, 1, length, delta) == length;
+            *delta_crc = crc32c_update(*delta_crc, &entry, sizeof(entry));
+            *delta_crc = crc32c_update(*delta_crc, block, length);
+            (*changed)++;
+        }
+
+        count++;
+        *file_size += (long long)length;
+    }
+
+    ok = ok && !ferror(src);
+    fclose(src);
+    free(block);
+    if (!ok) {
+        free(*checksums);
+        *checksums = NULL;
+    }
+    return ok;
+}
+
+/*Writing the manifest that goes with a backup file (checksums NULL: whole-file CRC only)*/
+static bool save_block_manifest(const char* backup_path, const char* parent, int chain_length,
+    long long file_size, const unsigned long long* checksums, unsigned int file_crc, long long log_seq) {
+    BackupManifestHeader header = {
+        .magic = BACKUP_MANIFEST_MAGIC,
+        .version = BACKUP_FORMAT_VERSION,
+        .file_size = file_size,
+        .block_count = checksums ? (file_size + BACKUP_BLOCK_SIZE - 1) / BACKUP_BLOCK_SIZE : 0,
+        .block_size = checksums ? BACKUP_BLOCK_SIZE : 0,
+        .chain_length = chain_length,
+        .file_crc = file_crc,
+        .log_seq = log_seq
+    };
+    strncpy(header.name, path_basename(backup_path), BACKUP_NAME_LEN - 1);
+    if (parent) {
+        strncpy(header.parent, parent, BACKUP_NAME_LEN - 1);
+    }
+
+    char path[300];
+    manifest_path_for(backup_path, path, sizeof(path));
+    FILE* fptr = fopen(path, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 && (header.block_count == 0 ||
+        fwrite(checksums, sizeof(unsigned long long), (size_t)header.block_count, fptr) ==
+        (size_t)header.block_count);
+    if (fclose(fptr) != 0 || !ok) {
+        remove(path);
+        return false;
+    }
+    return true;
+}
+
+/*===== Configuration =====*/
+/*Reading the backup mode from backup.cfg*/
+BackupConfig load_backup_config() {
+    BackupConfig config = { .incremental = false, .max_chain = DEFAULT_MAX_CHAIN, .online = false };
+    FILE* fptr = fopen(BACKUP_CONFIG_FILE, "r");
+
+    if (fptr) {
+        char line[256];
+        int incremental = 0;
+        int online = 0;
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "incremental=%d", &incremental) == 1) {
+                config.incremental = (incremental != 0);
+                continue;
+            }
+            if (sscanf(line, "max_chain=%d", &config.max_chain) == 1) {
+                continue;
+            }
+            if (sscanf(line, "online=%d", &online) == 1) {
+                config.online = (online != 0);
+                continue;
+            }
+        }
+        fclose(fptr);
+    }
+
+    if (config.max_chain < 0 || config.max_chain > MAX_CHAIN_LIMIT) {
+        config.max_chain = DEFAULT_MAX_CHAIN;
+    }
+    return config;
+}
+
+/*===== Manifests =====*/
+/*Loading the block manifest of a backup file*/
+bool load_backup_manifest(const char* backup_path, BackupManifest* manifest) {
+    memset(manifest, 0, sizeof(BackupManifest));
+
+    char path[300];
+    manifest_path_for(backup_path, path, sizeof(path));
+    FILE* fptr = fopen(path, "rb");
+    if (!fptr) {
+        return false;
+    }
+
+    BackupManifestHeader* h = &manifest->header;
+    bool ok = fread(h, sizeof(BackupManifestHeader), 1, fptr) == 1 &&
+        h->magic == BACKUP_MANIFEST_MAGIC &&
+        h->version == BACKUP_FORMAT_VERSION &&
+        ((h->block_size == BACKUP_BLOCK_SIZE &&
+            h->block_count == (h->file_size + BACKUP_BLOCK_SIZE - 1) / BACKUP_BLOCK_SIZE) ||
+            (h->block_size == 0 && h->block_count == 0)) &&
+        h->block_count >= 0;
+    h->name[BACKUP_NAME_LEN - 1] = '\0';
+    h->parent[BACKUP_NAME_LEN - 1] = '\0';
+
+    if (ok && h->block_count > 0) {
+        manifest->checksums = malloc(h->block_count * sizeof(unsigned long long));
+        ok = manifest->checksums &&
+            fread(manifest->checksums, sizeof(unsigned long long), (size_t)h->block_count, fptr) ==
+            (size_t)h->block_count;
+    }
+    fclose(fptr);
+
+    if (!ok) {
+        free_backup_manifest(manifest);
+    }
+    return ok;
+}
+
+/*Loading the manifest of the newest catalogued backup, if its file still exists*/
+bool load_latest_manifest(BackupManifest* manifest) {
+    memset(manifest, 0, sizeof(BackupManifest));
+
+    /*The catalog lists backups oldest first*/
+    BackupCatalog* catalog = backup_catalog_get();
+    if (catalog->count == 0) {
+        return false;
+    }
+    const BackupEntry* latest = &catalog->entries[catalog->count - 1];
+    if (!load_backup_manifest(latest->path, manifest)) {
+        return false;
+    }
+    /*A checksum-only manifest cannot be diffed against*/
+    if (manifest->header.block_size == 0) {
+        free_backup_manifest(manifest);
+        return false;
+    }
+
+    /*The catalog can outlive a backup file deleted by hand*/
+    FILE* fptr = fopen(latest->path, "rb");
+    if (!fptr) {
+        free_backup_manifest(manifest);
+        return false;
+    }
+    fclose(fptr);
+    return true;
+}
+
+/*Writing the manifest of a full backup of inventory.dat (block checksums are optional)*/
+bool write_backup_manifest(const char* backup_path, unsigned int file_crc, bool with_blocks,
+    long long log_seq) {
+    if (!with_blocks) {
+        struct stat st;
+        if (stat(backup_path, &st) != 0) {
+            return false;
+        }
+        return save_block_manifest(backup_path, NULL, 0, (long long)st.st_size, NULL, file_crc, log_seq);
+    }
+
+    unsigned long long* checksums;
+    long long file_size;
+    if (!hash_inventory(&checksums, &file_size, NULL, NULL, NULL, NULL)) {
+        return false;
+    }
+    bool ok = save_block_manifest(backup_path, NULL, 0, file_size, checksums, file_crc, log_seq);
+    free(checksums);
+    return ok;
+}
+
+/*Writing the manifest of a full backup whose blocks were hashed by the caller*/
+bool save_backup_manifest(const char* backup_path, long long file_size,
+    const unsigned long long* checksums, unsigned int file_crc, long long log_seq) {
+    return save_block_manifest(backup_path, NULL, 0, file_size, checksums, file_crc, log_seq);
+}
+
+/*Deleting the manifest that goes with a backup file*/
+void remove_backup_manifest(const char* backup_path) {
+    char path[300];
+    manifest_path_for(backup_path, path, sizeof(path));
+    remove(path);
+}
+
+/*Checking a backup file against the CRC32C in its manifest (-1 if it has none)*/
+int verify_backup_checksum(const char* backup_path) {
+    BackupManifest manifest;
+    if (!load_backup_manifest(backup_path, &manifest)) {
+        return -1;
+    }
+    unsigned int stored = manifest.header.file_crc;
+    free_backup_manifest(&manifest);
+
+    /*A delta's checksum covers everything after its header*/
+    long long offset = is_delta_backup(backup_path) ? (long long)sizeof(DeltaHeader) : 0;
+    unsigned int actual;
+    if (!checksum_file(backup_path, offset, &actual)) {
+        return 0;
+    }
+    return actual == stored ? 1 : 0;
+}
+
+/*Formatting the stored checksum of a backup for display ("" if it has none)*/
+bool backup_checksum_string(const char* backup_path, char* out, size_t size) {
+    BackupManifest manifest;
+    out[0] = '\0';
+    if (!load_backup_manifest(backup_path, &manifest)) {
+        return false;
+    }
+    snprintf(out, size, BACKUP_CHECKSUM_FORMAT, manifest.header.file_crc);
+    free_backup_manifest(&manifest);
+    return true;
+}
+
+/*Releasing a loaded manifest*/
+void free_backup_manifest(BackupManifest* manifest) {
+    free(manifest->checksums);
+    memset(manifest, 0, sizeof(BackupManifest));
+}
+
+/*===== Delta backups =====*/
+/*Hashing one block (64-bit FNV-1a)*/
+unsigned long long backup_block_checksum(const void* block, size_t length) {
+    const unsigned char* data = (const unsigned char*)block;
+    unsigned long long h = 1469598103934665603ULL;
+    for (size_t i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/*Checking whether a backup file is a delta*/
+bool is_delta_backup(const char* path) {
+    const char* ext = strrchr(path, '.');
+    return ext && strcmp(ext, BACKUP_DELTA_EXT) == 0;
+}
+
+/*Writing only the blocks that changed since the parent backup*/
+bool create_delta_backup(const char* delta_path, const BackupManifest* parent, unsigned int* checksum,
+    long long log_seq) {
+    DeltaHeader header = {
+        .magic = BACKUP_DELTA_MAGIC,
+        .version = BACKUP_FORMAT_VERSION
+    };
+    strncpy(header.name, path_basename(delta_path), BACKUP_NAME_LEN - 1);
+    strncpy(header.parent, parent->header.name, BACKUP_NAME_LEN - 1);
+
+    FILE* fptr = fopen(delta_path, "wb");
+    if (!fptr) {
+        return false;
+    }
+
+    /*The header is rewritten once the changed blocks are known*/
+    unsigned long long* checksums = NULL;
+    unsigned int delta_crc = 0;
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        hash_inventory(&checksums, &header.file_size, fptr, parent, &header.changed_blocks,
+            &delta_crc) &&
+        backup_seek(fptr, 0, SEEK_SET) == 0 &&
+        fwrite(&header, sizeof(header), 1, fptr) == 1;
+    if (fclose(fptr) != 0) {
+        ok = false;
+    }
+
+    ok = ok && save_block_manifest(delta_path, parent->header.name,
+        parent->header.chain_length + 1, header.file_size, checksums, delta_crc, log_seq);
+    free(checksums);
+    if (!ok) {
+        remove(delta_path);
+    }
+    *checksum = delta_crc;
+    return ok;
+}
+
+/*Rebuilding a complete inventory file from a base backup plus its deltas*/
+bool rebuild_from_chain(const char* delta_path, const char* dest) {
+    /*Following parent links back to the full backup*/
+    char (*chain)[300] = malloc(MAX_CHAIN_LIMIT * sizeof(*chain));
+    int length = 0;
+    BackupManifest newest = { 0 };
+    BackupManifest m;
+    bool ok = chain != NULL;
+
+    if (ok) {
+        snprintf(chain[0], sizeof(chain[0]), "%s", delta_path);
+        length = 1;
+    }
+    while (ok) {
+        ok = load_backup_manifest(chain[length - 1], &m);
+        if (!ok) {
+            break;
+        }
+        bool full = (m.header.chain_length == 0);
+        char parent[BACKUP_NAME_LEN];
+        strncpy(parent, m.header.parent, BACKUP_NAME_LEN);
+        if (length == 1) {
+            newest = m; // Its checksums verify the rebuilt file
+        }
+        else {
+            free_backup_manifest(&m);
+        }
+        if (full) {
+            break;
+        }
+        ok = length < MAX_CHAIN_LIMIT;
+        if (ok) {
+            snprintf(chain[length], sizeof(chain[length]), "%s/%s", BACKUP_DIR, parent);
+            length++;
+        }
+    }
+    if (!ok) {
+        printf("Backup chain is incomplete: %s\n", length > 0 ? chain[length - 1] : delta_path);
+        free_backup_manifest(&newest);
+        free(chain);
+        return false;
+    }
+
+    /*chain[length - 1] is the base, chain[0] the newest delta*/
+    long long target_size = newest.header.file_size;
+    long long blocks = newest.header.block_count;
+    int deltas = length - 1;
+    int* source = malloc((blocks + 1) * sizeof(int));
+    long long* offset = malloc((blocks + 1) * sizeof(long long));
+    FILE** files = calloc(length, sizeof(FILE*));
+    ok = source && offset && files;
+    for (long long b = 0; ok && b < blocks; b++) {
+        source[b] = -1;
+    }
+
+    /*Oldest delta first, so newer copies of a block win*/
+    for (int k = deltas - 1; ok && k >= 0; k--) {
+        DeltaHeader header;
+        DeltaEntry entry;
+        files[k] = fopen(chain[k], "rb");
+        ok = files[k] && fread(&header, sizeof(header), 1, files[k]) == 1 &&
+            header.magic == BACKUP_DELTA_MAGIC && header.changed_blocks >= 0;
+        for (long long i = 0; ok && i < header.changed_blocks; i++) {
+            ok = fread(&entry, sizeof(entry), 1, files[k]) == 1 &&
+                entry.length > 0 && entry.length <= BACKUP_BLOCK_SIZE;
+            if (ok && entry.index >= 0 && entry.index < blocks) {
+                source[entry.index] = k;
+                offset[entry.index] = backup_tell(files[k]);
+            }
+            ok = ok && backup_seek(files[k], entry.length, SEEK_CUR) == 0;
+        }
+    }
+    if (ok) {
+        files[deltas] = fopen(chain[deltas], "rb");
+        ok = files[deltas] != NULL;
+    }
+
+    /*Writing the file block by block, checking each against the newest manifest*/
+    FILE* out = ok ? fopen(dest, "wb") : NULL;
+    unsigned char* block = malloc(BACKUP_BLOCK_SIZE);
+    ok = ok && out && block;
+    for (long long b = 0; ok && b < blocks; b++) {
+        long long remaining = target_size - b * BACKUP_BLOCK_SIZE;
+        size_t want = remaining < BACKUP_BLOCK_SIZE ? (size_t)remaining : BACKUP_BLOCK_SIZE;
+        FILE* from = source[b] >= 0 ? files[source[b]] : files[deltas];
+        long long position = source[b] >= 0 ? offset[b] : b * BACKUP_BLOCK_SIZE;
+
+        ok = backup_seek(from, position, SEEK_SET) == 0 &&
+            fread(block, 1, want, from) == want &&
+            backup_block_checksum(block, want) == newest.checksums[b] &&
+            fwrite(block, 1, want, out) == want;
+    }
+    if (out && fclose(out) != 0) {
+        ok = false;
+    }
+
+    for (int k = 0; files && k < length; k++) {
+        if (files[k]) {
+            fclose(files[k]);
+        }
+    }
+    free(files);
+    free(block);
+    free(source);
+    free(offset);
+    free_backup_manifest(&newest);
+    free(chain);
+    return ok;
+}
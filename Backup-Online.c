@@ -0,0 +1,201 @@
+#include "include/backup-online.h"
+#include "include/backup-restore.h"
+#include "include/backup-delta.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include "include/request-engine.h"
+#include "include/crc32c.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*One background snapshot backup*/
+typedef struct {
+    char path[256];
+    long long log_seq; // Log position the snapshot matches
+    long records; // Records captured
+    bool started;
+    bool threaded; // Running on its own thread (else it ran in the foreground)
+    bool done; // Set by the worker when the file is complete
+    bool success;
+    unsigned int checksum;
+    unsigned long long* block_checksums;
+    long long file_size;
+    double seconds;
+#ifndef _WIN32
+    pthread_t thread;
+    pthread_mutex_t lock; // Guards done
+#endif
+} OnlineBackup;
+
+static OnlineBackup job = {
+    .started = false,
+#ifndef _WIN32
+    .lock = PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/*===== Internal helpers =====*/
+/*Reading a monotonic clock in seconds*/
+static double online_clock() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/*Writing the snapshot block by block, hashing as it goes (runs on the worker thread)*/
+static void* snapshot_worker(void* arg) {
+    (void)arg;
+    double start = online_clock();
+    long long blocks = (job.records + BACKUP_BLOCK_RECORDS - 1) / BACKUP_BLOCK_RECORDS;
+
+    FILE* out = fopen(job.path, "wb");
+    Product* block = malloc(BACKUP_BLOCK_RECORDS * sizeof(Product));
+    job.block_checksums = malloc((blocks > 0 ? blocks : 1) * sizeof(unsigned long long));
+    bool ok = out && block && job.block_checksums;
+
+    for (long long b = 0; ok && b < blocks; b++) {
+        long first = (long)(b * BACKUP_BLOCK_RECORDS);
+        long n = job.records - first < BACKUP_BLOCK_RECORDS ? job.records - first : BACKUP_BLOCK_RECORDS;
+        size_t bytes = (size_t)n * sizeof(Product);
+
+        /*The lock is held only while one block is copied out*/
+        ok = store_snapshot_read(first, n, block) && fwrite(block, 1, bytes, out) == bytes;
+        job.checksum = crc32c_update(job.checksum, block, bytes);
+        job.block_checksums[b] = backup_block_checksum(block, bytes);
+        job.file_size += (long long)bytes;
+    }
+
+    if (out) {
+        ok = fflush(out) == 0 && ok;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(out)) == 0;
+#endif
+        ok = fclose(out) == 0 && ok;
+    }
+    free(block);
+    job.seconds = online_clock() - start;
+
+#ifndef _WIN32
+    pthread_mutex_lock(&job.lock);
+#endif
+    job.success = ok;
+    job.done = true;
+#ifndef _WIN32
+    pthread_mutex_unlock(&job.lock);
+#endif
+    return NULL;
+}
+
+/*Checking whether the worker has finished*/
+static bool worker_done() {
+#ifndef _WIN32
+    pthread_mutex_lock(&job.lock);
+    bool done = job.done;
+    pthread_mutex_unlock(&job.lock);
+    return done;
+#else
+    return job.done;
+#endif
+}
+
+/*Fixing the log position the snapshot matches (runs while the store is frozen)*/
+static void capture_log_position(void* context) {
+    engine_lock_shared_state();
+    log_commit();
+    *(long long*)context = log_record_count();
+    engine_unlock_shared_state();
+}
+
+/*Waiting for a running backup before the process exits*/
+static void online_backup_atexit() {
+    online_backup_finish(true);
+}
+
+/*===== Online backups =====*/
+/*Starting a snapshot backup that runs while the store keeps taking writes*/
+bool online_backup_start(const char* backup_path) {
+    long long log_seq = 0;
+    if (job.started || !store_snapshot_begin(capture_log_position, &log_seq)) {
+        return false;
+    }
+
+    free(job.block_checksums);
+    memset(job.path, 0, sizeof(job.path));
+    strncpy(job.path, backup_path, sizeof(job.path) - 1);
+    job.log_seq = log_seq;
+    job.records = store_snapshot_count();
+    job.done = false;
+    job.success = false;
+    job.checksum = 0;
+    job.block_checksums = NULL;
+    job.file_size = 0;
+    job.seconds = 0;
+    job.started = true;
+    job.threaded = false;
+
+    static bool atexit_registered = false;
+    if (!atexit_registered) {
+        atexit(online_backup_atexit);
+        atexit_registered = true;
+    }
+
+#ifndef _WIN32
+    if (pthread_create(&job.thread, NULL, snapshot_worker, NULL) == 0) {
+        job.threaded = true;
+        return true;
+    }
+#endif
+    /*No threads here (or none available): taking the snapshot in the foreground*/
+    snapshot_worker(NULL);
+    return true;
+}
+
+/*Checking whether a snapshot backup is in progress*/
+bool online_backup_running() {
+    return job.started && !worker_done();
+}
+
+/*Completing a finished backup: manifest, catalog, log, retention (wait blocks until done)*/
+OnlineBackupResult online_backup_finish(bool wait) {
+    if (!job.started || (!wait && !worker_done())) {
+        return ONLINE_BACKUP_IDLE;
+    }
+#ifndef _WIN32
+    if (job.threaded) {
+        pthread_join(job.thread, NULL);
+    }
+#endif
+    job.started = false;
+    store_snapshot_end();
+
+    if (!job.success) {
+        remove(job.path);
+        log_rotation_action(job.path, "Online backup failed");
+        return ONLINE_BACKUP_FAILED;
+    }
+
+    if (!save_backup_manifest(job.path, job.file_size, job.block_checksums, job.checksum, job.log_seq)) {
+        log_rotation_action(job.path, "Backup manifest not written");
+    }
+    free(job.block_checksums);
+    job.block_checksums = NULL;
+    catalog_backup(job.path, job.checksum, NULL);
+    log_backup(job.path, true);
+
+    printf("Online backup complete: %.1f MB in %.3f s (log position %lld)\n",
+        (double)job.file_size / (1024.0 * 1024.0), job.seconds, job.log_seq);
+
+    RetentionPolicy policy = load_retention_config();
+    enforce_retention_policy(&policy);
+    return ONLINE_BACKUP_DONE;
+}
@@ -1,9 +1,21 @@
 #include "include/backup-restore.h"
 #include "include/ui.h"
 #include "include/inventory.h"
+#include "include/storage-engine.h"
+#include "include/backup-delta.h"
+#include "include/backup-catalog.h"
+#include "include/backup-online.h"
+#include "include/file-copy.h"
+#include "include/transaction-log.h"
+#include "include/request-engine.h"
+#include "include/workload-trace.h"
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 /*=== Directory Management ===*/
 /*Function to check if backup directory exists*/
@@ -11,44 +23,14 @@ static void ensure_backup_dir_exists() {
     /*Creating backup directory if it doesn't exist*/
     struct stat st = { 0 };
     if (stat(BACKUP_DIR, &st) == -1) {
-        mkdir(BACKUP_DIR);
+#ifdef _WIN32
+        _mkdir(BACKUP_DIR);
+#else
+        mkdir(BACKUP_DIR, 0755);
+#endif
     }
 }
 
-/*Function to copy backup file*/
-bool copy_file(const char* src, const char* dest) {
-    /*Opening files*/
-    FILE* src_fptr = fopen(src, "rb");
-    FILE* dest_fptr = fopen(dest, "wb");
-
-    /*Checking if files are opened*/
-    if (!src_fptr || !dest_fptr) {
-        if (src_fptr) {
-            fclose(src_fptr);
-        }
-        if (dest_fptr) {
-            fclose(dest_fptr);
-        }
-        return false;
-    }
-
-    /*If successfull*/
-    bool success = true;
-    unsigned char buffer[4096];
-    size_t bytes;
-
-    while ((bytes = fread(buffer, 1, sizeof(buffer), src_fptr)) > 0) {
-        if (fwrite(buffer, 1, bytes, dest_fptr) != bytes) {
-            success = false;
-            break;
-        }
-    }
-
-    fclose(src_fptr);
-    fclose(dest_fptr);
-    return success;
-}
-
 /*Function to generate backup filename*/
 char* generate_backup_filename() {
     /*generating timestamp*/
@@ -141,33 +123,126 @@ void log_backup(const char* backup_path, bool success) {
 }
 
 
+/*Recording a finished backup in the catalog*/
+void catalog_backup(const char* backup_path, unsigned int checksum, const char* parent) {
+    BackupEntry entry = { 0 };
+    const char* slash = strrchr(backup_path, '/');
+    snprintf(entry.filename, sizeof(entry.filename), "%s", slash ? slash + 1 : backup_path);
+    snprintf(entry.path, sizeof(entry.path), "%s", backup_path);
+    snprintf(entry.checksum, sizeof(entry.checksum), BACKUP_CHECKSUM_FORMAT, checksum);
+    if (parent) {
+        snprintf(entry.parent, sizeof(entry.parent), "%s", parent);
+    }
+    entry.timestamp = get_backup_timestamp(entry.filename);
+    entry.file_size = (size_t)get_file_size(backup_path);
+    entry.is_valid = true;
+
+    if (!backup_catalog_add(&entry)) {
+        log_rotation_action(backup_path, "Catalog update failed");
+    }
+}
+
 /*=== Backup creation operations ===*/
-/*Function to create backup file*/
-bool create_backup() {
-    ensure_backup_dir_exists();
-    const char* backup_path = generate_backup_filename();
-    RetentionPolicy auto_policy = load_retention_config();
+/*Copying inventory.dat (whole or as a delta) with writers held off by the caller*/
+static bool copy_backup(char* backup_path, const BackupConfig* config) {
+    /*The backup will reflect exactly the log records written up to here*/
+    log_commit();
+    long long log_seq = log_record_count();
+
+    /*Flushing mapped changes so the copy sees a complete file*/
+    if (!store_checkpoint()) {
+        log_rotation_action(backup_path, "Store checkpoint failed");
+        return false;
+    }
 
-    /*Copying main inventory file*/
-    if (!copy_file(FILENAME, backup_path)) {
+    /*Incremental mode: only blocks changed since the newest backup*/
+    BackupManifest latest;
+    if (config->incremental && load_latest_manifest(&latest)) {
+        bool chain_full = latest.header.chain_length >= config->max_chain;
+        if (!chain_full) {
+            /*A second backup within the same second would overwrite its parent's manifest*/
+            char* ext = strrchr(backup_path, '.');
+            const char* name = strrchr(backup_path, '/') + 1;
+            bool same_stem = strncmp(latest.header.name, name, ext - name) == 0 &&
+                latest.header.name[ext - name] == '.';
+            strcpy(ext, BACKUP_DELTA_EXT);
+            unsigned int checksum;
+            bool created = !same_stem && create_delta_backup(backup_path, &latest, &checksum, log_seq);
+            if (created) {
+                catalog_backup(backup_path, checksum, latest.header.name);
+            }
+            free_backup_manifest(&latest);
+            if (!created) {
+                log_rotation_action(backup_path, "Incremental backup failed");
+                return false;
+            }
+            log_backup(backup_path, true);
+            return true;
+        }
+        free_backup_manifest(&latest);
+    }
+
+    /*Copying main inventory file, hashing it on the way through*/
+    unsigned int checksum;
+    if (!copy_file_checked(FILENAME, backup_path, &checksum)) {
         log_rotation_action(backup_path, "Backup creation failed");
         return false;
     }
+    report_copy_throughput("Backup copy");
 
-    /*Validating the backup*/
-    if (!validate_backup(backup_path)) {
-        log_rotation_action(backup_path, "Validation failed");
-        remove(backup_path);
-        return false;
+    /*The manifest keeps the checksum; block checksums let the next incremental find changes*/
+    if (!write_backup_manifest(backup_path, checksum, config->incremental, log_seq)) {
+        log_rotation_action(backup_path, "Backup manifest not written");
     }
+    catalog_backup(backup_path, checksum, NULL);
 
     /*Logging successful backup*/
     log_backup(backup_path, true);
+    return true;
+}
+
+/*Function to take a full, incremental or online backup*/
+static bool take_backup() {
+    ensure_backup_dir_exists();
+    char backup_path[256];
+    snprintf(backup_path, sizeof(backup_path), "%s", generate_backup_filename());
+    RetentionPolicy auto_policy = load_retention_config();
+    BackupConfig config = load_backup_config();
+
+    /*One snapshot at a time: a previous online backup is completed first*/
+    online_backup_finish(true);
+
+    /*Loading the catalog first, so a first-run directory scan does not pick up this backup*/
+    backup_catalog_get();
+
+    /*Online mode: a copy-on-write snapshot is written by a background thread*/
+    if (config.online) {
+        if (!online_backup_start(backup_path)) {
+            log_rotation_action(backup_path, "Online backup could not start");
+            return false;
+        }
+        printf("Backup running in the background: %s\n", backup_path);
+        return true;
+    }
+
+    /*Offline mode: no change may land between fixing the log position and copying the file*/
+    engine_lock_catalog(true);
+    bool created = copy_backup(backup_path, &config);
+    engine_unlock_catalog();
 
     /*Applying retention policy after successful backup*/
-    enforce_retention_policy(&auto_policy);
+    if (created) {
+        enforce_retention_policy(&auto_policy);
+    }
+    return created;
+}
 
-    return true;
+/*Function to create backup file*/
+bool create_backup() {
+    long long traced = trace_begin();
+    bool created = take_backup();
+    trace_end(TRACE_BACKUP, traced, 0, 0, NULL, created);
+    return created;
 }
 
 
@@ -179,106 +254,96 @@ int compare_backup_entries(const void* a, const void* b) {
     return entry_a->timestamp - entry_b->timestamp;
 }
 
-/*Listing available backups*/
+/*Listing available backups (from the catalog, oldest first)*/
 void list_backups() {
-    DIR* dir;
-    struct dirent* ent;
-    BackupEntry backups[100];
-    int count = 0;
-
-    if ((dir = opendir(BACKUP_DIR)) != NULL) {
-        while ((ent = readdir(dir)) != NULL && count < 100) {
-            if (strstr(ent->d_name, ".bak")) {
-                // Manual timestamp parsing
-                struct tm tm = { 0 };
-                char* ptr = ent->d_name;
-
-                // Skip "inventory_" prefix
-                if (strncmp(ptr, "inventory_", 10) != 0) continue;
-                ptr += 10;
-
-                // Parse YYYYMMDD_HHMMSS format
-                if (sscanf(ptr, "%4d%2d%2d_%2d%2d%2d",
-                    &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
-                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec) == 6) {
-
-                    tm.tm_year -= 1900;  // tm_year starts from 1900
-                    tm.tm_mon -= 1;     // tm_mon is 0-11
-                    backups[count].timestamp = mktime(&tm);
-
-                    strncpy(backups[count].path, ent->d_name, 255);
-                    count++;
-                }
-            }
-        }
-        closedir(dir);
-
-        // Rest of the function remains the same
-        qsort(backups, count, sizeof(BackupEntry), compare_backup_entries);
-        printf("\nAvailable Backups:\n");
-        for (int i = 0; i < count; i++) {
-            char date[20];
-            strftime(date, 20, "%Y-%m-%d %H:%M:%S", localtime(&backups[i].timestamp));
-            printf("%2d. %s\n", i + 1, date);
-        }
-    }
-    else {
+    BackupCatalog* catalog = backup_catalog_get();
+    if (catalog->count == 0) {
         printf("\nNo backups found!\n");
+        return;
     }
-}
-
-/*Creating safety backup system*/
-char* create_safety_backup() {
-    static char safety_path[256];
-    snprintf(safety_path, sizeof(safety_path), "%s/%s", BACKUP_DIR, SAFETY_BACKUP);
 
-    if (copy_file(FILENAME, safety_path)) {
-        return safety_path;
+    printf("\nAvailable Backups:\n");
+    for (int i = 0; i < catalog->count; i++) {
+        const BackupEntry* e = &catalog->entries[i];
+        char date[20];
+        strftime(date, 20, "%Y-%m-%d %H:%M:%S", localtime(&e->timestamp));
+        printf("%2d. %s%s%s%s\n", i + 1, date,
+            e->parent[0] ? " (incremental)" : "",
+            e->is_valid ? "  " : "", e->is_valid ? e->checksum : "");
     }
-    return NULL;
 }
 
-bool restore_from_safety() {
-    char safety_path[256];
-    snprintf(safety_path, sizeof(safety_path), "%s/%s", BACKUP_DIR, SAFETY_BACKUP);
+/*Copying a full backup beside inventory.dat, checked against its stored CRC32C in the same pass*/
+static bool copy_full_backup(const char* backup_path) {
+    BackupManifest manifest;
+    bool has_crc = load_backup_manifest(backup_path, &manifest);
+    unsigned int stored = has_crc ? manifest.header.file_crc : 0;
+    if (has_crc) {
+        free_backup_manifest(&manifest);
+    }
 
-    if (access(safety_path, F_OK) == 0) {
-        return copy_file(safety_path, FILENAME);
+    unsigned int actual;
+    if (!copy_file_checked(backup_path, RESTORE_TEMP_FILE, &actual)) {
+        printf("Restoration failed! Inventory left unchanged.\n");
+        return false;
     }
-    return false;
+    report_copy_throughput("Restore copy");
+
+    /*Without a manifest, falling back to a record sanity scan of the copy*/
+    if (has_crc ? actual != stored : !validate_backup_integrity(RESTORE_TEMP_FILE)) {
+        printf("Backup failed its integrity check, not restoring: %s\n", backup_path);
+        return false;
+    }
+    return true;
 }
 
 /*Core restoration logic*/
 bool restore_backup(const char* backup_path) {
-    /*Creating safety net*/
-    char* safety = create_safety_backup();
-    if (!safety) {
-        printf("Failed to create safety backup!\n");
-        return false;
+    /*A background snapshot must not be reading the file about to be replaced*/
+    online_backup_finish(true);
+
+    /*Building the restored file beside inventory.dat (deltas are rebuilt block by block, each one checked)*/
+    bool restored;
+    if (is_delta_backup(backup_path)) {
+        restored = rebuild_from_chain(backup_path, RESTORE_TEMP_FILE);
+        if (!restored) {
+            printf("Restoration failed! Inventory left unchanged.\n");
+        }
     }
-
-    /*Performing restoration*/
-    if (!copy_file(backup_path, FILENAME)) {
-        printf("Restoration failed! Reverting to safety backup.\n");
-        restore_from_safety();
-        remove(safety);
+    else {
+        restored = copy_full_backup(backup_path);
+    }
+    if (!restored) {
+        remove(RESTORE_TEMP_FILE);
         return false;
     }
 
-    /*Validating restored file*/
-    if (!validate_backup_integrity(FILENAME)) {
-        printf("Validation failed! Reverting...\n");
-        remove(safety);
-        return false;
+    /*No request may touch the store between closing it and rebuilding the indexes*/
+    engine_lock_catalog(true);
+
+    /*Releasing the store (which empties its WAL), then swapping the file in with one rename*/
+    store_close();
+    bool installed = install_file(RESTORE_TEMP_FILE, FILENAME);
+    if (!installed) {
+        printf("Failed to replace %s!\n", FILENAME);
+        remove(RESTORE_TEMP_FILE);
     }
 
-    /*Cleaning up*/
-    remove(safety);
-    return true;
+    /*Indexes and statistics change with the file contents*/
+    inventory_reload();
+    engine_unlock_catalog();
+    return installed;
 }
 
 /*Validating backup integrity*/
 bool validate_backup_integrity(const char* path) {
+    /*A stored CRC32C proves the file is byte-for-byte what was backed up*/
+    int verified = verify_backup_checksum(path);
+    if (verified >= 0 || is_delta_backup(path)) {
+        return verified == 1; // Deltas are also checked block by block when rebuilt
+    }
+
+    /*Without a manifest, falling back to a record sanity scan*/
     /*Opening file*/
     FILE* fptr = fopen(path, "rb");
     if (!fptr) {
@@ -287,6 +352,10 @@ bool validate_backup_integrity(const char* path) {
     /*Validating structure size*/
     Product p;
     while (fread(&p, sizeof(Product), 1, fptr)) {
+        /*Deleted records are kept as tombstones*/
+        if (p.id == TOMBSTONE_ID) {
+            continue;
+        }
         if (p.id <= 0 || p.price < 0 || p.quantity < 0) {
             fclose(fptr);
             return false;
@@ -303,8 +372,8 @@ time_t get_backup_timestamp(const char* filename) {
     int year, month, day, hour, min, sec;
 
     /*Parsing filename format*/
-    if (sscanf(filename, "inventory_%4d%2d%2d_%2d%2d%2d.bak",
-        &year, &month, &day, &hour, &min, &sec) == 6) {
+    if (sscanf(filename, "inventory_%4d%2d%2d_%2d%2d%2d",
+        &year, &month, &day, &hour, &min, &sec) != 6) {
         return (time_t)-1;
     }
 
@@ -318,33 +387,44 @@ time_t get_backup_timestamp(const char* filename) {
     return mktime(&tm);
 }
 
-/*Sorting backups by scanning backup directory*/
+/*Getting every catalogued backup, oldest first*/
 BackupEntry* list_backups_sorted(int* count) {
-    /*opening diractory*/
-    DIR* dir;
-    struct dirent* ent;
-    static BackupEntry backups[MAX_BACKUPS];
-    *count = 0;
-
-    /*Scanning directory*/
-    if ((dir = opendir(BACKUP_DIR)) != NULL) {
-        while ((ent = readdir(dir)) != NULL && *count < MAX_BACKUPS) {
-            if (strstr(ent->d_name, ".bak")) {
-                time_t t = get_backup_timestamp(ent->d_name);
-                if (t != (time_t)-1) {
-                    strncpy(backups[*count].path, ent->d_name, 255);
-                    backups[*count].timestamp = t;
-                    (*count)++;
-                }
+    BackupCatalog* catalog = backup_catalog_get();
+    *count = catalog->count;
+    return catalog->entries;
+}
+
+/*Getting a backup by its number in list_backups() (NULL if out of range)*/
+const BackupEntry* get_backup_entry(int number) {
+    BackupCatalog* catalog = backup_catalog_get();
+    if (number < 1 || number > catalog->count) {
+        return NULL;
+    }
+    return &catalog->entries[number - 1];
+}
+
+/*Deleting the backups not marked keep, sparing any base a kept delta still needs*/
+static void prune_backups(bool* keep, int total) {
+    BackupCatalog* catalog = backup_catalog_get();
+
+    /*Newest first, so keeping a delta keeps its whole chain*/
+    for (int i = total - 1; i >= 0; i--) {
+        if (keep[i] && catalog->entries[i].parent[0]) {
+            int parent = backup_catalog_find(catalog->entries[i].parent);
+            if (parent >= 0) {
+                keep[parent] = true;
             }
         }
-        closedir(dir);
-
-        /*Sorting oldest first*/
-        qsort(backups, *count, sizeof(BackupEntry), compare_backup_entries);
     }
 
-    return backups;
+    /*Deleting from the end keeps the remaining indexes stable*/
+    for (int i = total - 1; i >= 0; i--) {
+        if (!keep[i]) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s", catalog->entries[i].path);
+            delete_backup_safely(path);
+        }
+    }
 }
 
 /*Readng config file for retention*/
@@ -372,13 +452,20 @@ RetentionPolicy load_retention_config() {
 /*Deleting old backups by count*/
 void delete_old_backups_by_count(int max_count) {
     int total = 0;
-    BackupEntry* backups = list_backups_sorted(&total);
+    list_backups_sorted(&total);
+    if (total <= max_count) {
+        return;
+    }
 
-    for (int i = 0; i < total - max_count; i++) {
-        char full_path[289];
-        snprintf(full_path, sizeof(full_path), "%s / %s", BACKUP_DIR, backups[i].path);
-        delete_backup_safely(full_path);
+    bool* keep = malloc(total * sizeof(bool));
+    if (!keep) {
+        return;
     }
+    for (int i = 0; i < total; i++) {
+        keep[i] = i >= total - max_count;
+    }
+    prune_backups(keep, total);
+    free(keep);
 }
 
 /*Deleting old backups by age*/
@@ -386,16 +473,19 @@ void delete_old_backups_by_age(int max_days) {
     time_t now = time(NULL);
     int total = 0;
     BackupEntry* backups = list_backups_sorted(&total);
+    if (total == 0 || difftime(now, backups[0].timestamp) / (60 * 60 * 24) <= max_days) {
+        return; // Even the oldest is young enough
+    }
 
+    bool* keep = malloc(total * sizeof(bool));
+    if (!keep) {
+        return;
+    }
     for (int i = 0; i < total; i++) {
-        double age_days = difftime(now, backups[i].timestamp) / (60 * 60 * 24);
-
-        if (age_days > max_days) {
-            char full_path[278];
-            snprintf(full_path, sizeof(full_path), "%s / %s", BACKUP_DIR, backups[i].path);
-            delete_backup_safely(full_path);
-        }
+        keep[i] = difftime(now, backups[i].timestamp) / (60 * 60 * 24) <= max_days;
     }
+    prune_backups(keep, total);
+    free(keep);
 }
 
 /*Enforcing retention policies*/
@@ -415,7 +505,12 @@ void enforce_retention_policy(const RetentionPolicy* policy) {
 /*Utility functions*/
 /*Deleting backup safely*/
 void delete_backup_safely(const char* path) {
-    if (remove(path) == 0) {
+    const char* slash = strrchr(path, '/');
+    const char* name = slash ? slash + 1 : path;
+
+    if (remove(path) == 0 || errno == ENOENT) {
+        remove_backup_manifest(path);
+        backup_catalog_remove(name);
         log_rotation_action(path, "Deleted by retention policy");
     }
     else {
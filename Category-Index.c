@@ -0,0 +1,245 @@
+#include "include/category-index.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*Global category dictionary (IDs stay stable for the whole process)*/
+static CategoryIndex categories = { 0 };
+
+/*===== Internal helpers =====*/
+/*Hashing a category name (FNV-1a over the fixed-width field)*/
+static unsigned int category_hash(const char* name) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < MAX_CATEGORY_LEN - 1 && name[i]; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*Rehashing every name into a table of the given size*/
+static bool category_rehash(int table_size) {
+    int* table = malloc(table_size * sizeof(int));
+    if (!table) {
+        return false;
+    }
+    for (int i = 0; i < table_size; i++) {
+        table[i] = -1;
+    }
+    for (int id = 0; id < categories.count; id++) {
+        unsigned int i = category_hash(categories.entries[id].name) & (table_size - 1);
+        while (table[i] != -1) {
+            i = (i + 1) & (table_size - 1);
+        }
+        table[i] = id;
+    }
+    free(categories.table);
+    categories.table = table;
+    categories.table_size = table_size;
+    return true;
+}
+
+/*Growing the per-slot arrays so slot fits*/
+static bool ensure_slot_capacity(long slot) {
+    if (slot < categories.slot_capacity) {
+        return true;
+    }
+
+    long new_capacity = categories.slot_capacity ? categories.slot_capacity : 1024;
+    while (new_capacity <= slot) {
+        new_capacity *= 2;
+    }
+
+    int* slot_category = realloc(categories.slot_category, new_capacity * sizeof(int));
+    if (!slot_category) {
+        return false;
+    }
+    categories.slot_category = slot_category;
+    long* slot_position = realloc(categories.slot_position, new_capacity * sizeof(long));
+    if (!slot_position) {
+        return false;
+    }
+    categories.slot_position = slot_position;
+
+    for (long i = categories.slot_capacity; i < new_capacity; i++) {
+        categories.slot_category[i] = -1;
+    }
+    categories.slot_capacity = new_capacity;
+    return true;
+}
+
+/*Filing a slot under a category*/
+static void posting_add(int category_id, long slot) {
+    if (category_id < 0 || !ensure_slot_capacity(slot)) {
+        return;
+    }
+    CategoryEntry* c = &categories.entries[category_id];
+    if (c->count == c->capacity) {
+        long new_capacity = c->capacity ? c->capacity * 2 : 16;
+        long* slots = realloc(c->slots, new_capacity * sizeof(long));
+        if (!slots) {
+            return;
+        }
+        c->slots = slots;
+        c->capacity = new_capacity;
+    }
+    categories.slot_category[slot] = category_id;
+    categories.slot_position[slot] = c->count;
+    c->slots[c->count++] = slot;
+}
+
+/*Removing a slot from its posting list (swap with the last entry)*/
+static void posting_remove(long slot) {
+    if (slot >= categories.slot_capacity || categories.slot_category[slot] == -1) {
+        return;
+    }
+    CategoryEntry* c = &categories.entries[categories.slot_category[slot]];
+    long pos = categories.slot_position[slot];
+    long last = c->slots[--c->count];
+    c->slots[pos] = last;
+    categories.slot_position[last] = pos;
+    categories.slot_category[slot] = -1;
+}
+
+/*Looking a name up in the dictionary as it stands (-1 if absent)*/
+static int dictionary_find(const char* name) {
+    if (categories.table_size == 0) {
+        return -1;
+    }
+    unsigned int i = category_hash(name) & (categories.table_size - 1);
+    while (categories.table[i] != -1) {
+        int id = categories.table[i];
+        if (strncmp(categories.entries[id].name, name, MAX_CATEGORY_LEN - 1) == 0) {
+            return id;
+        }
+        i = (i + 1) & (categories.table_size - 1);
+    }
+    return -1;
+}
+
+/*===== Dictionary =====*/
+/*Getting the ID of a category, adding it if new (-1 on failure)*/
+int category_intern(const char* name) {
+    int id = dictionary_find(name);
+    if (id != -1) {
+        return id;
+    }
+
+    /*Keeping the hash table at most half full*/
+    if ((categories.count + 1) * 2 > categories.table_size) {
+        int size = categories.table_size ? categories.table_size * 2 : CATEGORY_TABLE_INITIAL;
+        if (!category_rehash(size)) {
+            return -1;
+        }
+    }
+    if (categories.count == categories.capacity) {
+        int new_capacity = categories.capacity ? categories.capacity * 2 : 16;
+        CategoryEntry* entries = realloc(categories.entries, new_capacity * sizeof(CategoryEntry));
+        if (!entries) {
+            return -1;
+        }
+        categories.entries = entries;
+        categories.capacity = new_capacity;
+    }
+
+    id = categories.count++;
+    CategoryEntry* c = &categories.entries[id];
+    memset(c, 0, sizeof(CategoryEntry));
+    strncpy(c->name, name, MAX_CATEGORY_LEN - 1);
+
+    unsigned int i = category_hash(c->name) & (categories.table_size - 1);
+    while (categories.table[i] != -1) {
+        i = (i + 1) & (categories.table_size - 1);
+    }
+    categories.table[i] = id;
+    return id;
+}
+
+/*Looking up the ID of a category (-1 if not in the store)*/
+int category_find(const char* name) {
+    int id = dictionary_find(name);
+    /*After a reload the dictionary starts empty: a miss is only final once the store was scanned*/
+    if (id == -1 && !categories.built && category_index_build()) {
+        id = dictionary_find(name);
+    }
+    return id;
+}
+
+/*Getting the name of a category ID*/
+const char* category_name(int category_id) {
+    if (category_id < 0 || category_id >= categories.count) {
+        return NULL;
+    }
+    return categories.entries[category_id].name;
+}
+
+/*Getting the number of interned categories*/
+int category_total() {
+    return categories.count;
+}
+
+/*===== Posting lists =====*/
+/*Filing every live record under its category (keeps the dictionary)*/
+bool category_index_build() {
+    for (int id = 0; id < categories.count; id++) {
+        categories.entries[id].count = 0;
+    }
+    for (long i = 0; i < categories.slot_capacity; i++) {
+        categories.slot_category[i] = -1;
+    }
+
+    long records = store_count();
+    if (records > 0 && !ensure_slot_capacity(records - 1)) {
+        return false;
+    }
+    for (long slot = 0; slot < records; slot++) {
+        const Product* p = store_record(slot);
+        if (store_is_live(p)) {
+            posting_add(category_intern(p->category), slot);
+        }
+    }
+
+    categories.built = true;
+    return true;
+}
+
+/*Forgetting every category (only when inventory.dat is replaced)*/
+void category_index_reset() {
+    for (int id = 0; id < categories.count; id++) {
+        free(categories.entries[id].slots);
+    }
+    free(categories.entries);
+    free(categories.table);
+    free(categories.slot_category);
+    free(categories.slot_position);
+    memset(&categories, 0, sizeof(categories));
+}
+
+/*Refiling a slot when its category changes*/
+void category_index_update(long slot, const Product* before, const Product* after) {
+    if (!categories.built) {
+        return; // Built from the store on next query
+    }
+    if (before && after && strncmp(before->category, after->category, MAX_CATEGORY_LEN) == 0) {
+        return;
+    }
+    posting_remove(slot);
+    if (after) {
+        posting_add(category_intern(after->category), slot);
+    }
+}
+
+/*Getting the slots filed under a category (count, -1 on failure)*/
+long category_postings(int category_id, const long** slots) {
+    *slots = NULL;
+    if (!categories.built && !category_index_build()) {
+        return -1;
+    }
+    if (category_id < 0 || category_id >= categories.count) {
+        return 0;
+    }
+    *slots = categories.entries[category_id].slots;
+    return categories.entries[category_id].count;
+}
@@ -0,0 +1,297 @@
+#include "include/column-snapshot.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include "include/category-index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*SIMD kernels: SSE2 is the x86-64 baseline, AVX2 is picked at run time with GCC/Clang*/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLUMN_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLUMN_SSE2 1
+#endif
+
+/*Global snapshot (built on first use, then kept in step with the store)*/
+static ColumnSnapshot columns = { 0 };
+
+/*===== Internal helpers =====*/
+/*Growing every column so slot fits*/
+static bool ensure_column_capacity(ColumnSnapshot* snap, long slot) {
+    if (slot < snap->capacity) {
+        return true;
+    }
+
+    long new_capacity = snap->capacity ? snap->capacity : 1024;
+    while (new_capacity <= slot) {
+        new_capacity *= 2;
+    }
+
+    int* id = realloc(snap->id, new_capacity * sizeof(int));
+    if (!id) {
+        return false;
+    }
+    snap->id = id;
+    float* price = realloc(snap->price, new_capacity * sizeof(float));
+    if (!price) {
+        return false;
+    }
+    snap->price = price;
+    int* quantity = realloc(snap->quantity, new_capacity * sizeof(int));
+    if (!quantity) {
+        return false;
+    }
+    snap->quantity = quantity;
+    int* category_id = realloc(snap->category_id, new_capacity * sizeof(int));
+    if (!category_id) {
+        return false;
+    }
+    snap->category_id = category_id;
+
+    snap->capacity = new_capacity;
+    return true;
+}
+
+/*Writing one slot from a record (NULL or a tombstone marks it dead)*/
+static void set_slot(ColumnSnapshot* snap, long slot, const Product* p) {
+    if (p && store_is_live(p)) {
+        snap->id[slot] = p->id;
+        snap->price[slot] = p->price;
+        snap->quantity[slot] = p->quantity;
+        snap->category_id[slot] = category_intern(p->category);
+    }
+    else {
+        snap->id[slot] = TOMBSTONE_ID;
+        snap->price[slot] = 0.0f;
+        snap->quantity[slot] = COLUMN_DEAD_QUANTITY;
+        snap->category_id[slot] = COLUMN_DEAD_CATEGORY;
+    }
+}
+
+/*===== Snapshot lifecycle =====*/
+/*Copying the numeric fields of every slot with one scan of the store*/
+bool column_snapshot_build(ColumnSnapshot* snap) {
+    long records = store_count();
+    snap->count = 0;
+    snap->built = false;
+    if (records > 0 && !ensure_column_capacity(snap, records - 1)) {
+        return false;
+    }
+    for (long slot = 0; slot < records; slot++) {
+        set_slot(snap, slot, store_record(slot));
+    }
+    snap->count = records;
+    snap->built = true;
+    return true;
+}
+
+/*Releasing the columns of a snapshot*/
+void column_snapshot_free(ColumnSnapshot* snap) {
+    free(snap->id);
+    free(snap->price);
+    free(snap->quantity);
+    free(snap->category_id);
+    memset(snap, 0, sizeof(ColumnSnapshot));
+}
+
+/*Getting the maintained snapshot (NULL if it cannot be built)*/
+const ColumnSnapshot* column_snapshot_get() {
+    if (!columns.built && !column_snapshot_build(&columns)) {
+        return NULL;
+    }
+    return &columns;
+}
+
+/*Dropping the snapshot so the next use rebuilds it*/
+void column_snapshot_reset() {
+    column_snapshot_free(&columns);
+}
+
+/*Refreshing the slot a record change touched*/
+void column_snapshot_update(long slot, const Product* before, const Product* after) {
+    (void)before;
+    if (!columns.built) {
+        return; // Built from the store on next use
+    }
+    if (!ensure_column_capacity(&columns, slot)) {
+        column_snapshot_reset();
+        return;
+    }
+
+    /*Appended slots past the old end start out dead*/
+    while (columns.count <= slot) {
+        set_slot(&columns, columns.count++, NULL);
+    }
+    set_slot(&columns, slot, after);
+}
+
+/*===== Aggregate kernels =====*/
+#ifdef COLUMN_AVX2
+/*Checking once whether the CPU has AVX2*/
+static bool has_avx2() {
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+/*Summing price * quantity eight slots at a time (*done: slots covered)*/
+__attribute__((target("avx2")))
+static double total_value_avx2(const float* price, const int* quantity, long n, long* done) {
+    __m256d acc_lo = _mm256_setzero_pd();
+    __m256d acc_hi = _mm256_setzero_pd();
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 p = _mm256_loadu_ps(&price[i]);
+        __m256i q = _mm256_loadu_si256((const __m256i*)&quantity[i]);
+        acc_lo = _mm256_add_pd(acc_lo, _mm256_mul_pd(
+            _mm256_cvtps_pd(_mm256_castps256_ps128(p)),
+            _mm256_cvtepi32_pd(_mm256_castsi256_si128(q))));
+        acc_hi = _mm256_add_pd(acc_hi, _mm256_mul_pd(
+            _mm256_cvtps_pd(_mm256_extractf128_ps(p, 1)),
+            _mm256_cvtepi32_pd(_mm256_extracti128_si256(q, 1))));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc_lo, acc_hi));
+    *done = i;
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+/*Counting lo <= quantity < hi eight slots at a time (*done: slots covered)*/
+__attribute__((target("avx2")))
+static long count_range_avx2(const int* quantity, long n, int lo, int hi, long* done) {
+    __m256i lo_v = _mm256_set1_epi32(lo);
+    __m256i hi_v = _mm256_set1_epi32(hi);
+    __m256i acc = _mm256_setzero_si256();
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i q = _mm256_loadu_si256((const __m256i*)&quantity[i]);
+        /*In range: not (lo > q) and (hi > q); matching lanes are -1*/
+        __m256i in = _mm256_andnot_si256(_mm256_cmpgt_epi32(lo_v, q),
+            _mm256_cmpgt_epi32(hi_v, q));
+        acc = _mm256_sub_epi32(acc, in);
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    long count = 0;
+    for (int k = 0; k < 8; k++) {
+        count += lanes[k];
+    }
+    *done = i;
+    return count;
+}
+#endif
+
+#ifdef COLUMN_SSE2
+/*Summing price * quantity four slots at a time (*done: slots covered)*/
+static double total_value_sse2(const float* price, const int* quantity, long n, long* done) {
+    __m128d acc_lo = _mm_setzero_pd();
+    __m128d acc_hi = _mm_setzero_pd();
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 p = _mm_loadu_ps(&price[i]);
+        __m128i q = _mm_loadu_si128((const __m128i*)&quantity[i]);
+        acc_lo = _mm_add_pd(acc_lo, _mm_mul_pd(
+            _mm_cvtps_pd(p), _mm_cvtepi32_pd(q)));
+        acc_hi = _mm_add_pd(acc_hi, _mm_mul_pd(
+            _mm_cvtps_pd(_mm_movehl_ps(p, p)),
+            _mm_cvtepi32_pd(_mm_shuffle_epi32(q, _MM_SHUFFLE(1, 0, 3, 2)))));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc_lo, acc_hi));
+    *done = i;
+    return lanes[0] + lanes[1];
+}
+
+/*Counting lo <= quantity < hi four slots at a time (*done: slots covered)*/
+static long count_range_sse2(const int* quantity, long n, int lo, int hi, long* done) {
+    __m128i lo_v = _mm_set1_epi32(lo);
+    __m128i hi_v = _mm_set1_epi32(hi);
+    __m128i acc = _mm_setzero_si128();
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i q = _mm_loadu_si128((const __m128i*)&quantity[i]);
+        __m128i in = _mm_andnot_si128(_mm_cmpgt_epi32(lo_v, q),
+            _mm_cmpgt_epi32(hi_v, q));
+        acc = _mm_sub_epi32(acc, in);
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    long count = 0;
+    for (int k = 0; k < 4; k++) {
+        count += lanes[k];
+    }
+    *done = i;
+    return count;
+}
+#endif
+
+/*Summing price * quantity over every slot (dead slots have price 0)*/
+double column_total_value(const ColumnSnapshot* snap) {
+    const float* price = snap->price;
+    const int* quantity = snap->quantity;
+    long n = snap->count;
+    long i = 0;
+    double total = 0.0;
+
+#ifdef COLUMN_AVX2
+    if (has_avx2()) {
+        total = total_value_avx2(price, quantity, n, &i);
+    }
+#endif
+#ifdef COLUMN_SSE2
+    if (i == 0) {
+        total = total_value_sse2(price, quantity, n, &i);
+    }
+#endif
+
+    /*Scalar tail (and the whole array without SIMD)*/
+    for (; i < n; i++) {
+        total += (double)price[i] * quantity[i];
+    }
+    return total;
+}
+
+/*Counting slots with lo <= quantity < hi (dead slots sit at INT_MAX)*/
+long column_count_range(const ColumnSnapshot* snap, int lo, int hi) {
+    const int* quantity = snap->quantity;
+    long n = snap->count;
+    long i = 0;
+    long count = 0;
+
+#ifdef COLUMN_AVX2
+    if (has_avx2()) {
+        count = count_range_avx2(quantity, n, lo, hi, &i);
+    }
+#endif
+#ifdef COLUMN_SSE2
+    if (i == 0) {
+        count = count_range_sse2(quantity, n, lo, hi, &i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        count += (quantity[i] >= lo && quantity[i] < hi);
+    }
+    return count;
+}
+
+/*Naming the kernel set in use (for diagnostics)*/
+const char* column_kernel_name() {
+#ifdef COLUMN_AVX2
+    if (has_avx2()) {
+        return "avx2";
+    }
+#endif
+#ifdef COLUMN_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
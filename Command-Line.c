@@ -0,0 +1,249 @@
+#include "include/command-line.h"
+#include "include/backup-restore.h"
+#include "include/csv-import.h"
+#include "include/data-export.h"
+#include "include/inventory.h"
+#include "include/request-engine.h"
+#include "include/transaction-log.h"
+#include "include/workload-trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*===== Internal helpers =====*/
+/*Printing the commands batch mode understands*/
+static void print_usage() {
+    printf("Usage: ims <command> [arguments]\n");
+    printf("  import <file> [--csv|--tsv]  Load a product catalogue (delimiter detected by default)\n");
+    printf("  sell <id> <quantity>         Record a sale\n");
+    printf("  restock <id> <quantity>      Record a restock\n");
+    printf("  export inventory|transactions <file|-> [--jsonl] [--from DATE] [--to DATE]\n");
+    printf("         [--category NAME] [--product ID]  Stream data as CSV or JSON Lines\n");
+    printf("  replay <trace> [--paced] [--speed X] [--max-gap-ms N] [--verbose]\n");
+    printf("         Drive a recorded workload (--verbose shows its output)\n");
+    printf("  report                       Print the inventory report\n");
+    printf("  backup                       Create a backup\n");
+    printf("  list-backups                 List existing backups\n");
+    printf("  help                         Show this text\n");
+    printf("Without a command the interactive menu starts.\n");
+    printf("ims --record <trace> [command] records the session's calls for replay.\n");
+}
+
+/*Parsing a positive integer argument*/
+static bool parse_count_arg(const char* s, int* out) {
+    char* end;
+    long value = strtol(s, &end, 10);
+    if (end == s || *end != '\0' || value <= 0 || value > 1000000000L) {
+        return false;
+    }
+    *out = (int)value;
+    return true;
+}
+
+/*Parsing YYYY-MM-DD[ HH:MM:SS] as local time (start or end of the day without a time)*/
+static bool parse_date_arg(const char* s, bool end_of_day, time_t* out) {
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    int fields = sscanf(s, "%d-%d-%d %d:%d:%d", &date.tm_year, &date.tm_mon, &date.tm_mday,
+        &date.tm_hour, &date.tm_min, &date.tm_sec);
+    if (fields < 3) {
+        return false;
+    }
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    date.tm_isdst = -1;
+    if (fields < 5 && end_of_day) {
+        date.tm_hour = 23;
+        date.tm_min = 59;
+        date.tm_sec = 59;
+    }
+    *out = mktime(&date);
+    return *out != (time_t)-1;
+}
+
+/*Running a sale or restock given on the command line*/
+static int run_movement(TransactionType type, int argc, char* argv[]) {
+    StockMovement m;
+    memset(&m, 0, sizeof(m));
+    if (argc != 3 || !parse_count_arg(argv[1], &m.id) || !parse_count_arg(argv[2], &m.quantity)) {
+        printf("Usage: ims %s <id> <quantity>\n", argv[0]);
+        return 1;
+    }
+    m.type = type;
+
+    /*Served by an engine worker, exactly as a concurrent caller would be*/
+    bool moved = engine_move_stock(&m);
+    report_stock_movement(&m);
+    return moved ? 0 : 1;
+}
+
+/*Running an import given on the command line*/
+static int run_import(int argc, char* argv[]) {
+    char delimiter = 0;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            delimiter = ',';
+        }
+        else if (strcmp(argv[i], "--tsv") == 0) {
+            delimiter = '\t';
+        }
+        else if (!path) {
+            path = argv[i];
+        }
+        else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        printf("Usage: ims import <file> [--csv|--tsv]\n");
+        return 1;
+    }
+
+    ImportStats stats;
+    bool ok = import_products(path, delimiter, &stats);
+    report_import(&stats);
+    return (ok && stats.rejected == 0 && stats.duplicates == 0) ? 0 : 1;
+}
+
+/*Running an export given on the command line*/
+static int run_export(int argc, char* argv[]) {
+    ExportFilter filter;
+    export_filter_init(&filter);
+    bool usage = argc < 3 ||
+        (strcmp(argv[1], "inventory") != 0 && strcmp(argv[1], "transactions") != 0);
+
+    for (int i = 3; i < argc && !usage; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--jsonl") == 0) {
+            filter.format = EXPORT_JSONL;
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            filter.format = EXPORT_CSV;
+        }
+        else if (strcmp(argv[i], "--from") == 0 && has_value) {
+            usage = !parse_date_arg(argv[++i], false, &filter.from);
+        }
+        else if (strcmp(argv[i], "--to") == 0 && has_value) {
+            usage = !parse_date_arg(argv[++i], true, &filter.to);
+        }
+        else if (strcmp(argv[i], "--category") == 0 && has_value) {
+            filter.category = argv[++i];
+        }
+        else if (strcmp(argv[i], "--product") == 0 && has_value) {
+            usage = !parse_count_arg(argv[++i], &filter.product_id);
+        }
+        else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        printf("Usage: ims export inventory|transactions <file|-> [--jsonl] [--from DATE] [--to DATE]\n"
+            "                  [--category NAME] [--product ID]\n");
+        return 1;
+    }
+
+    ExportStats stats;
+    const char* path = argv[2];
+    bool ok = strcmp(argv[1], "inventory") == 0
+        ? export_inventory(path, &filter, &stats)
+        : export_transactions(path, &filter, &stats);
+    /*Standard output carries the data, so the summary stays off it*/
+    if (strcmp(path, EXPORT_STDOUT) != 0) {
+        report_export(&stats);
+    }
+    return ok ? 0 : 1;
+}
+
+/*Replaying a recorded workload given on the command line*/
+static int run_replay(int argc, char* argv[]) {
+    TraceReplayOptions options;
+    trace_replay_options_init(&options);
+    bool usage = argc < 2;
+    for (int i = 2; i < argc && !usage; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--paced") == 0) {
+            options.paced = true;
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            options.speed = strtod(argv[++i], NULL);
+            usage = !(options.speed > 0);
+        }
+        else if (strcmp(argv[i], "--max-gap-ms") == 0 && has_value) {
+            options.max_gap_ms = strtoll(argv[++i], NULL, 10);
+            usage = options.max_gap_ms < 0;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0) {
+            options.quiet = false;
+        }
+        else {
+            usage = true;
+        }
+    }
+    if (usage) {
+        printf("Usage: ims replay <trace> [--paced] [--speed X] [--max-gap-ms N] [--verbose]\n");
+        return 1;
+    }
+
+    /*Two histograms per operation are too large for the stack*/
+    TraceReplayStats* stats = malloc(sizeof(TraceReplayStats));
+    if (!stats) {
+        return 1;
+    }
+    bool ok = trace_replay(argv[1], &options, stats);
+    report_trace_replay(stats);
+    free(stats);
+    return ok ? 0 : 1;
+}
+
+/*===== Batch mode =====*/
+/*Running one command without the menu, returning the process exit status*/
+int run_command(int argc, char* argv[]) {
+    const char* command = argv[0];
+    if (strcmp(command, "help") == 0 || strcmp(command, "--help") == 0) {
+        print_usage();
+        return 0;
+    }
+
+    inventory_init();
+    /*Sales and restocks go through the worker pool (inline where it cannot start)*/
+    engine_start(load_engine_threads());
+    int status;
+    if (strcmp(command, "import") == 0) {
+        status = run_import(argc, argv);
+    }
+    else if (strcmp(command, "sell") == 0) {
+        status = run_movement(SALE, argc, argv);
+    }
+    else if (strcmp(command, "restock") == 0) {
+        status = run_movement(RESTOCK, argc, argv);
+    }
+    else if (strcmp(command, "export") == 0) {
+        status = run_export(argc, argv);
+    }
+    else if (strcmp(command, "replay") == 0) {
+        status = run_replay(argc, argv);
+    }
+    else if (strcmp(command, "report") == 0) {
+        generate_report();
+        status = 0;
+    }
+    else if (strcmp(command, "backup") == 0) {
+        status = create_backup() ? 0 : 1;
+    }
+    else if (strcmp(command, "list-backups") == 0) {
+        list_backups();
+        status = 0;
+    }
+    else {
+        printf("Unknown command: %s\n", command);
+        print_usage();
+        return 1;
+    }
+
+    engine_stop();
+    log_commit();
+    return status;
+}
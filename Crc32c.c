@@ -0,0 +1,147 @@
+#include "include/crc32c.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*Hardware CRC32C: SSE4.2 picked at run time with GCC/Clang on x86*/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define CRC32C_HW_X86 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_HW_ARM 1
+#endif
+
+/*Slicing-by-8 tables for the portable path*/
+static uint32_t crc_table[8][256];
+static bool crc_table_ready = false;
+
+/*===== Internal helpers =====*/
+/*Building the lookup tables on first use*/
+static void build_tables() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1)));
+        }
+        crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+        }
+    }
+    crc_table_ready = true;
+}
+
+/*Table-driven CRC, eight bytes per step*/
+static uint32_t crc_portable(uint32_t crc, const unsigned char* p, size_t length) {
+    if (!crc_table_ready) {
+        build_tables();
+    }
+    while (length >= 8) {
+        uint32_t lo;
+        uint32_t hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc; // Little-endian layout assumed, as elsewhere in the file formats
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^
+            crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24] ^
+            crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+            crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef CRC32C_HW_X86
+/*SSE4.2 CRC32 instruction, eight bytes per step*/
+__attribute__((target("sse4.2")))
+static uint32_t crc_sse42(uint32_t crc, const unsigned char* p, size_t length) {
+#ifdef __x86_64__
+    uint64_t c = crc;
+    while (length >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+        p += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)c;
+#endif
+    while (length >= 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        crc = _mm_crc32_u32(crc, v);
+        p += 4;
+        length -= 4;
+    }
+    while (length--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+/*Checking once whether the CPU has SSE4.2*/
+static bool has_sse42() {
+    static int supported = -1;
+    if (supported < 0) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+    }
+    return supported == 1;
+}
+#endif
+
+#ifdef CRC32C_HW_ARM
+/*ARMv8 CRC32C instructions*/
+static uint32_t crc_arm(uint32_t crc, const unsigned char* p, size_t length) {
+    while (length >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+/*===== Checksums =====*/
+/*Extending a running CRC32C (start from 0) with more data*/
+unsigned int crc32c_update(unsigned int crc, const void* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint32_t c = ~(uint32_t)crc;
+
+#if defined(CRC32C_HW_X86)
+    c = has_sse42() ? crc_sse42(c, p, length) : crc_portable(c, p, length);
+#elif defined(CRC32C_HW_ARM)
+    c = crc_arm(c, p, length);
+#else
+    c = crc_portable(c, p, length);
+#endif
+    return ~c;
+}
+
+/*CRC32C of one buffer*/
+unsigned int crc32c(const void* data, size_t length) {
+    return crc32c_update(0, data, length);
+}
+
+/*Naming the implementation in use (for diagnostics)*/
+const char* crc32c_impl_name() {
+#if defined(CRC32C_HW_X86)
+    return has_sse42() ? "sse4.2" : "table";
+#elif defined(CRC32C_HW_ARM)
+    return "armv8-crc";
+#else
+    return "table";
+#endif
+}
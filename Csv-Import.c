@@ -0,0 +1,405 @@
+#include "include/csv-import.h"
+#include "include/inventory.h"
+#include "include/transaction-log.h"
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*State of one streaming import*/
+typedef struct {
+    char delimiter;
+    int columns[COLUMN_COUNT]; // Field index of each column (-1 if absent)
+    bool mapped; // Columns known (from a header or the first row)
+    Product* batch; // Valid rows waiting for add_products()
+    int batch_count;
+    Product* unnumbered; // Rows that still need an ID, numbered after the whole file
+    long unnumbered_count;
+    long unnumbered_capacity;
+    bool out_of_memory;
+    long long line;
+    bool skipping; // Inside a line longer than a whole chunk
+    ImportStats* stats;
+} CsvImport;
+
+/*===== Internal helpers =====*/
+/*Reading a monotonic clock in seconds*/
+static double import_clock() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/*Stripping surrounding blanks in place*/
+static char* trim_field(char* s) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    size_t len = strlen(s);
+    while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\t')) {
+        s[--len] = '\0';
+    }
+    return s;
+}
+
+/*Splitting a line into fields in place, honouring double quotes ("" is a literal quote)*/
+static int split_fields(char* line, char delimiter, char** fields, int max_fields) {
+    int n = 0;
+    char* p = line;
+    while (n < max_fields) {
+        char* out = p;
+        fields[n++] = p;
+        if (*p == '"') {
+            p++;
+            while (*p) {
+                if (*p == '"' && p[1] == '"') {
+                    *out++ = '"';
+                    p += 2;
+                }
+                else if (*p == '"') {
+                    p++;
+                    break;
+                }
+                else {
+                    *out++ = *p++;
+                }
+            }
+            while (*p && *p != delimiter) {
+                p++; // Anything between the closing quote and the delimiter is dropped
+            }
+        }
+        else {
+            while (*p && *p != delimiter) {
+                *out++ = *p++;
+            }
+        }
+        bool last = (*p == '\0');
+        *out = '\0';
+        if (last) {
+            break;
+        }
+        p++;
+    }
+    return n;
+}
+
+/*Comparing two names ignoring case*/
+static bool same_name(const char* a, const char* b) {
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+/*Matching a header name to a column (-1 if unknown)*/
+static int header_column(const char* name) {
+    static const char* const names[][3] = {
+        { "id", "sku", "product_id" },
+        { "name", "product", "description" },
+        { "price", "unit_price", "cost" },
+        { "quantity", "qty", "stock" },
+        { "category", "department", "group" }
+    };
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        for (int i = 0; i < 3; i++) {
+            if (same_name(name, names[c][i])) {
+                return c;
+            }
+        }
+    }
+    return -1;
+}
+
+/*Mapping columns from the first line, returning true if it was a header*/
+static bool map_columns(CsvImport* import, char** fields, int n) {
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        import->columns[c] = -1;
+    }
+    import->mapped = true;
+
+    bool header = false;
+    for (int i = 0; i < n; i++) {
+        int c = header_column(trim_field(fields[i]));
+        if (c >= 0 && import->columns[c] == -1) {
+            import->columns[c] = i;
+            header = true;
+        }
+    }
+    if (header) {
+        return true;
+    }
+
+    /*No header: id,name,price,quantity,category, or the same without the id*/
+    int first = (n >= COLUMN_COUNT) ? 0 : 1;
+    for (int c = first; c < COLUMN_COUNT; c++) {
+        import->columns[c] = c - first;
+    }
+    return false;
+}
+
+/*Parsing a whole field as an integer*/
+static bool parse_int_field(const char* s, long* out) {
+    char* end;
+    *out = strtol(s, &end, 10);
+    return end != s && *end == '\0';
+}
+
+/*Parsing a whole field as a price*/
+static bool parse_price_field(const char* s, float* out) {
+    char* end;
+    *out = strtof(s, &end);
+    return end != s && *end == '\0' && isfinite(*out);
+}
+
+/*Counting a bad row, printing the first few*/
+static void reject_row(CsvImport* import, const char* reason) {
+    import->stats->rejected++;
+    if (import->stats->rejected <= IMPORT_ERRORS_SHOWN) {
+        printf("Line %lld rejected: %s\n", import->line, reason);
+    }
+}
+
+/*Handing the numbered rows of the batch to the store*/
+static void flush_batch(CsvImport* import) {
+    if (import->batch_count == 0) {
+        return;
+    }
+    int added = add_products(import->batch, import->batch_count);
+    import->stats->duplicates += import->batch_count - added;
+    import->stats->imported += added;
+    import->batch_count = 0;
+}
+
+/*Setting a row without an ID aside until every numbered row is in*/
+static void defer_unnumbered(CsvImport* import, const Product* p) {
+    if (import->unnumbered_count == import->unnumbered_capacity) {
+        long capacity = import->unnumbered_capacity ? import->unnumbered_capacity * 2 : IMPORT_BATCH_ROWS;
+        Product* grown = realloc(import->unnumbered, (size_t)capacity * sizeof(Product));
+        if (!grown) {
+            import->out_of_memory = true;
+            reject_row(import, "out of memory");
+            return;
+        }
+        import->unnumbered = grown;
+        import->unnumbered_capacity = capacity;
+    }
+    import->unnumbered[import->unnumbered_count++] = *p;
+}
+
+/*Numbering the deferred rows in one block above every ID the file used*/
+static void flush_unnumbered(CsvImport* import) {
+    for (long done = 0; done < import->unnumbered_count; done += IMPORT_BATCH_ROWS) {
+        int n = (int)(import->unnumbered_count - done < IMPORT_BATCH_ROWS ?
+            import->unnumbered_count - done : IMPORT_BATCH_ROWS);
+        Product* rows = import->unnumbered + done;
+        int first_id = reserve_ids(n);
+        for (int i = 0; i < n; i++) {
+            rows[i].id = first_id + i;
+        }
+        import->stats->imported += add_products(rows, n);
+        import->stats->ids_assigned += n;
+    }
+    import->unnumbered_count = 0;
+}
+
+/*Validating one data line and queueing it*/
+static void import_line(CsvImport* import, char* line) {
+    import->line++;
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\r') {
+        line[--len] = '\0';
+    }
+    if (import->line == 1 && (unsigned char)line[0] == 0xEF &&
+        (unsigned char)line[1] == 0xBB && (unsigned char)line[2] == 0xBF) {
+        line += 3; // UTF-8 byte order mark
+    }
+    if (line[strspn(line, " \t")] == '\0') {
+        return; // Blank line
+    }
+
+    /*Tab-separated unless the first line looks comma-separated*/
+    if (import->delimiter == 0) {
+        import->delimiter = (strchr(line, '\t') && !strchr(line, ',')) ? '\t' : ',';
+    }
+
+    char* fields[IMPORT_MAX_FIELDS];
+    int n = split_fields(line, import->delimiter, fields, IMPORT_MAX_FIELDS);
+    if (!import->mapped && map_columns(import, fields, n)) {
+        if (import->columns[COLUMN_NAME] == -1) {
+            printf("Header has no name column; every row will be rejected.\n");
+        }
+        return;
+    }
+    import->stats->rows++;
+
+    /*Every mapped column must be present*/
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        if (import->columns[c] >= n) {
+            reject_row(import, "missing fields");
+            return;
+        }
+    }
+    if (import->columns[COLUMN_NAME] == -1) {
+        reject_row(import, "no name column");
+        return;
+    }
+
+    Product p;
+    memset(&p, 0, sizeof(p));
+    long value;
+
+    const char* name = trim_field(fields[import->columns[COLUMN_NAME]]);
+    if (*name == '\0' || strlen(name) >= MAX_NAME_LEN) {
+        reject_row(import, "name empty or too long");
+        return;
+    }
+    memcpy(p.name, name, strlen(name) + 1);
+
+    if (import->columns[COLUMN_CATEGORY] != -1) {
+        const char* category = trim_field(fields[import->columns[COLUMN_CATEGORY]]);
+        if (strlen(category) >= MAX_CATEGORY_LEN) {
+            reject_row(import, "category too long");
+            return;
+        }
+        memcpy(p.category, category, strlen(category) + 1);
+    }
+
+    if (import->columns[COLUMN_PRICE] != -1 &&
+        (!parse_price_field(trim_field(fields[import->columns[COLUMN_PRICE]]), &p.price) || p.price < 0)) {
+        reject_row(import, "bad price");
+        return;
+    }
+
+    if (import->columns[COLUMN_QUANTITY] != -1) {
+        if (!parse_int_field(trim_field(fields[import->columns[COLUMN_QUANTITY]]), &value) ||
+            value < 0 || value > INT_MAX) {
+            reject_row(import, "bad quantity");
+            return;
+        }
+        p.quantity = (int)value;
+    }
+
+    /*An empty or zero ID asks for a new one*/
+    if (import->columns[COLUMN_ID] != -1) {
+        const char* id = trim_field(fields[import->columns[COLUMN_ID]]);
+        if (*id != '\0') {
+            if (!parse_int_field(id, &value) || value < 0 || value > INT_MAX) {
+                reject_row(import, "bad id");
+                return;
+            }
+            p.id = (int)value;
+        }
+    }
+
+    if (p.id == 0) {
+        defer_unnumbered(import, &p);
+        return;
+    }
+    import->batch[import->batch_count++] = p;
+    if (import->batch_count == IMPORT_BATCH_ROWS) {
+        flush_batch(import);
+    }
+}
+
+/*===== Import =====*/
+/*Streaming a CSV/TSV catalogue into the store in large chunks (delimiter 0 = detect)*/
+bool import_products(const char* path, char delimiter, ImportStats* stats) {
+    memset(stats, 0, sizeof(ImportStats));
+    FILE* fptr = fopen(path, "rb");
+    if (!fptr) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+
+    CsvImport import;
+    memset(&import, 0, sizeof(import));
+    import.delimiter = delimiter;
+    import.stats = stats;
+    import.batch = malloc(IMPORT_BATCH_ROWS * sizeof(Product));
+    char* buffer = malloc(IMPORT_CHUNK_SIZE + 1);
+    if (!import.batch || !buffer) {
+        free(import.batch);
+        free(buffer);
+        fclose(fptr);
+        return false;
+    }
+
+    double start = import_clock();
+    size_t carry = 0;
+    bool ok = true;
+    for (;;) {
+        size_t got = fread(buffer + carry, 1, IMPORT_CHUNK_SIZE - carry, fptr);
+        size_t len = carry + got;
+        stats->bytes += (long long)got;
+        if (got == 0 && ferror(fptr)) {
+            ok = false;
+            break;
+        }
+
+        /*Whole lines are parsed in place; the partial last line moves to the front*/
+        char* line = buffer;
+        char* end = buffer + len;
+        char* newline;
+        while ((newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+            *newline = '\0';
+            if (import.skipping) {
+                import.skipping = false; // End of an over-long line, already counted
+            }
+            else {
+                import_line(&import, line);
+            }
+            line = newline + 1;
+        }
+        carry = (size_t)(end - line);
+
+        if (got == 0) {
+            if (carry > 0 && !import.skipping) {
+                line[carry] = '\0';
+                import_line(&import, line);
+            }
+            break;
+        }
+        if (carry == IMPORT_CHUNK_SIZE) {
+            /*A line that fills a whole chunk is not a catalogue row (rejected once, however long)*/
+            if (!import.skipping) {
+                import.line++;
+                stats->rows++;
+                reject_row(&import, "line too long");
+                import.skipping = true;
+            }
+            carry = 0;
+        }
+        memmove(buffer, line, carry);
+    }
+    flush_batch(&import);
+    flush_unnumbered(&import);
+    fclose(fptr);
+
+    /*The log records of the import are on disk before reporting success*/
+    log_commit();
+    stats->seconds = import_clock() - start;
+
+    free(import.batch);
+    free(import.unnumbered);
+    free(buffer);
+    return ok && !import.out_of_memory;
+}
+
+/*Printing how much was imported and how fast*/
+void report_import(const ImportStats* stats) {
+    printf("Imported %lld of %lld rows (%lld rejected, %lld duplicate IDs, %lld new IDs) in %.3f s",
+        stats->imported, stats->rows, stats->rejected, stats->duplicates,
+        stats->ids_assigned, stats->seconds);
+    if (stats->seconds > 0) {
+        printf(" - %.0f rows/s, %.1f MB/s", (double)stats->rows / stats->seconds,
+            (double)stats->bytes / (1024.0 * 1024.0) / stats->seconds);
+    }
+    printf("\n");
+}
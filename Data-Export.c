@@ -0,0 +1,396 @@
+#include "include/data-export.h"
+#include "include/category-index.h"
+#include "include/inventory.h"
+#include "include/log-index.h"
+#include "include/product-index.h"
+#include "include/request-engine.h"
+#include "include/storage-engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*Output stream with one large buffer (rows are formatted straight into it)*/
+typedef struct {
+    FILE* out;
+    char* buffer;
+    size_t used;
+    bool failed;
+    ExportFormat format;
+    const ExportFilter* filter;
+    ExportStats* stats;
+} ExportWriter;
+
+static const char* const export_type_names[] = { "ADD", "UPDATE", "DELETE", "RESTOCK", "SALE" };
+
+/*===== Internal helpers =====*/
+/*Reading a monotonic clock in seconds*/
+static double export_clock() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/*Writing out everything buffered so far*/
+static void export_flush(ExportWriter* w) {
+    if (w->used > 0 && !w->failed && fwrite(w->buffer, 1, w->used, w->out) != w->used) {
+        w->failed = true;
+    }
+    w->stats->bytes += (long long)w->used;
+    w->used = 0;
+}
+
+/*Making room for one more row*/
+static void begin_row(ExportWriter* w) {
+    if (w->used + EXPORT_ROW_MAX > EXPORT_BUFFER_SIZE) {
+        export_flush(w);
+    }
+}
+
+/*Finishing a row*/
+static void end_row(ExportWriter* w) {
+    w->buffer[w->used++] = '\n';
+    w->stats->rows++;
+}
+
+/*Appending raw text*/
+static void put_text(ExportWriter* w, const char* s) {
+    size_t len = strlen(s);
+    memcpy(w->buffer + w->used, s, len);
+    w->used += len;
+}
+
+/*Appending an unsigned number zero-padded to width digits*/
+static void put_digits(ExportWriter* w, unsigned long long v, int width) {
+    char tmp[24];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    while (n < width) {
+        tmp[n++] = '0';
+    }
+    while (n > 0) {
+        w->buffer[w->used++] = tmp[--n];
+    }
+}
+
+/*Appending a signed integer*/
+static void put_int(ExportWriter* w, long long v) {
+    if (v < 0) {
+        w->buffer[w->used++] = '-';
+        put_digits(w, 0ULL - (unsigned long long)v, 1);
+    }
+    else {
+        put_digits(w, (unsigned long long)v, 1);
+    }
+}
+
+/*Appending an amount rounded to cents, e.g. 12.50*/
+static void put_amount(ExportWriter* w, float amount) {
+    double scaled = (double)amount * 100.0;
+    if (!(scaled > -9e18 && scaled < 9e18)) {
+        scaled = 0; // NaN or out of range
+    }
+    long long cents = (long long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    if (cents < 0) {
+        w->buffer[w->used++] = '-';
+        cents = -cents;
+    }
+    put_digits(w, (unsigned long long)(cents / 100), 1);
+    w->buffer[w->used++] = '.';
+    put_digits(w, (unsigned long long)(cents % 100), 2);
+}
+
+/*Appending a timestamp as ISO 8601 UTC (2024-05-01T13:45:00Z)*/
+static void put_timestamp(ExportWriter* w, long long t) {
+    long long days = t / 86400;
+    long long secs = t % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+
+    /*Civil date from days since 1970-01-01, in 400-year eras starting in March*/
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long day = doy - (153 * mp + 2) / 5 + 1;
+    long long month = mp < 10 ? mp + 3 : mp - 9;
+    long long year = yoe + era * 400 + (month <= 2);
+
+    if (w->format == EXPORT_JSONL) {
+        w->buffer[w->used++] = '"';
+    }
+    put_int(w, year);
+    w->buffer[w->used++] = '-';
+    put_digits(w, (unsigned long long)month, 2);
+    w->buffer[w->used++] = '-';
+    put_digits(w, (unsigned long long)day, 2);
+    w->buffer[w->used++] = 'T';
+    put_digits(w, (unsigned long long)(secs / 3600), 2);
+    w->buffer[w->used++] = ':';
+    put_digits(w, (unsigned long long)(secs / 60 % 60), 2);
+    w->buffer[w->used++] = ':';
+    put_digits(w, (unsigned long long)(secs % 60), 2);
+    w->buffer[w->used++] = 'Z';
+    if (w->format == EXPORT_JSONL) {
+        w->buffer[w->used++] = '"';
+    }
+}
+
+/*Appending a fixed-size string field, quoted and escaped for the format*/
+static void put_string(ExportWriter* w, const char* s, size_t max_len) {
+    size_t len = strnlen(s, max_len);
+    if (w->format == EXPORT_JSONL) {
+        static const char hex[] = "0123456789abcdef";
+        w->buffer[w->used++] = '"';
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = (unsigned char)s[i];
+            if (c == '"' || c == '\\') {
+                w->buffer[w->used++] = '\\';
+                w->buffer[w->used++] = (char)c;
+            }
+            else if (c < 0x20) {
+                memcpy(w->buffer + w->used, "\\u00", 4);
+                w->used += 4;
+                w->buffer[w->used++] = hex[c >> 4];
+                w->buffer[w->used++] = hex[c & 0xF];
+            }
+            else {
+                w->buffer[w->used++] = (char)c;
+            }
+        }
+        w->buffer[w->used++] = '"';
+        return;
+    }
+
+    /*CSV: quoted only when it holds a comma, quote or line break*/
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++) {
+        quote = (s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r');
+    }
+    if (!quote) {
+        memcpy(w->buffer + w->used, s, len);
+        w->used += len;
+        return;
+    }
+    w->buffer[w->used++] = '"';
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '"') {
+            w->buffer[w->used++] = '"';
+        }
+        w->buffer[w->used++] = s[i];
+    }
+    w->buffer[w->used++] = '"';
+}
+
+/*Starting a field: the JSON key, or the CSV separator*/
+static void put_key(ExportWriter* w, const char* key, bool first) {
+    if (w->format == EXPORT_JSONL) {
+        w->buffer[w->used++] = first ? '{' : ',';
+        w->buffer[w->used++] = '"';
+        put_text(w, key);
+        put_text(w, "\":");
+    }
+    else if (!first) {
+        w->buffer[w->used++] = ',';
+    }
+}
+
+/*Closing a row's JSON object*/
+static void put_row_end(ExportWriter* w) {
+    if (w->format == EXPORT_JSONL) {
+        w->buffer[w->used++] = '}';
+    }
+    end_row(w);
+}
+
+/*Opening the output and its buffer*/
+static bool open_writer(ExportWriter* w, const char* path, const ExportFilter* filter, ExportStats* stats) {
+    memset(stats, 0, sizeof(ExportStats));
+    memset(w, 0, sizeof(ExportWriter));
+    w->format = filter->format;
+    w->filter = filter;
+    w->stats = stats;
+    w->buffer = malloc(EXPORT_BUFFER_SIZE);
+    if (!w->buffer) {
+        return false;
+    }
+    w->out = strcmp(path, EXPORT_STDOUT) == 0 ? stdout : fopen(path, "wb");
+    if (!w->out) {
+        printf("Cannot create %s\n", path);
+        free(w->buffer);
+        return false;
+    }
+    return true;
+}
+
+/*Writing out the tail and closing the output*/
+static bool close_writer(ExportWriter* w) {
+    export_flush(w);
+    if (w->out == stdout) {
+        w->failed |= (fflush(stdout) != 0);
+    }
+    else if (fclose(w->out) != 0) {
+        w->failed = true;
+    }
+    free(w->buffer);
+    return !w->failed;
+}
+
+/*Writing one product as a row*/
+static void export_product(ExportWriter* w, const Product* p) {
+    begin_row(w);
+    put_key(w, "id", true);
+    put_int(w, p->id);
+    put_key(w, "name", false);
+    put_string(w, p->name, sizeof(p->name));
+    put_key(w, "price", false);
+    put_amount(w, p->price);
+    put_key(w, "quantity", false);
+    put_int(w, p->quantity);
+    put_key(w, "category", false);
+    put_string(w, p->category, sizeof(p->category));
+    put_row_end(w);
+}
+
+/*Writing a live product in the exported slot if it passes the filter*/
+static void export_slot(ExportWriter* w, long slot) {
+    const Product* p = store_record(slot);
+    if (!store_is_live(p)) {
+        return;
+    }
+    if (w->filter->product_id != 0 && p->id != w->filter->product_id) {
+        return;
+    }
+    if (w->filter->category && strncmp(p->category, w->filter->category, sizeof(p->category)) != 0) {
+        return;
+    }
+    export_product(w, p);
+}
+
+/*Writing one transaction as a row (visitor for the log scans)*/
+static bool export_transaction(const Transaction* t, void* arg) {
+    ExportWriter* w = arg;
+    /*Deletes carry no after-image, so a category filter cannot place them*/
+    if (w->filter->category &&
+        strncmp(t->after.category, w->filter->category, sizeof(t->after.category)) != 0) {
+        return true;
+    }
+
+    begin_row(w);
+    put_key(w, "timestamp", true);
+    put_timestamp(w, (long long)t->timestamp);
+    put_key(w, "type", false);
+    put_string(w, export_type_names[t->type], 8);
+    put_key(w, "product_id", false);
+    put_int(w, t->product_id);
+    put_key(w, "quantity_change", false);
+    put_int(w, t->quantity_change);
+    put_key(w, "price_change", false);
+    put_amount(w, t->price_change);
+    put_key(w, "user", false);
+    put_string(w, t->user, sizeof(t->user));
+    put_key(w, "category", false);
+    put_string(w, t->after.category, sizeof(t->after.category));
+    put_key(w, "description", false);
+    put_string(w, t->description, sizeof(t->description));
+    put_row_end(w);
+    return !w->failed;
+}
+
+/*===== Export =====*/
+/*Setting a filter that exports everything as CSV*/
+void export_filter_init(ExportFilter* filter) {
+    memset(filter, 0, sizeof(ExportFilter));
+    filter->format = EXPORT_CSV;
+    filter->from = LOG_TIME_MIN;
+    filter->to = LOG_TIME_MAX;
+}
+
+/*Streaming the live products to path ("-" for stdout), one row each*/
+bool export_inventory(const char* path, const ExportFilter* filter, ExportStats* stats) {
+    ExportWriter w;
+    if (!open_writer(&w, path, filter, stats)) {
+        return false;
+    }
+    double start = export_clock();
+    if (w.format == EXPORT_CSV) {
+        put_text(&w, "id,name,price,quantity,category\n");
+    }
+
+    /*Slots cannot move while the scan runs*/
+    engine_lock_catalog(true);
+    if (!store_open()) {
+        w.failed = true;
+    }
+    else if (filter->product_id != 0) {
+        /*One product: a single index lookup*/
+        long slot = index_ready() ? index_lookup(filter->product_id) : -1;
+        if (slot >= 0) {
+            export_slot(&w, slot);
+        }
+    }
+    else if (filter->category) {
+        /*One category: only its posting list is visited*/
+        const long* slots = NULL;
+        long count = category_postings(category_find(filter->category), &slots);
+        for (long i = 0; i < count; i++) {
+            export_slot(&w, slots[i]);
+        }
+    }
+    else {
+        long records = store_count();
+        for (long slot = 0; slot < records; slot++) {
+            export_slot(&w, slot);
+        }
+    }
+    engine_unlock_catalog();
+
+    bool ok = close_writer(&w);
+    stats->seconds = export_clock() - start;
+    return ok;
+}
+
+/*Streaming the transactions inside the filter's window to path, oldest first*/
+bool export_transactions(const char* path, const ExportFilter* filter, ExportStats* stats) {
+    ExportWriter w;
+    if (!open_writer(&w, path, filter, stats)) {
+        return false;
+    }
+    double start = export_clock();
+    if (w.format == EXPORT_CSV) {
+        put_text(&w, "timestamp,type,product_id,quantity_change,price_change,user,category,description\n");
+    }
+
+    /*The log index narrows the scan to the product's chain or the window's blocks*/
+    long count = filter->product_id != 0
+        ? log_scan_product(filter->product_id, filter->from, filter->to, export_transaction, &w)
+        : log_scan_range(filter->from, filter->to, export_transaction, &w);
+    if (count < 0) {
+        w.failed = true;
+    }
+
+    bool ok = close_writer(&w);
+    stats->seconds = export_clock() - start;
+    return ok;
+}
+
+/*Printing how much was exported and how fast*/
+void report_export(const ExportStats* stats) {
+    printf("Exported %lld rows (%.1f MB) in %.3f s", stats->rows,
+        (double)stats->bytes / (1024.0 * 1024.0), stats->seconds);
+    if (stats->seconds > 0) {
+        printf(" - %.0f rows/s, %.1f MB/s", (double)stats->rows / stats->seconds,
+            (double)stats->bytes / (1024.0 * 1024.0) / stats->seconds);
+    }
+    printf("\n");
+}
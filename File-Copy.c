@@ -0,0 +1,412 @@
+#include "include/file-copy.h"
+#include "include/crc32c.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+/*Statistics of the last copy*/
+static CopyStats copy_stats = { 0 };
+
+/*Skipping reflinks and kernel copies (to check or measure the portable loop)*/
+static bool force_buffered = false;
+
+/*===== Internal helpers =====*/
+/*Reading a monotonic clock in seconds*/
+static double copy_clock() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC; // Wall time on Windows
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+#ifdef _WIN32
+/*Copying through a large heap buffer (no kernel copy API is used here)*/
+static bool copy_buffered(const char* src, const char* dest, unsigned int* checksum) {
+    FILE* src_fptr = fopen(src, "rb");
+    FILE* dest_fptr = fopen(dest, "wb");
+    unsigned char* buffer = malloc(COPY_BUFFER_SIZE);
+    bool success = src_fptr && dest_fptr && buffer;
+    size_t bytes;
+
+    while (success && (bytes = fread(buffer, 1, COPY_BUFFER_SIZE, src_fptr)) > 0) {
+        success = fwrite(buffer, 1, bytes, dest_fptr) == bytes;
+        copy_stats.bytes += (long long)bytes;
+        if (checksum) {
+            *checksum = crc32c_update(*checksum, buffer, bytes);
+        }
+    }
+    success = success && !ferror(src_fptr);
+
+    if (src_fptr) {
+        fclose(src_fptr);
+    }
+    if (dest_fptr && fclose(dest_fptr) != 0) {
+        success = false;
+    }
+    free(buffer);
+    copy_stats.method = COPY_BUFFERED;
+    return success;
+}
+#else
+/*Checking whether a kernel copy call is unsupported for this pair of files*/
+static bool copy_unsupported(int error) {
+    return error == ENOSYS || error == EXDEV || error == EINVAL ||
+        error == EOPNOTSUPP || error == ENOTTY || error == EBADF;
+}
+
+/*Copying whatever is left from offset through an aligned buffer (out < 0 only hashes)*/
+static bool copy_buffered(int in, int out, off_t* offset, off_t size, unsigned int* checksum) {
+    void* buffer = NULL;
+    if (posix_memalign(&buffer, COPY_BUFFER_ALIGN, COPY_BUFFER_SIZE) != 0) {
+        return false;
+    }
+
+    bool success = true;
+    while (success && *offset < size) {
+        size_t want = size - *offset < COPY_BUFFER_SIZE ? (size_t)(size - *offset) : COPY_BUFFER_SIZE;
+        ssize_t got = pread(in, buffer, want, *offset);
+        if (got <= 0) {
+            success = (got == 0); // File shrank under us: stop at what is there
+            break;
+        }
+        if (checksum) {
+            *checksum = crc32c_update(*checksum, buffer, (size_t)got);
+        }
+        ssize_t written = 0;
+        while (success && out >= 0 && written < got) {
+            ssize_t n = pwrite(out, (char*)buffer + written, got - written, *offset + written);
+            success = n > 0;
+            written += n > 0 ? n : 0;
+        }
+        *offset += got;
+    }
+    free(buffer);
+    if (out >= 0) {
+        copy_stats.method = COPY_BUFFERED;
+    }
+    return success;
+}
+
+/*Writing one mapped chunk of the source to the same offset of the destination*/
+static bool write_chunk(int in, int out, const char* data, off_t offset, size_t length,
+    bool* kernel_copy) {
+    size_t done = 0;
+
+#if defined(__linux__) && defined(SYS_copy_file_range)
+    /*The chunk is already in the page cache, so the kernel copies it without a disk read*/
+    while (*kernel_copy && done < length) {
+        loff_t in_offset = offset + (off_t)done;
+        loff_t out_offset = in_offset;
+        long n = syscall(SYS_copy_file_range, in, &in_offset, out, &out_offset, length - done, 0);
+        if (n > 0) {
+            done += (size_t)n;
+            copy_stats.method = COPY_RANGE;
+            continue;
+        }
+        if (n < 0 && (done > 0 || copy_stats.method == COPY_RANGE || !copy_unsupported(errno))) {
+            return false;
+        }
+        *kernel_copy = false; // Unsupported here (or no progress): write from the mapping
+    }
+#else
+    (void)in;
+    *kernel_copy = false;
+#endif
+
+    while (done < length) {
+        ssize_t n = pwrite(out, data + done, length - done, offset + (off_t)done);
+        if (n <= 0) {
+            return false;
+        }
+        done += (size_t)n;
+        copy_stats.method = COPY_MAPPED;
+    }
+    return true;
+}
+
+/*Copying and hashing in one pass: each chunk is mapped, hashed, then written*/
+static bool copy_hashed(int in, int out, off_t size, unsigned int* checksum) {
+    bool cloned = false;
+    if (force_buffered) {
+        off_t offset = 0;
+        return copy_buffered(in, out, &offset, size, checksum);
+    }
+#if defined(__linux__) && defined(FICLONE)
+    /*A reflink moves no data, so the source is only read for the hash*/
+    cloned = ioctl(out, FICLONE, in) == 0;
+    if (cloned) {
+        copy_stats.method = COPY_REFLINK;
+    }
+#endif
+
+    bool kernel_copy = true;
+    off_t offset = 0;
+    while (offset < size) {
+        size_t length = size - offset < COPY_HASH_CHUNK ? (size_t)(size - offset) : COPY_HASH_CHUNK;
+        void* map = mmap(NULL, length, PROT_READ, MAP_SHARED, in, offset);
+        if (map == MAP_FAILED) {
+            /*Not mappable (e.g. a pipe or special filesystem): finish through a buffer*/
+            return copy_buffered(in, cloned ? -1 : out, &offset, size, checksum);
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(map, length, MADV_SEQUENTIAL);
+#endif
+        *checksum = crc32c_update(*checksum, map, length);
+        bool ok = cloned || write_chunk(in, out, (const char*)map, offset, length, &kernel_copy);
+        munmap(map, length);
+        if (!ok) {
+            return false;
+        }
+        offset += (off_t)length;
+    }
+    return true;
+}
+
+/*Copying with the fastest method the kernel and filesystem allow*/
+static bool copy_descriptors(int in, int out, off_t size) {
+    off_t offset = 0;
+    if (force_buffered) {
+        return copy_buffered(in, out, &offset, size, NULL);
+    }
+
+#ifdef __linux__
+    /*Reflink: the destination shares the source's extents*/
+#ifdef FICLONE
+    if (ioctl(out, FICLONE, in) == 0) {
+        copy_stats.method = COPY_REFLINK;
+        copy_stats.bytes = (long long)size;
+        return true;
+    }
+#endif
+
+    /*copy_file_range: in-kernel copy, server-side on NFS/CIFS*/
+#ifdef SYS_copy_file_range
+    while (offset < size) {
+        loff_t in_offset = offset;
+        loff_t out_offset = offset;
+        long n = syscall(SYS_copy_file_range, in, &in_offset, out, &out_offset,
+            (size_t)(size - offset), 0);
+        if (n > 0) {
+            offset += n;
+            copy_stats.method = COPY_RANGE;
+            continue;
+        }
+        if (n == 0 && offset > 0) {
+            return true; // Source ended early
+        }
+        if (n < 0 && (offset > 0 || !copy_unsupported(errno))) {
+            return false;
+        }
+        break;
+    }
+    if (offset >= size && size > 0) {
+        return true;
+    }
+#endif
+
+    /*sendfile: in-kernel copy on older kernels and across filesystems*/
+    while (offset < size) {
+        ssize_t n = sendfile(out, in, &offset, (size_t)(size - offset));
+        if (n > 0) {
+            copy_stats.method = COPY_SENDFILE;
+            continue;
+        }
+        if (n == 0 && offset > 0) {
+            return true;
+        }
+        if (n < 0 && (copy_stats.method == COPY_SENDFILE || !copy_unsupported(errno))) {
+            return false;
+        }
+        break;
+    }
+    if (offset >= size) {
+        return true;
+    }
+#endif
+
+    return copy_buffered(in, out, &offset, size, NULL);
+}
+#endif
+
+/*===== Copy engine =====*/
+/*Copying a file, preferring reflinks and in-kernel copies over a user-space loop*/
+bool copy_file(const char* src, const char* dest) {
+    return copy_file_checked(src, dest, NULL);
+}
+
+/*Copying a file and computing its CRC32C in the same pass (checksum may be NULL)*/
+bool copy_file_checked(const char* src, const char* dest, unsigned int* checksum) {
+    memset(&copy_stats, 0, sizeof(copy_stats));
+    double start = copy_clock();
+    bool success;
+    if (checksum) {
+        *checksum = 0;
+    }
+
+#ifdef _WIN32
+    success = copy_buffered(src, dest, checksum);
+#else
+    int in = open(src, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        close(in);
+        return false;
+    }
+    int out = open(dest, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    success = checksum ? copy_hashed(in, out, st.st_size, checksum) :
+        copy_descriptors(in, out, st.st_size);
+    if (copy_stats.method != COPY_REFLINK) {
+        copy_stats.bytes = (long long)st.st_size;
+    }
+    close(in);
+    if (close(out) != 0) {
+        success = false;
+    }
+#endif
+
+    copy_stats.seconds = copy_clock() - start;
+    return success;
+}
+
+/*Turning the fallback loop on for every copy, or back off*/
+void set_copy_fallback(bool forced) {
+    force_buffered = forced;
+}
+
+/*Computing the CRC32C of a file from offset to its end*/
+bool checksum_file(const char* path, long long offset, unsigned int* checksum) {
+    *checksum = 0;
+
+#ifdef _WIN32
+    FILE* fptr = fopen(path, "rb");
+    unsigned char* buffer = malloc(COPY_BUFFER_SIZE);
+    bool success = fptr && buffer && _fseeki64(fptr, offset, SEEK_SET) == 0;
+    size_t bytes;
+    while (success && (bytes = fread(buffer, 1, COPY_BUFFER_SIZE, fptr)) > 0) {
+        *checksum = crc32c_update(*checksum, buffer, bytes);
+    }
+    success = success && !ferror(fptr);
+    if (fptr) {
+        fclose(fptr);
+    }
+    free(buffer);
+    return success;
+#else
+    int in = open(path, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    struct stat st;
+    bool success = fstat(in, &st) == 0;
+    if (success) {
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        off_t position = (off_t)offset;
+        success = copy_buffered(in, -1, &position, st.st_size, checksum);
+    }
+    close(in);
+    return success;
+#endif
+}
+
+/*Getting the statistics of the last copy*/
+const CopyStats* last_copy_stats() {
+    return &copy_stats;
+}
+
+/*Naming a copy method*/
+const char* copy_method_name(CopyMethod method) {
+    switch (method) {
+    case COPY_REFLINK:
+        return "reflink";
+    case COPY_RANGE:
+        return "copy_file_range";
+    case COPY_SENDFILE:
+        return "sendfile";
+    case COPY_MAPPED:
+        return "mmap";
+    case COPY_BUFFERED:
+        return "buffered";
+    default:
+        return "none";
+    }
+}
+
+/*Printing the throughput of the last copy*/
+void report_copy_throughput(const char* label) {
+    double mb = (double)copy_stats.bytes / (1024.0 * 1024.0);
+    if (copy_stats.seconds > 0) {
+        printf("%s: %.1f MB in %.3f s (%.1f MB/s, %s)\n", label, mb, copy_stats.seconds,
+            mb / copy_stats.seconds, copy_method_name(copy_stats.method));
+    }
+    else {
+        printf("%s: %.1f MB (%s)\n", label, mb, copy_method_name(copy_stats.method));
+    }
+}
+
+/*===== Durable replacement =====*/
+/*Forcing a file (or directory entry list) to stable storage*/
+bool sync_file(const char* path) {
+#ifdef _WIN32
+    (void)path;
+    return true; // Nothing portable to call; data is committed when the writer closes
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+/*Replacing path with a finished temp file in one step: a crash leaves one or the other*/
+bool install_file(const char* temp, const char* path) {
+    if (!sync_file(temp)) {
+        return false;
+    }
+#ifdef _WIN32
+    remove(path); // rename() does not overwrite on Windows
+#endif
+    if (rename(temp, path) != 0) {
+        return false;
+    }
+
+    /*The rename itself lives in the directory*/
+    char dir[256] = ".";
+    const char* slash = strrchr(path, '/');
+    if (slash && slash != path) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    }
+    sync_file(dir);
+    return true;
+}
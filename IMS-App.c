@@ -1,18 +1,48 @@
-#include "inventoryMain.c"
-#include "UI.c"
-#include "Backup-Restore.c"
+#include "include/inventory.h"
+#include "include/ui.h"
+#include "include/transaction-log.h"
+#include "include/backup-online.h"
+#include "include/command-line.h"
+#include "include/workload-trace.h"
+#include "include/request-engine.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*Main entry code*/
-int main() {
+int main(int argc, char* argv[]) {
     int choice;
+
+    /*--record <trace> captures this session's calls for replay*/
+    if (argc > 2 && strcmp(argv[1], "--record") == 0) {
+        if (!trace_start(argv[2])) {
+            printf("Cannot record to %s\n", argv[2]);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    /*A command on the command line runs without the menu*/
+    if (argc > 1) {
+        return run_command(argc - 1, argv + 1);
+    }
     print_header("===== Inventory Management System =====");
 
+    /*Loading cached statistics and building the product index once*/
+    inventory_init();
+    /*Sales and restocks are served by the worker pool*/
+    engine_start(load_engine_threads());
+
     while (1) {
         display_menu();
         choice = get_int_input("Enter Your choice");
         handle_menu_choice(choice);
+        /*Committing the log group for this menu action*/
+        log_commit();
+        trace_flush();
+        /*Cataloguing a background backup once it has finished*/
+        online_backup_finish(false);
     }
 
     return 0;
@@ -0,0 +1,471 @@
+#include "include/inventory.h"
+#include "include/backup-online.h"
+#include "include/backup-restore.h"
+#include "include/file-copy.h"
+#include "include/latency-histogram.h"
+#include "include/log-segment.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#define bench_dup _dup
+#define bench_dup2 _dup2
+#define bench_close _close
+#define NULL_DEVICE "NUL"
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#define bench_dup dup
+#define bench_dup2 dup2
+#define bench_close close
+#define NULL_DEVICE "/dev/null"
+#endif
+
+// Constants
+#define BENCH_DEFAULT_RECORDS 10000
+#define BENCH_DEFAULT_OPS 100000
+#define BENCH_DEFAULT_REPS 3 // Runs of the whole-store operations (report, backup, restore)
+#define BENCH_MAX_SIZES 16
+#define BENCH_DEFAULT_DIR "bench_data"
+#define BENCH_CATEGORIES 50
+
+/*Latencies of one operation (a histogram, so 10M samples cost no memory)*/
+typedef struct {
+    LatencyHistogram latency;
+    double total_seconds; // Wall time of the whole phase
+} BenchHistogram;
+
+/*Benchmark settings from the command line*/
+typedef struct {
+    long sizes[BENCH_MAX_SIZES];
+    int size_count;
+    long ops;
+    int reps;
+    unsigned long long seed;
+    bool csv;
+    bool skip_backup;
+    const char* dir;
+    const char* config; // storage.cfg copied into each run directory
+} BenchOptions;
+
+static unsigned long long bench_rng_state = 88172645463325252ULL;
+static int bench_saved_stdout = -1;
+
+/*===== Internal helpers =====*/
+/*Drawing a pseudo-random number (xorshift64)*/
+static unsigned long long bench_random() {
+    bench_rng_state ^= bench_rng_state << 13;
+    bench_rng_state ^= bench_rng_state >> 7;
+    bench_rng_state ^= bench_rng_state << 17;
+    return bench_rng_state;
+}
+
+/*Picking an ID from 1..n*/
+static int bench_random_id(long n) {
+    return (int)(bench_random() % (unsigned long long)n) + 1;
+}
+
+/*Sending the program's own output to the null device while operations run*/
+static void bench_quiet(bool quiet) {
+    fflush(stdout);
+    if (quiet && bench_saved_stdout < 0) {
+        int null_fd = open(NULL_DEVICE, O_WRONLY);
+        if (null_fd >= 0) {
+            bench_saved_stdout = bench_dup(1);
+            bench_dup2(null_fd, 1);
+            bench_close(null_fd);
+        }
+    }
+    else if (!quiet && bench_saved_stdout >= 0) {
+        bench_dup2(bench_saved_stdout, 1);
+        bench_close(bench_saved_stdout);
+        bench_saved_stdout = -1;
+    }
+}
+
+/*Printing one result line*/
+static void bench_report(const BenchOptions* options, long records, const char* op, const BenchHistogram* h) {
+    double rate = h->total_seconds > 0 ? (double)h->latency.count / h->total_seconds : 0;
+    if (options->csv) {
+        printf("%ld,%s,%lld,%.6f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+            records, op, h->latency.count, h->total_seconds, rate,
+            latency_percentile(&h->latency, 50), latency_percentile(&h->latency, 90), latency_percentile(&h->latency, 99),
+            latency_percentile(&h->latency, 99.9), (double)h->latency.max_ns / 1000.0);
+    }
+    else {
+        printf("{\"records\":%ld,\"op\":\"%s\",\"ops\":%lld,\"seconds\":%.6f,\"ops_per_sec\":%.1f,"
+            "\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f}\n",
+            records, op, h->latency.count, h->total_seconds, rate,
+            latency_percentile(&h->latency, 50), latency_percentile(&h->latency, 90), latency_percentile(&h->latency, 99),
+            latency_percentile(&h->latency, 99.9), (double)h->latency.max_ns / 1000.0);
+    }
+    fflush(stdout);
+}
+
+/*Creating a directory if it does not exist*/
+static void bench_mkdir(const char* path) {
+    struct stat st = { 0 };
+    if (stat(path, &st) == -1) {
+#ifdef _WIN32
+        _mkdir(path);
+#else
+        mkdir(path, 0755);
+#endif
+    }
+}
+
+/*Removing the regular files of a directory (left over from an earlier run)*/
+static void bench_clear_dir(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        char file[512];
+        struct stat st;
+        snprintf(file, sizeof(file), "%s/%s", path, ent->d_name);
+        if (stat(file, &st) == 0 && S_ISREG(st.st_mode)) {
+            remove(file);
+        }
+    }
+    closedir(dir);
+}
+
+/*Filling in a synthetic product*/
+static Product bench_product(int id) {
+    Product p;
+    memset(&p, 0, sizeof(p));
+    p.id = id;
+    snprintf(p.name, sizeof(p.name), "Product %d", id);
+    snprintf(p.category, sizeof(p.category), "Category %d", (int)(bench_random() % BENCH_CATEGORIES));
+    p.price = (float)(bench_random() % 100000) / 100.0f;
+    p.quantity = 1000 + (int)(bench_random() % 1000);
+    return p;
+}
+
+/*Finding the newest catalogued backup (NULL if none)*/
+static const char* newest_backup() {
+    int count = 0;
+    BackupEntry* entries = list_backups_sorted(&count);
+    return count > 0 ? entries[count - 1].path : NULL;
+}
+
+/*===== Operations =====*/
+/*Timing every call of one per-record operation*/
+#define BENCH_TIMED(h, call) \
+    do { \
+        long long bench_t0 = latency_clock_ns(); \
+        call; \
+        latency_add(&(h)->latency, latency_clock_ns() - bench_t0); \
+    } while (0)
+
+/*Running every operation against a fresh catalogue of records products*/
+static void bench_catalogue(const BenchOptions* options, long records) {
+    long ops = options->ops;
+    BenchHistogram* h = malloc(sizeof(BenchHistogram));
+    if (!h) {
+        return;
+    }
+    long long phase;
+
+    bench_quiet(true);
+    inventory_init();
+
+    /*add_product: building the catalogue itself*/
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (long i = 1; i <= records; i++) {
+        Product p = bench_product((int)i);
+        BENCH_TIMED(h, add_product(p));
+    }
+    log_commit();
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "add_product", h);
+
+    /*get_product: random point reads*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (long i = 0; i < ops; i++) {
+        int id = bench_random_id(records);
+        Product* p = NULL;
+        BENCH_TIMED(h, p = get_product(id));
+        free(p);
+    }
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "get_product", h);
+
+    /*update_product: random rewrites of price and stock*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (long i = 0; i < ops; i++) {
+        Product p = bench_product(bench_random_id(records));
+        BENCH_TIMED(h, update_product(p.id, p));
+    }
+    log_commit();
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "update_product", h);
+
+    /*sell_product: a stream of single-unit sales*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (long i = 0; i < ops; i++) {
+        int id = bench_random_id(records);
+        BENCH_TIMED(h, sell_product(id, 1));
+    }
+    log_commit();
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "sell_product", h);
+
+    /*log_transaction: synthetic restock records straight into the log (the commit is in the total)*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (long i = 0; i < ops; i++) {
+        Transaction t;
+        memset(&t, 0, sizeof(t));
+        t.timestamp = time(NULL);
+        t.type = RESTOCK;
+        t.product_id = bench_random_id(records);
+        t.quantity_change = 1;
+        snprintf(t.user, sizeof(t.user), "bench");
+        snprintf(t.description, sizeof(t.description), "Synthetic restock of product %d", t.product_id);
+        BENCH_TIMED(h, log_transaction(t));
+    }
+    log_commit();
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "log_transaction", h);
+
+    /*generate_report: whole-store scans*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    phase = latency_clock_ns();
+    for (int i = 0; i < options->reps; i++) {
+        BENCH_TIMED(h, generate_report());
+    }
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "generate_report", h);
+
+    if (!options->skip_backup) {
+        /*create_backup: including a background snapshot finishing, if one was started*/
+        bench_quiet(true);
+        memset(h, 0, sizeof(*h));
+        phase = latency_clock_ns();
+        for (int i = 0; i < options->reps; i++) {
+            BENCH_TIMED(h, create_backup(); online_backup_finish(true));
+        }
+        h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+        bench_quiet(false);
+        bench_report(options, records, "create_backup", h);
+
+        /*restore_backup: the newest backup over the live store*/
+        bench_quiet(true);
+        memset(h, 0, sizeof(*h));
+        phase = latency_clock_ns();
+        char path[256];
+        const char* newest = newest_backup();
+        snprintf(path, sizeof(path), "%s", newest ? newest : "");
+        for (int i = 0; i < options->reps && path[0]; i++) {
+            BENCH_TIMED(h, restore_backup(path));
+        }
+        h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+        bench_quiet(false);
+        bench_report(options, records, "restore_backup", h);
+    }
+
+    /*delete_product: distinct IDs in a scattered order (a stride coprime with records)*/
+    bench_quiet(true);
+    memset(h, 0, sizeof(*h));
+    long deletes = ops < records / 2 ? ops : records / 2;
+    long stride = (long)(2654435761ULL % (unsigned long long)records);
+    for (;;) {
+        long a = stride;
+        long b = records;
+        while (b != 0) {
+            long r = a % b;
+            a = b;
+            b = r;
+        }
+        if (a == 1) {
+            break;
+        }
+        stride++;
+    }
+    phase = latency_clock_ns();
+    for (long i = 0; i < deletes; i++) {
+        int id = (int)((unsigned long long)i * (unsigned long long)stride % (unsigned long long)records) + 1;
+        BENCH_TIMED(h, delete_product(id));
+    }
+    log_commit();
+    h->total_seconds = (double)(latency_clock_ns() - phase) / 1e9;
+    bench_quiet(false);
+    bench_report(options, records, "delete_product", h);
+
+    free(h);
+}
+
+/*Running one catalogue size in its own directory (and, where possible, its own process)*/
+static bool bench_size(const BenchOptions* options, long records) {
+    char run_dir[512];
+    snprintf(run_dir, sizeof(run_dir), "%s/%ld", options->dir, records);
+    bench_mkdir(options->dir);
+    bench_mkdir(run_dir);
+
+    char sub[600];
+    snprintf(sub, sizeof(sub), "%s/%s", run_dir, BACKUP_DIR);
+    bench_clear_dir(sub);
+    snprintf(sub, sizeof(sub), "%s/%s", run_dir, LOG_SEGMENT_DIR);
+    bench_clear_dir(sub);
+    bench_clear_dir(run_dir);
+    if (options->config) {
+        snprintf(sub, sizeof(sub), "%s/%s", run_dir, STORAGE_CONFIG_FILE);
+        if (!copy_file(options->config, sub)) {
+            fprintf(stderr, "Cannot copy %s\n", options->config);
+            return false;
+        }
+    }
+
+#ifndef _WIN32
+    /*Every module keeps process-wide state, so each size starts from a clean process*/
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child > 0) {
+        int status;
+        waitpid(child, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+#endif
+    if (chdir(run_dir) != 0) {
+        fprintf(stderr, "Cannot enter %s\n", run_dir);
+        exit(1);
+    }
+    bench_catalogue(options, records);
+#ifndef _WIN32
+    exit(0);
+#endif
+    return true;
+}
+
+/*Printing the benchmark's options*/
+static void bench_usage() {
+    fprintf(stderr,
+        "Usage: ims-bench [--records N[,N...]] [--ops N] [--reps N] [--seed N] [--csv]\n"
+        "                 [--skip-backup] [--dir PATH] [--config storage.cfg]\n"
+        "  --records  Catalogue sizes, e.g. 10000,100000,1000000 (default %d)\n"
+        "  --ops      Calls per random-access operation (default %d)\n"
+        "  --reps     Runs of report, backup and restore (default %d)\n"
+        "  --dir      Scratch directory, one subdirectory per size (default %s)\n"
+        "Results are JSON Lines (or CSV) on standard output, one line per operation.\n",
+        BENCH_DEFAULT_RECORDS, BENCH_DEFAULT_OPS, BENCH_DEFAULT_REPS, BENCH_DEFAULT_DIR);
+}
+
+/*Reading the sizes list, e.g. 10000,100000*/
+static bool parse_sizes(const char* s, BenchOptions* options) {
+    options->size_count = 0;
+    while (*s && options->size_count < BENCH_MAX_SIZES) {
+        char* end;
+        long value = strtol(s, &end, 10);
+        if (end == s || value <= 0 || value > INT_MAX - 1) {
+            return false;
+        }
+        options->sizes[options->size_count++] = value;
+        s = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return false;
+        }
+    }
+    return options->size_count > 0;
+}
+
+/*Benchmark entry code*/
+int main(int argc, char* argv[]) {
+    BenchOptions options = {
+        .sizes = { BENCH_DEFAULT_RECORDS },
+        .size_count = 1,
+        .ops = BENCH_DEFAULT_OPS,
+        .reps = BENCH_DEFAULT_REPS,
+        .seed = 0,
+        .dir = BENCH_DEFAULT_DIR
+    };
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (strcmp(argv[i], "--records") == 0 && has_value) {
+            ok = parse_sizes(argv[++i], &options);
+        }
+        else if (strcmp(argv[i], "--ops") == 0 && has_value) {
+            options.ops = strtol(argv[++i], NULL, 10);
+            ok = options.ops > 0;
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && has_value) {
+            options.reps = (int)strtol(argv[++i], NULL, 10);
+            ok = options.reps > 0;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && has_value) {
+            options.dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--config") == 0 && has_value) {
+            options.config = argv[++i];
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            options.csv = true;
+        }
+        else if (strcmp(argv[i], "--skip-backup") == 0) {
+            options.skip_backup = true;
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            bench_usage();
+            return 1;
+        }
+    }
+#ifdef _WIN32
+    /*Sizes cannot be isolated in child processes here*/
+    if (options.size_count > 1) {
+        fprintf(stderr, "Run one --records size per invocation on this platform\n");
+        return 1;
+    }
+#endif
+    if (options.seed != 0) {
+        bench_rng_state = options.seed;
+    }
+
+    if (options.csv) {
+        printf("records,op,ops,seconds,ops_per_sec,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    }
+    int failures = 0;
+    for (int i = 0; i < options.size_count; i++) {
+        if (!bench_size(&options, options.sizes[i])) {
+            fprintf(stderr, "Benchmark of %ld records failed\n", options.sizes[i]);
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,1484 @@
+#include "include/inventory.h"
+#include "include/backup-catalog.h"
+#include "include/backup-delta.h"
+#include "include/backup-online.h"
+#include "include/backup-restore.h"
+#include "include/category-index.h"
+#include "include/column-snapshot.h"
+#include "include/csv-import.h"
+#include "include/data-export.h"
+#include "include/file-copy.h"
+#include "include/inventory-stats.h"
+#include "include/log-index.h"
+#include "include/log-replay.h"
+#include "include/log-segment.h"
+#include "include/lz-codec.h"
+#include "include/product-index.h"
+#include "include/request-engine.h"
+#include "include/stock-index.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include "include/workload-trace.h"
+#include "include/write-ahead-log.h"
+#include <dirent.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <windows.h>
+#define test_getcwd _getcwd
+#define test_chdir _chdir
+#define test_rmdir _rmdir
+#define test_mkdir(path) _mkdir(path)
+#else
+#include <pthread.h>
+#include <unistd.h>
+#define test_getcwd getcwd
+#define test_chdir chdir
+#define test_rmdir rmdir
+#define test_mkdir(path) mkdir(path, 0755)
+#endif
+
+// Constants
+#define TEST_SKIPPED 77 // CTest's SKIP_RETURN_CODE
+#define TEST_PATH_MAX 4096
+#define TEST_PRICE 2.5f // Exact in binary, so value checks are exact too
+#define ENGINE_TEST_THREADS 8
+#define ENGINE_TEST_SALES 1000 // Single-unit sales per thread
+#define ENGINE_TEST_STOCK 10000
+#define INDEX_TEST_IDS 5000 // Enough to grow the index several times
+#define COMPACT_TEST_RECORDS 200
+#define COLUMN_TEST_SLOTS 1003 // Not a multiple of any vector width
+#define LOG_QUERY_TEST_RECORDS 900 // Several LOG_INDEX_BLOCKs, divisible by three
+#define LZ_TEST_RECORDS 2000
+#define SEGMENT_TEST_RECORDS 1000
+#define BACKUP_TEST_RECORDS (BACKUP_BLOCK_RECORDS * 8)
+#define COPY_TEST_BYTES (COPY_BUFFER_SIZE * 2L + 123) // Several buffers plus a partial one
+#define SNAPSHOT_TEST_RECORDS (SNAPSHOT_PAGE_RECORDS * 4 + 7) // Ends partway into a page
+#define WAL_TEST_SLOTS 3
+
+/*Failing the current test with where and why*/
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/*One test, run as ims-tests <name>*/
+typedef struct {
+    const char* name;
+    int (*run)(); // 0 on success, TEST_SKIPPED or 1
+} TestCase;
+
+/*===== Internal helpers =====*/
+/*Removing the regular files of a directory (left over from an earlier run)*/
+static void test_clear_dir(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        char file[512];
+        struct stat st;
+        snprintf(file, sizeof(file), "%s/%s", path, ent->d_name);
+        if (stat(file, &st) == 0 && S_ISREG(st.st_mode)) {
+            remove(file);
+        }
+    }
+    closedir(dir);
+}
+
+/*Reading the stock of a product (-1 if it does not exist)*/
+static int test_stock(int id) {
+    Product* p = get_product(id);
+    int stock = p ? p->quantity : -1;
+    free(p);
+    return stock;
+}
+
+/*Creating a new, uniquely named directory from a name ending in XXXXXX*/
+static bool test_make_scratch(char* name) {
+#ifdef _WIN32
+    return _mktemp_s(name, strlen(name) + 1) == 0 && _mkdir(name) == 0;
+#else
+    return mkdtemp(name) != NULL;
+#endif
+}
+
+/*Removing a scratch directory and the subdirectories the store creates in it*/
+static void test_remove_scratch(const char* scratch) {
+    const char* subdirs[] = { BACKUP_DIR, LOG_SEGMENT_DIR };
+    char path[TEST_PATH_MAX];
+    for (int i = 0; i < (int)(sizeof(subdirs) / sizeof(subdirs[0])); i++) {
+        snprintf(path, sizeof(path), "%s/%s", scratch, subdirs[i]);
+        test_clear_dir(path);
+        test_rmdir(path);
+    }
+    test_clear_dir(scratch);
+    test_rmdir(scratch);
+}
+
+/*Running one test in a fresh scratch directory under the working directory (kept if it fails)*/
+static int test_run(const TestCase* test) {
+    char home[TEST_PATH_MAX];
+    char scratch[TEST_PATH_MAX];
+    if (!test_getcwd(home, sizeof(home))) {
+        return 1;
+    }
+    snprintf(scratch, sizeof(scratch), "%s/ims-%s-XXXXXX", home, test->name);
+    if (!test_make_scratch(scratch) || test_chdir(scratch) != 0) {
+        fprintf(stderr, "Cannot create a scratch directory in %s\n", home);
+        return 1;
+    }
+
+    int status = test->run();
+
+    bool back = test_chdir(home) == 0;
+    if (status == 1) {
+        printf("Files left in %s\n", scratch);
+    }
+    else if (back) {
+        test_remove_scratch(scratch);
+    }
+    return status;
+}
+
+/*Filling in a product*/
+static Product test_product(int id, const char* category, int quantity) {
+    Product p;
+    memset(&p, 0, sizeof(p));
+    p.id = id;
+    snprintf(p.name, sizeof(p.name), "Product %d", id);
+    snprintf(p.category, sizeof(p.category), "%s", category);
+    p.price = TEST_PRICE;
+    p.quantity = quantity;
+    return p;
+}
+
+/*Waiting for the clock to tick over (backup names and log timestamps have one-second resolution)*/
+static void test_next_second() {
+    time_t now = time(NULL);
+    while (time(NULL) == now) {
+#ifdef _WIN32
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
+    }
+}
+
+/*Reading a whole file (NULL if it cannot be read)*/
+static unsigned char* test_read_file(const char* path, long* size) {
+    FILE* fptr = fopen(path, "rb");
+    if (!fptr) {
+        return NULL;
+    }
+    fseek(fptr, 0, SEEK_END);
+    *size = ftell(fptr);
+    fseek(fptr, 0, SEEK_SET);
+    unsigned char* data = malloc(*size > 0 ? (size_t)*size : 1);
+    if (data && fread(data, 1, (size_t)*size, fptr) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fptr);
+    return data;
+}
+
+/*Checking that two files hold the same bytes*/
+static bool test_same_file(const char* a, const char* b) {
+    long size_a = 0;
+    long size_b = 0;
+    unsigned char* data_a = test_read_file(a, &size_a);
+    unsigned char* data_b = test_read_file(b, &size_b);
+    bool same = data_a && data_b && size_a == size_b && memcmp(data_a, data_b, (size_t)size_a) == 0;
+    free(data_a);
+    free(data_b);
+    return same;
+}
+
+/*Finding the newest catalogued backup (NULL if none)*/
+static const char* test_newest_backup() {
+    int count = 0;
+    BackupEntry* entries = list_backups_sorted(&count);
+    return count > 0 ? entries[count - 1].path : NULL;
+}
+
+/*===== Product index =====*/
+/*Inserting, growing, deleting (backward shift) and reinserting keep every lookup right*/
+static int test_index() {
+    /*The first insert into an index that was never built builds it*/
+    index_reset();
+    TEST_CHECK(index_insert(INDEX_TEST_IDS * 7919 + 2, 7));
+    TEST_CHECK(index_lookup(INDEX_TEST_IDS * 7919 + 2) == 7);
+    TEST_CHECK(index_remove(INDEX_TEST_IDS * 7919 + 2));
+
+    for (int i = 1; i <= INDEX_TEST_IDS; i++) {
+        int id = i % 2 ? i : i * 7919; // Clustered and scattered keys
+        TEST_CHECK(index_insert(id, (long)i));
+    }
+    for (int i = 1; i <= INDEX_TEST_IDS; i++) {
+        TEST_CHECK(index_lookup(i % 2 ? i : i * 7919) == (long)i);
+    }
+
+    /*Deleting every third key must not hide the keys probed past it*/
+    for (int i = 3; i <= INDEX_TEST_IDS; i += 3) {
+        TEST_CHECK(index_remove(i % 2 ? i : i * 7919));
+    }
+    TEST_CHECK(!index_remove(3));
+    for (int i = 1; i <= INDEX_TEST_IDS; i++) {
+        long expected = i % 3 == 0 ? -1 : (long)i;
+        TEST_CHECK(index_lookup(i % 2 ? i : i * 7919) == expected);
+    }
+
+    /*Reinserting and replacing slots*/
+    for (int i = 3; i <= INDEX_TEST_IDS; i += 3) {
+        TEST_CHECK(index_insert(i % 2 ? i : i * 7919, (long)i + INDEX_TEST_IDS));
+    }
+    TEST_CHECK(index_insert(1, 42));
+    TEST_CHECK(index_lookup(1) == 42);
+    for (int i = 2; i <= INDEX_TEST_IDS; i++) {
+        long expected = i % 3 == 0 ? (long)i + INDEX_TEST_IDS : (long)i;
+        TEST_CHECK(index_lookup(i % 2 ? i : i * 7919) == expected);
+    }
+    TEST_CHECK(index_lookup(INDEX_TEST_IDS * 7919 + 1) == -1);
+    return 0;
+}
+
+/*===== Tombstones and compaction =====*/
+/*Deletes leave tombstones whose slots are reused, and compaction reclaims them once enough are dead*/
+static int test_compaction() {
+    inventory_init();
+    for (int id = 1; id <= COMPACT_TEST_RECORDS; id++) {
+        TEST_CHECK(add_product(test_product(id, "Compact", id)));
+    }
+
+    /*One delete is only a tombstone, and the next add takes its slot*/
+    TEST_CHECK(delete_product(1));
+    TEST_CHECK(store_dead_count() == 1);
+    TEST_CHECK(store_count() == COMPACT_TEST_RECORDS);
+    TEST_CHECK(add_product(test_product(COMPACT_TEST_RECORDS + 1, "Compact", 1)));
+    TEST_CHECK(store_dead_count() == 0);
+    TEST_CHECK(store_count() == COMPACT_TEST_RECORDS);
+
+    /*Deleting most of the catalogue compacts it, possibly more than once*/
+    int deleted = COMPACT_TEST_RECORDS * 3 / 4;
+    for (int id = 2; id <= deleted; id++) {
+        TEST_CHECK(delete_product(id));
+    }
+    long live = COMPACT_TEST_RECORDS + 1 - deleted;
+    TEST_CHECK(store_live_count() == live);
+    TEST_CHECK(store_dead_count() < MIN_COMPACTION_RECORDS);
+    TEST_CHECK(store_count() == live + store_dead_count());
+
+    /*Survivors moved but are still found, deleted products are not*/
+    for (int id = 1; id <= COMPACT_TEST_RECORDS + 1; id++) {
+        TEST_CHECK(test_stock(id) == (id > deleted ? (id > COMPACT_TEST_RECORDS ? 1 : id) : -1));
+    }
+    TEST_CHECK(stats_get()->product_count == live);
+    TEST_CHECK(verify_inventory_stats(false));
+
+    /*An explicit compaction leaves no tombstones and a file of live records only*/
+    TEST_CHECK(compact_inventory());
+    TEST_CHECK(store_dead_count() == 0 && store_count() == live);
+    store_close();
+    struct stat st;
+    TEST_CHECK(stat(FILENAME, &st) == 0 && st.st_size == live * (long)sizeof(Product));
+    TEST_CHECK(test_stock(COMPACT_TEST_RECORDS) == COMPACT_TEST_RECORDS);
+    return 0;
+}
+
+/*===== Transaction log group commit =====*/
+/*A lone record reaches the file once it is flush_seconds old, with nothing else logged after it*/
+static int test_log_flush() {
+#ifdef _WIN32
+    return TEST_SKIPPED; // No flusher thread: the next record or commit writes it
+#else
+    LogWriterConfig config = load_log_writer_config();
+    config.flush_records = LOG_RING_CAPACITY;
+    config.flush_seconds = 1;
+    log_set_config(config);
+
+    inventory_init();
+    TEST_CHECK(log_open());
+    Transaction t = { .timestamp = time(NULL), .type = ADD, .product_id = 1, .user = "test" };
+    log_transaction(t);
+    TEST_CHECK(log_pending() == 1);
+    TEST_CHECK(log_file_records(LOG_FILE) == 0);
+
+    /*At most flush_seconds plus the clock's one-second resolution*/
+    time_t deadline = time(NULL) + config.flush_seconds + 2;
+    while (log_pending() > 0 && time(NULL) <= deadline) {
+        usleep(50000);
+    }
+    TEST_CHECK(log_pending() == 0);
+    TEST_CHECK(log_file_records(LOG_FILE) == 1);
+    return 0;
+#endif
+}
+
+/*===== Bulk stock movements =====*/
+/*One batch applies movements in input order per product and reports each outcome*/
+static int test_movements() {
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Bulk", 10)));
+    TEST_CHECK(add_product(test_product(2, "Bulk", 0)));
+    TEST_CHECK(add_product(test_product(3, "Bulk", INT_MAX - 5)));
+
+    StockMovement m[] = {
+        { .id = 1, .type = SALE, .quantity = 4 },
+        { .id = 2, .type = RESTOCK, .quantity = 7 },
+        { .id = 1, .type = SALE, .quantity = 7 }, // Only 6 left after the first sale
+        { .id = 3, .type = RESTOCK, .quantity = 6 }, // Would pass INT_MAX
+        { .id = 99, .type = SALE, .quantity = 1 },
+        { .id = 2, .type = SALE, .quantity = 0 },
+        { .id = 1, .type = SALE, .quantity = 6 },
+        { .id = 3, .type = RESTOCK, .quantity = 5 } // Exactly INT_MAX
+    };
+    int count = (int)(sizeof(m) / sizeof(m[0]));
+    TEST_CHECK(apply_stock_movements(m, count) == 4);
+
+    TEST_CHECK(m[0].result == STOCK_OK && m[0].stock_after == 6);
+    TEST_CHECK(m[1].result == STOCK_OK && m[1].stock_after == 7);
+    TEST_CHECK(m[2].result == STOCK_INSUFFICIENT && m[2].stock_after == 6);
+    TEST_CHECK(m[3].result == STOCK_LIMIT_EXCEEDED && m[3].stock_after == INT_MAX - 5);
+    TEST_CHECK(m[4].result == STOCK_NOT_FOUND);
+    TEST_CHECK(m[5].result == STOCK_INVALID_QUANTITY);
+    TEST_CHECK(m[6].result == STOCK_OK && m[6].stock_after == 0);
+    TEST_CHECK(m[7].result == STOCK_OK && m[7].stock_after == INT_MAX);
+
+    TEST_CHECK(test_stock(1) == 0 && test_stock(2) == 7 && test_stock(3) == INT_MAX);
+    TEST_CHECK(stats_get()->out_of_stock_count == 1);
+    TEST_CHECK(verify_inventory_stats(false));
+    log_commit();
+    TEST_CHECK(log_record_count() == 3 + 4); // Three adds, then only the applied movements
+
+    /*The batch survives a restart*/
+    store_close();
+    TEST_CHECK(test_stock(1) == 0 && test_stock(2) == 7 && test_stock(3) == INT_MAX);
+    return 0;
+}
+
+/*===== Cached statistics =====*/
+/*Adds, updates and deletes keep the totals exact, and the sidecar carries them across a restart*/
+static int test_stats() {
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Tools", 20)));
+    TEST_CHECK(add_product(test_product(2, "Tools", 5)));
+    TEST_CHECK(add_product(test_product(3, "Paint", 0)));
+    TEST_CHECK(add_product(test_product(4, "Paint", 8)));
+
+    /*Moving a product to another category and deleting one from each*/
+    Product moved = test_product(2, "Paint", 12);
+    TEST_CHECK(update_product(2, moved));
+    TEST_CHECK(delete_product(1));
+    TEST_CHECK(delete_product(4));
+
+    const InventoryStats* s = stats_get();
+    TEST_CHECK(s->product_count == 2);
+    TEST_CHECK(s->units == 12);
+    TEST_CHECK(s->total_value == 12 * TEST_PRICE);
+    TEST_CHECK(s->low_stock_count == 0);
+    TEST_CHECK(s->out_of_stock_count == 1);
+    const CategoryStats* tools = stats_category("Tools");
+    TEST_CHECK(!tools || (tools->product_count == 0 && tools->units == 0 && tools->total_value == 0)); // Emptied, or unknown to a rebuilt index
+    const CategoryStats* paint = stats_category("Paint");
+    TEST_CHECK(paint && paint->product_count == 2 && paint->units == 12);
+    TEST_CHECK(verify_inventory_stats(false));
+
+    /*A clean shutdown saves the totals, and the next start loads them instead of rescanning*/
+    inventory_shutdown();
+    TEST_CHECK(stat(STATS_FILE, &(struct stat){ 0 }) == 0);
+    inventory_init();
+    s = stats_get();
+    TEST_CHECK(s->valid && s->product_count == 2 && s->units == 12 && s->out_of_stock_count == 1);
+    TEST_CHECK(verify_inventory_stats(false));
+    return 0;
+}
+
+/*===== Low-stock index =====*/
+/*Collecting the quantities a low-stock query returns, in its order (count, or -1)*/
+static int test_low_stock(int threshold, int* quantities, int max) {
+    long* slots = NULL;
+    int count = stock_index_query(threshold, &slots);
+    for (int i = 0; i < count && i < max; i++) {
+        quantities[i] = store_record(slots[i])->quantity;
+    }
+    free(slots);
+    return count;
+}
+
+/*Queries list every product below the threshold lowest first, negative and overflow stock included*/
+static int test_stock_index() {
+    inventory_init();
+    int stock[] = { 5, -3, 0, STOCK_BUCKETS + 10, -10, STOCK_BUCKETS - 1, 2, STOCK_BUCKETS };
+    int products = (int)(sizeof(stock) / sizeof(stock[0]));
+    for (int i = 0; i < products; i++) {
+        TEST_CHECK(add_product(test_product(i + 1, "Stock", stock[i])));
+    }
+
+    int q[8];
+    TEST_CHECK(test_low_stock(0, q, 8) == 2 && q[0] == -10 && q[1] == -3);
+    TEST_CHECK(test_low_stock(-5, q, 8) == 1 && q[0] == -10);
+    TEST_CHECK(test_low_stock(6, q, 8) == 5);
+    TEST_CHECK(q[0] == -10 && q[1] == -3 && q[2] == 0 && q[3] == 2 && q[4] == 5);
+    TEST_CHECK(test_low_stock(STOCK_BUCKETS + 20, q, 8) == products);
+    for (int i = 1; i < products; i++) {
+        TEST_CHECK(q[i - 1] <= q[i]);
+    }
+    TEST_CHECK(q[products - 1] == STOCK_BUCKETS + 10);
+
+    /*Updates move products between the negative, exact and overflow buckets*/
+    Product p = test_product(2, "Stock", 7);
+    TEST_CHECK(update_product(2, p));
+    p = test_product(4, "Stock", -1);
+    TEST_CHECK(update_product(4, p));
+    TEST_CHECK(test_low_stock(0, q, 8) == 2 && q[0] == -10 && q[1] == -1);
+    TEST_CHECK(test_low_stock(8, q, 8) == 6 && q[5] == 7);
+    return 0;
+}
+
+/*===== Category index =====*/
+/*Checking that a category's posting list holds exactly the given product IDs*/
+static bool test_category_holds(const char* category, const int* ids, int count) {
+    const long* slots = NULL;
+    if (category_postings(category_find(category), &slots) != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        bool found = false;
+        for (int j = 0; j < count && !found; j++) {
+            found = store_record(slots[j])->id == ids[i];
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*Posting lists and per-category totals follow adds, category changes and deletes*/
+static int test_category() {
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Garden", 4)));
+    TEST_CHECK(add_product(test_product(2, "Kitchen", 6)));
+    TEST_CHECK(add_product(test_product(3, "Garden", 10)));
+    TEST_CHECK(add_product(test_product(4, "Garden", 1)));
+
+    int id = category_find("Garden");
+    TEST_CHECK(id >= 0 && category_intern("Garden") == id);
+    TEST_CHECK(strcmp(category_name(id), "Garden") == 0);
+    TEST_CHECK(category_find("garden") == -1 && category_find("Bathroom") == -1);
+    TEST_CHECK(test_category_holds("Garden", (int[]){ 1, 3, 4 }, 3));
+    TEST_CHECK(count_by_category("Garden") == 3);
+    TEST_CHECK(value_by_category("Garden") == 15 * TEST_PRICE);
+    TEST_CHECK(count_by_category("Bathroom") == 0 && value_by_category("Bathroom") == 0);
+
+    /*Moving one product across and deleting another*/
+    TEST_CHECK(update_product(3, test_product(3, "Kitchen", 10)));
+    TEST_CHECK(delete_product(4));
+    TEST_CHECK(test_category_holds("Garden", (int[]){ 1 }, 1));
+    TEST_CHECK(test_category_holds("Kitchen", (int[]){ 2, 3 }, 2));
+    TEST_CHECK(count_by_category("Garden") == 1 && value_by_category("Garden") == 4 * TEST_PRICE);
+    TEST_CHECK(count_by_category("Kitchen") == 2 && value_by_category("Kitchen") == 16 * TEST_PRICE);
+
+    /*A rebuild from the store files the same products*/
+    TEST_CHECK(category_index_build());
+    TEST_CHECK(test_category_holds("Garden", (int[]){ 1 }, 1));
+    TEST_CHECK(test_category_holds("Kitchen", (int[]){ 2, 3 }, 2));
+    return 0;
+}
+
+/*===== Name search =====*/
+/*Adding a product with a given name*/
+static bool test_add_named(int id, const char* name) {
+    Product p = test_product(id, "Tools", 1);
+    snprintf(p.name, sizeof(p.name), "%s", name);
+    return add_product(p);
+}
+
+/*Checking a search returns exactly the given IDs, in order*/
+static bool test_search_is(const char* query, const int* ids, int count) {
+    Product results[MAX_SEARCH_RESULTS];
+    if (search_products_by_name(query, results, MAX_SEARCH_RESULTS) != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (results[i].id != ids[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*Matches rank prefix, then word start, then substring (shorter names first) and follow renames and deletes*/
+static int test_name_search() {
+    inventory_init();
+    TEST_CHECK(test_add_named(1, "Steel Hammer"));
+    TEST_CHECK(test_add_named(2, "Hammer"));
+    TEST_CHECK(test_add_named(3, "Sledgehammer"));
+    TEST_CHECK(test_add_named(4, "Claw hammer drill"));
+    TEST_CHECK(test_add_named(5, "Saw"));
+
+    TEST_CHECK(test_search_is("hammer", (int[]){ 2, 1, 4, 3 }, 4));
+    TEST_CHECK(test_search_is("HAM", (int[]){ 2, 1, 4, 3 }, 4));
+    TEST_CHECK(test_search_is("sa", (int[]){ 5 }, 1)); // Shorter than a trigram
+    TEST_CHECK(test_search_is("drills", NULL, 0));
+    TEST_CHECK(test_search_is("", NULL, 0));
+
+    /*Truncated to the best matches*/
+    Product results[2];
+    TEST_CHECK(search_products_by_name("hammer", results, 2) == 2);
+    TEST_CHECK(results[0].id == 2 && results[1].id == 1);
+
+    /*A rename is found under its new name only, a deleted product not at all*/
+    Product renamed = test_product(5, "Tools", 1);
+    snprintf(renamed.name, sizeof(renamed.name), "Hammer saw");
+    TEST_CHECK(update_product(5, renamed));
+    TEST_CHECK(delete_product(1));
+    TEST_CHECK(test_search_is("hammer", (int[]){ 2, 5, 4, 3 }, 4));
+    TEST_CHECK(test_search_is("saw", (int[]){ 5 }, 1));
+    TEST_CHECK(test_search_is("steel", NULL, 0));
+    return 0;
+}
+
+/*===== Column kernels =====*/
+/*The SIMD kernels agree with a plain loop over every length, including the scalar tails*/
+static int test_columns() {
+    ColumnSnapshot snap = { 0 };
+    snap.price = malloc(COLUMN_TEST_SLOTS * sizeof(float));
+    snap.quantity = malloc(COLUMN_TEST_SLOTS * sizeof(int));
+    TEST_CHECK(snap.price && snap.quantity);
+    for (int i = 0; i < COLUMN_TEST_SLOTS; i++) {
+        bool dead = i % 7 == 3;
+        snap.price[i] = dead ? 0.0f : 0.25f * (i % 40);
+        snap.quantity[i] = dead ? COLUMN_DEAD_QUANTITY : (i % 5 == 0 ? -i : i % 23);
+    }
+
+    for (long n = 0; n <= COLUMN_TEST_SLOTS; n += n < 40 ? 1 : 97) {
+        snap.count = n;
+        double value = 0.0;
+        long zero = 0, low = 0, negative = 0;
+        for (long i = 0; i < n; i++) {
+            value += (double)snap.price[i] * snap.quantity[i];
+            zero += snap.quantity[i] == 0;
+            low += snap.quantity[i] >= 1 && snap.quantity[i] < LOW_STOCK_LIMIT;
+            negative += snap.quantity[i] < 0;
+        }
+        TEST_CHECK(column_total_value(&snap) == value);
+        TEST_CHECK(column_count_range(&snap, 0, 1) == zero);
+        TEST_CHECK(column_count_range(&snap, 1, LOW_STOCK_LIMIT) == low);
+        TEST_CHECK(column_count_range(&snap, INT_MIN, 0) == negative);
+    }
+    free(snap.price);
+    free(snap.quantity);
+
+    /*The maintained snapshot follows the store*/
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Columns", 4)));
+    TEST_CHECK(add_product(test_product(2, "Columns", 0)));
+    const ColumnSnapshot* columns = column_snapshot_get();
+    TEST_CHECK(columns && columns->count == 2);
+    TEST_CHECK(delete_product(1));
+    TEST_CHECK(add_product(test_product(3, "Columns", 6)));
+    TEST_CHECK(column_total_value(columns) == 6 * TEST_PRICE);
+    TEST_CHECK(column_count_range(columns, 0, 1) == 1);
+    return 0;
+}
+
+/*===== Indexed log queries =====*/
+/*Logging one record for a product at a given time*/
+static void test_log_at(time_t timestamp, int product_id) {
+    Transaction t = { .timestamp = timestamp, .type = RESTOCK, .product_id = product_id, .user = "test" };
+    log_transaction(t);
+}
+
+/*Checking a query result is in log order: timestamps never go down*/
+static bool test_log_ordered(const Transaction* t, long count) {
+    for (long i = 1; i < count; i++) {
+        if (t[i].timestamp < t[i - 1].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifndef _WIN32
+/*Logging records for product 1 while the main thread queries*/
+static void* test_log_writer(void* arg) {
+    time_t start = *(const time_t*)arg;
+    for (int i = 0; i < LOG_QUERY_TEST_RECORDS; i++) {
+        test_log_at(start + i, 1);
+    }
+    return NULL;
+}
+#endif
+
+/*Range and product scans span several time blocks, survive a reopen and see concurrent appends*/
+static int test_log_query() {
+    inventory_init();
+    TEST_CHECK(log_open());
+    time_t start = 1000000;
+    for (int i = 0; i < LOG_QUERY_TEST_RECORDS; i++) {
+        test_log_at(start + i, i % 3 + 1);
+    }
+
+    Transaction* t = NULL;
+    TEST_CHECK(log_query_range(start + 100, start + 399, &t) == 300);
+    TEST_CHECK(t[0].timestamp == start + 100 && t[299].timestamp == start + 399);
+    TEST_CHECK(test_log_ordered(t, 300));
+    free(t);
+    TEST_CHECK(log_query_range(start - 10, start - 1, &t) == 0);
+    free(t);
+
+    long per_product = LOG_QUERY_TEST_RECORDS / 3;
+    TEST_CHECK(log_query_product(2, &t) == per_product);
+    for (long i = 0; i < per_product; i++) {
+        TEST_CHECK(t[i].product_id == 2 && t[i].timestamp == start + 3 * i + 1);
+    }
+    free(t);
+    TEST_CHECK(log_query_product(99, &t) == 0);
+    free(t);
+
+    /*The saved index is reused and extended after a restart*/
+    log_close();
+    struct stat st;
+    TEST_CHECK(stat(LOG_INDEX_FILE, &st) == 0);
+    TEST_CHECK(log_open());
+    test_log_at(start + LOG_QUERY_TEST_RECORDS, 2);
+    TEST_CHECK(log_query_product(2, &t) == per_product + 1);
+    TEST_CHECK(t[per_product].timestamp == start + LOG_QUERY_TEST_RECORDS);
+    free(t);
+
+#ifndef _WIN32
+    /*Queries running beside a writer never lose or repeat records*/
+    log_close();
+    TEST_CHECK(log_open());
+    time_t later = start + 2 * LOG_QUERY_TEST_RECORDS;
+    pthread_t writer;
+    TEST_CHECK(pthread_create(&writer, NULL, test_log_writer, &later) == 0);
+    long seen = 0;
+    while (seen < LOG_QUERY_TEST_RECORDS) {
+        long count = log_query_range(later, later + LOG_QUERY_TEST_RECORDS, &t);
+        bool ordered = count >= 0 && test_log_ordered(t, count);
+        for (long i = 1; ordered && i < count; i++) {
+            ordered = t[i].timestamp == t[i - 1].timestamp + 1;
+        }
+        free(t);
+        TEST_CHECK(ordered && count >= seen);
+        seen = count;
+    }
+    pthread_join(writer, NULL);
+    TEST_CHECK(log_query_product(1, &t) == per_product + LOG_QUERY_TEST_RECORDS);
+    TEST_CHECK(test_log_ordered(t, per_product + LOG_QUERY_TEST_RECORDS));
+    free(t);
+#endif
+    return 0;
+}
+
+/*===== LZ codec =====*/
+/*Round-tripping catalogue records and incompressible bytes within the given capacities*/
+static int test_lz() {
+    size_t size = LZ_TEST_RECORDS * sizeof(Product);
+    Product* records = calloc(LZ_TEST_RECORDS, sizeof(Product));
+    unsigned char* noise = malloc(size);
+    unsigned char* packed = malloc(lz_bound(size));
+    unsigned char* unpacked = malloc(size);
+    TEST_CHECK(records && noise && packed && unpacked);
+
+    for (int i = 0; i < LZ_TEST_RECORDS; i++) {
+        records[i] = test_product(i + 1, i % 7 ? "Hardware" : "Garden", i % 250);
+    }
+    size_t n = lz_compress((const unsigned char*)records, size, packed, lz_bound(size));
+    TEST_CHECK(n > 0 && n < size / 2);
+    TEST_CHECK(lz_decompress(packed, n, unpacked, size) == (long)size);
+    TEST_CHECK(memcmp(records, unpacked, size) == 0);
+    TEST_CHECK(lz_decompress(packed, n, unpacked, size - 1) == -1); // Never writes past capacity
+
+    unsigned int state = 12345;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1103515245u + 12345u;
+        noise[i] = (unsigned char)(state >> 24);
+    }
+    n = lz_compress(noise, size, packed, lz_bound(size));
+    TEST_CHECK(n > 0 && n <= lz_bound(size));
+    TEST_CHECK(lz_decompress(packed, n, unpacked, size) == (long)size);
+    TEST_CHECK(memcmp(noise, unpacked, size) == 0);
+    TEST_CHECK(lz_compress(noise, size, packed, size / 2) == 0); // Does not fit
+
+    free(records);
+    free(noise);
+    free(packed);
+    free(unpacked);
+    return 0;
+}
+
+/*===== Log segments =====*/
+/*Rotated segments are sealed in the background while logging and reading go on, and no record is lost*/
+static int test_segments() {
+    LogWriterConfig config = load_log_writer_config();
+    config.flush_records = 16;
+    config.segment_bytes = SEGMENT_TEST_RECORDS / 8 * (long)sizeof(Transaction);
+    log_set_config(config);
+
+    inventory_init();
+    TEST_CHECK(log_open());
+    Transaction t = { .timestamp = time(NULL), .type = SALE, .user = "test" };
+    Transaction back;
+    for (int i = 0; i < SEGMENT_TEST_RECORDS; i++) {
+        t.product_id = i + 1;
+        log_transaction(t);
+
+        /*Reading an earlier record, wherever it is at the moment*/
+        if (i % 50 == 49) {
+            TEST_CHECK(log_commit());
+            TEST_CHECK(log_read(i / 2, &back, 1) == 1 && back.product_id == i / 2 + 1);
+        }
+
+        /*The active segment keeps growing while a seal runs, so reopening lets several finish*/
+        if (i % 250 == 249) {
+            log_close();
+            TEST_CHECK(log_open());
+        }
+    }
+    TEST_CHECK(log_commit());
+    TEST_CHECK(log_record_count() == SEGMENT_TEST_RECORDS);
+
+    /*Closing waits for the last seal*/
+    log_close();
+    struct stat st;
+    TEST_CHECK(stat(LOG_SEALING_FILE, &st) != 0);
+    TEST_CHECK(log_sealed_records() >= SEGMENT_TEST_RECORDS / 2);
+    TEST_CHECK(log_record_count() == SEGMENT_TEST_RECORDS);
+    for (int i = 0; i < SEGMENT_TEST_RECORDS; i++) {
+        TEST_CHECK(log_read(i, &back, 1) == 1 && back.product_id == i + 1);
+    }
+    return 0;
+}
+
+/*===== Backups =====*/
+/*An incremental backup rebuilds to the file it captured, and restores it*/
+static int test_backup() {
+    FILE* cfg = fopen(BACKUP_CONFIG_FILE, "w");
+    TEST_CHECK(cfg != NULL);
+    fprintf(cfg, "incremental=1\n");
+    fclose(cfg);
+
+    inventory_init();
+    for (int id = 1; id <= BACKUP_TEST_RECORDS; id++) {
+        TEST_CHECK(add_product(test_product(id, "Backup", 100)));
+    }
+    TEST_CHECK(create_backup());
+    const char* full = test_newest_backup();
+    TEST_CHECK(full != NULL && !is_delta_backup(full));
+
+    /*Changes in two blocks only*/
+    test_next_second();
+    sell_product(1, 10);
+    sell_product(BACKUP_TEST_RECORDS, 20);
+    TEST_CHECK(create_backup());
+    char delta[256];
+    snprintf(delta, sizeof(delta), "%s", test_newest_backup());
+    TEST_CHECK(is_delta_backup(delta));
+
+    store_flush();
+    TEST_CHECK(rebuild_from_chain(delta, "rebuilt.dat"));
+    TEST_CHECK(test_same_file("rebuilt.dat", FILENAME));
+    remove("rebuilt.dat");
+
+    /*Later changes are undone by restoring the delta*/
+    sell_product(2, 30);
+    TEST_CHECK(delete_product(3));
+    TEST_CHECK(restore_backup(delta));
+    TEST_CHECK(test_stock(1) == 90);
+    TEST_CHECK(test_stock(2) == 100);
+    TEST_CHECK(test_stock(3) == 100);
+    TEST_CHECK(test_stock(BACKUP_TEST_RECORDS) == 80);
+    TEST_CHECK(stats_get()->units == BACKUP_TEST_RECORDS * 100L - 30);
+    TEST_CHECK(verify_inventory_stats(false));
+    return 0;
+}
+
+/*===== File copy =====*/
+/*Writing a file of patterned bytes*/
+static bool test_write_pattern(const char* path, long size) {
+    FILE* fptr = fopen(path, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = true;
+    for (long i = 0; ok && i < size; i++) {
+        ok = fputc((int)((i * 131 + i / 4096) & 0xFF), fptr) != EOF;
+    }
+    return fclose(fptr) == 0 && ok;
+}
+
+/*The fast paths and the buffered fallback copy the same bytes and compute the same checksum*/
+static int test_copy() {
+    TEST_CHECK(test_write_pattern("source.dat", COPY_TEST_BYTES));
+    unsigned int expected;
+    TEST_CHECK(checksum_file("source.dat", 0, &expected));
+
+    for (int forced = 0; forced <= 1; forced++) {
+        set_copy_fallback(forced != 0);
+        remove("copy.dat");
+        TEST_CHECK(copy_file("source.dat", "copy.dat"));
+        TEST_CHECK(test_same_file("source.dat", "copy.dat"));
+        TEST_CHECK(last_copy_stats()->bytes == COPY_TEST_BYTES);
+        TEST_CHECK(last_copy_stats()->method != COPY_NONE);
+
+        unsigned int crc;
+        remove("copy.dat");
+        TEST_CHECK(copy_file_checked("source.dat", "copy.dat", &crc));
+        TEST_CHECK(crc == expected);
+        TEST_CHECK(test_same_file("source.dat", "copy.dat"));
+        if (forced) {
+            TEST_CHECK(last_copy_stats()->method == COPY_BUFFERED);
+        }
+
+        /*An existing, longer destination is truncated to the source*/
+        TEST_CHECK(test_write_pattern("copy.dat", COPY_TEST_BYTES + 5000));
+        TEST_CHECK(copy_file("source.dat", "copy.dat"));
+        TEST_CHECK(test_same_file("source.dat", "copy.dat"));
+
+        /*An empty file copies to an empty file with the empty checksum*/
+        TEST_CHECK(test_write_pattern("empty.dat", 0));
+        TEST_CHECK(copy_file_checked("empty.dat", "copy.dat", &crc) && crc == 0);
+        struct stat st;
+        TEST_CHECK(stat("copy.dat", &st) == 0 && st.st_size == 0);
+    }
+    set_copy_fallback(false);
+    TEST_CHECK(!copy_file("missing.dat", "copy.dat"));
+    return 0;
+}
+
+/*===== Backup checksums =====*/
+/*Flipping one byte of a file, counted from its end*/
+static bool test_flip_byte(const char* path, long from_end) {
+    FILE* fptr = fopen(path, "r+b");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fseek(fptr, -from_end, SEEK_END) == 0;
+    int c = ok ? fgetc(fptr) : EOF;
+    ok = c != EOF && fseek(fptr, -from_end, SEEK_END) == 0 && fputc(c ^ 0x5A, fptr) != EOF;
+    return fclose(fptr) == 0 && ok;
+}
+
+/*A corrupted full or delta backup fails its check and is never restored*/
+static int test_checksum() {
+    FILE* cfg = fopen(BACKUP_CONFIG_FILE, "w");
+    TEST_CHECK(cfg != NULL);
+    fprintf(cfg, "incremental=1\n");
+    fclose(cfg);
+
+    inventory_init();
+    for (int id = 1; id <= BACKUP_TEST_RECORDS; id++) {
+        TEST_CHECK(add_product(test_product(id, "Checksum", 50)));
+    }
+    TEST_CHECK(create_backup());
+    char full[256];
+    snprintf(full, sizeof(full), "%s", test_newest_backup());
+    TEST_CHECK(verify_backup_checksum(full) == 1);
+    TEST_CHECK(validate_backup_integrity(full));
+
+    test_next_second();
+    sell_product(1, 5);
+    TEST_CHECK(create_backup());
+    char delta[256];
+    snprintf(delta, sizeof(delta), "%s", test_newest_backup());
+    TEST_CHECK(is_delta_backup(delta) && verify_backup_checksum(delta) == 1);
+
+    /*Corrupting the delta's payload: its checksum and the rebuild both catch it*/
+    sell_product(2, 7);
+    TEST_CHECK(test_flip_byte(delta, 1));
+    TEST_CHECK(verify_backup_checksum(delta) == 0);
+    TEST_CHECK(!restore_backup(delta));
+    TEST_CHECK(test_stock(2) == 43);
+
+    /*The intact full backup restores, checked in the same pass as the copy*/
+    TEST_CHECK(restore_backup(full));
+    TEST_CHECK(test_stock(1) == 50 && test_stock(2) == 50);
+    sell_product(1, 5);
+    sell_product(2, 7);
+
+    /*Corrupting the full backup: the restore copy does not match the stored CRC*/
+    TEST_CHECK(test_flip_byte(full, sizeof(Product) + 1));
+    TEST_CHECK(verify_backup_checksum(full) == 0);
+    TEST_CHECK(!validate_backup_integrity(full));
+    TEST_CHECK(!restore_backup(full));
+    struct stat st;
+    TEST_CHECK(stat(RESTORE_TEMP_FILE, &st) != 0);
+    TEST_CHECK(test_stock(1) == 45 && test_stock(2) == 43);
+    TEST_CHECK(verify_inventory_stats(false));
+    return 0;
+}
+
+/*===== Backup catalog =====*/
+/*Filling in a catalog entry for a backup taken at the given second of 2024-01-01*/
+static BackupEntry test_entry(int second, const char* ext, const char* parent) {
+    BackupEntry e;
+    memset(&e, 0, sizeof(e));
+    snprintf(e.filename, sizeof(e.filename), "inventory_20240101_0000%02d%s", second, ext);
+    snprintf(e.path, sizeof(e.path), "%s/%s", BACKUP_DIR, e.filename);
+    e.timestamp = get_backup_timestamp(e.filename);
+    e.file_size = (size_t)(1000 + second);
+    e.is_valid = parent == NULL; // Deltas here go without a checksum
+    if (e.is_valid) {
+        snprintf(e.checksum, sizeof(e.checksum), BACKUP_CHECKSUM_FORMAT, (unsigned int)second);
+    }
+    if (parent) {
+        snprintf(e.parent, sizeof(e.parent), "%s", parent);
+    }
+    return e;
+}
+
+/*Checking the catalog lists exactly these seconds, oldest first*/
+static bool test_catalog_is(const int* seconds, int count) {
+    BackupCatalog* catalog = backup_catalog_get();
+    if (catalog->count != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        BackupEntry e = test_entry(seconds[i], "", NULL);
+        if (strncmp(catalog->entries[i].filename, e.filename, strlen(e.filename)) != 0 ||
+            catalog->entries[i].file_size != e.file_size ||
+            (i > 0 && catalog->entries[i - 1].timestamp > catalog->entries[i].timestamp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*Adds and removals are journalled, replayed in order on the next load, and compacted*/
+static int test_catalog() {
+    test_mkdir(BACKUP_DIR);
+    BackupEntry full = test_entry(10, ".bak", NULL);
+    TEST_CHECK(backup_catalog_add(&full));
+    BackupEntry older = test_entry(5, ".bak", NULL);
+    TEST_CHECK(backup_catalog_add(&older)); // Filed before the newer one
+    BackupEntry delta = test_entry(20, BACKUP_DELTA_EXT, full.filename);
+    TEST_CHECK(backup_catalog_add(&delta));
+    TEST_CHECK(backup_catalog_remove(older.filename));
+    TEST_CHECK(!backup_catalog_remove(older.filename));
+
+    /*A torn last line (crash mid-append) is skipped*/
+    FILE* fptr = fopen(BACKUP_CATALOG_FILE, "a");
+    TEST_CHECK(fptr != NULL);
+    fprintf(fptr, "%c 1704067230 12", CATALOG_ADD_MARK);
+    fclose(fptr);
+
+    backup_catalog_reset();
+    TEST_CHECK(test_catalog_is((int[]){ 10, 20 }, 2));
+    const BackupEntry* e = &backup_catalog_get()->entries[1];
+    TEST_CHECK(strcmp(e->parent, full.filename) == 0 && !e->is_valid);
+    e = &backup_catalog_get()->entries[0];
+    TEST_CHECK(e->is_valid && strcmp(e->checksum, full.checksum) == 0 && e->parent[0] == '\0');
+    TEST_CHECK(strcmp(e->path, full.path) == 0);
+    TEST_CHECK(backup_catalog_find(delta.filename) == 1 && backup_catalog_find(older.filename) == -1);
+
+    /*Removal lines do not pile up: the journal is rewritten once they dominate*/
+    for (int second = 30; second < 60; second++) {
+        BackupEntry extra = test_entry(second, ".bak", NULL);
+        TEST_CHECK(backup_catalog_add(&extra));
+    }
+    for (int second = 30; second < 60; second++) {
+        TEST_CHECK(backup_catalog_remove(test_entry(second, ".bak", NULL).filename));
+    }
+    TEST_CHECK(backup_catalog_get()->journal_lines <= 2 * 2 + 16);
+    backup_catalog_reset();
+    TEST_CHECK(test_catalog_is((int[]){ 10, 20 }, 2));
+
+    /*Without a catalog file the directory is scanned instead*/
+    remove(BACKUP_CATALOG_FILE);
+    fptr = fopen(full.path, "wb");
+    TEST_CHECK(fptr != NULL);
+    fclose(fptr);
+    backup_catalog_reset();
+    TEST_CHECK(backup_catalog_get()->count == 1);
+    TEST_CHECK(strcmp(backup_catalog_get()->entries[0].filename, full.filename) == 0);
+    struct stat st;
+    TEST_CHECK(stat(BACKUP_CATALOG_FILE, &st) == 0);
+    backup_catalog_reset();
+    return 0;
+}
+
+/*===== Online snapshots =====*/
+/*Counting the calls of the freeze hook*/
+static void test_count_freeze(void* context) {
+    (*(int*)context)++;
+}
+
+/*A snapshot keeps returning the records as they were when it began, while writes go on*/
+static int test_snapshot() {
+    inventory_init();
+    for (int id = 1; id <= SNAPSHOT_TEST_RECORDS; id++) {
+        TEST_CHECK(add_product(test_product(id, "Snapshot", id)));
+    }
+
+    int frozen = 0;
+    TEST_CHECK(store_snapshot_begin(test_count_freeze, &frozen));
+    TEST_CHECK(frozen == 1 && store_snapshot_active());
+    TEST_CHECK(!store_snapshot_begin(NULL, NULL)); // One at a time
+    TEST_CHECK(store_snapshot_count() == SNAPSHOT_TEST_RECORDS);
+
+    /*Changing every third record, deleting one and adding more after the captured end*/
+    for (int id = 1; id <= SNAPSHOT_TEST_RECORDS; id += 3) {
+        TEST_CHECK(update_product(id, test_product(id, "Changed", 0)));
+    }
+    TEST_CHECK(delete_product(2));
+    for (int id = SNAPSHOT_TEST_RECORDS + 1; id <= SNAPSHOT_TEST_RECORDS + 10; id++) {
+        TEST_CHECK(add_product(test_product(id, "Snapshot", 1)));
+    }
+
+    Product* seen = malloc(SNAPSHOT_TEST_RECORDS * sizeof(Product));
+    TEST_CHECK(seen != NULL);
+    TEST_CHECK(store_snapshot_read(0, SNAPSHOT_TEST_RECORDS, seen));
+    for (int i = 0; i < SNAPSHOT_TEST_RECORDS; i++) {
+        TEST_CHECK(seen[i].id == i + 1 && seen[i].quantity == i + 1);
+        TEST_CHECK(strcmp(seen[i].category, "Snapshot") == 0);
+    }
+    TEST_CHECK(!store_snapshot_read(SNAPSHOT_TEST_RECORDS, 1, seen));
+    free(seen);
+    store_snapshot_end();
+    TEST_CHECK(!store_snapshot_active());
+
+    /*The live store has every change*/
+    TEST_CHECK(test_stock(1) == 0 && test_stock(2) == -1 && test_stock(3) == 3);
+    TEST_CHECK(test_stock(SNAPSHOT_TEST_RECORDS + 10) == 1);
+
+    /*An online backup holds the state it started from, not the sales made while it ran*/
+    FILE* cfg = fopen(BACKUP_CONFIG_FILE, "w");
+    TEST_CHECK(cfg != NULL);
+    fprintf(cfg, "online=1\n");
+    fclose(cfg);
+    TEST_CHECK(create_backup());
+    for (int id = 3; id <= SNAPSHOT_TEST_RECORDS; id += 3) {
+        sell_product(id, 1);
+    }
+    TEST_CHECK(online_backup_finish(true) == ONLINE_BACKUP_DONE);
+    char backup[256];
+    snprintf(backup, sizeof(backup), "%s", test_newest_backup());
+    TEST_CHECK(verify_backup_checksum(backup) == 1);
+    TEST_CHECK(test_stock(3) == 2);
+
+    TEST_CHECK(restore_backup(backup));
+    TEST_CHECK(test_stock(1) == 0 && test_stock(2) == -1 && test_stock(3) == 3);
+    TEST_CHECK(test_stock(SNAPSHOT_TEST_RECORDS) == (SNAPSHOT_TEST_RECORDS % 3 == 1 ? 0 : SNAPSHOT_TEST_RECORDS));
+    TEST_CHECK(verify_inventory_stats(false));
+    return 0;
+}
+
+/*===== Point-in-time recovery =====*/
+/*Recovering to a past second, then recovering again without reviving the abandoned branch*/
+static int test_pitr() {
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Pitr", 10)));
+    TEST_CHECK(create_backup());
+
+    test_next_second();
+    sell_product(1, 3);
+    log_commit();
+    time_t target = time(NULL);
+
+    /*The branch the recovery abandons*/
+    test_next_second();
+    sell_product(1, 2);
+    TEST_CHECK(add_product(test_product(2, "Pitr", 50)));
+    TEST_CHECK(test_stock(1) == 5);
+
+    ReplayStats stats;
+    TEST_CHECK(recover_to_time(target, &stats));
+    TEST_CHECK(stats.applied == 1);
+    TEST_CHECK(test_stock(1) == 7);
+    TEST_CHECK(test_stock(2) == -1);
+    TEST_CHECK(stats_get()->units == 7 && stats_get()->product_count == 1);
+
+    /*New history continues from the recovered state*/
+    test_next_second();
+    restock_product(1, 4);
+    log_commit();
+    TEST_CHECK(recover_to_time(time(NULL), &stats));
+    TEST_CHECK(stats.superseded == 2);
+    TEST_CHECK(test_stock(1) == 11);
+    TEST_CHECK(test_stock(2) == -1);
+    TEST_CHECK(verify_inventory_stats(false));
+    return 0;
+}
+
+/*===== Write-ahead log =====*/
+static Product wal_slots[WAL_TEST_SLOTS];
+static bool wal_slot_live[WAL_TEST_SLOTS];
+
+/*Recovery target standing in for the data file*/
+static bool wal_test_apply(long slot, const Product* p) {
+    if (slot < 0 || slot >= WAL_TEST_SLOTS) {
+        return false;
+    }
+    wal_slot_live[slot] = p != NULL;
+    if (p) {
+        wal_slots[slot] = *p;
+    }
+    return true;
+}
+
+/*Committed writes are redone, a batch cut off before its commit is undone even with a later batch committed*/
+static int test_wal() {
+    Product a0 = test_product(1, "Wal", 10);
+    Product a1 = test_product(1, "Wal", 11);
+    Product a2 = test_product(1, "Wal", 12);
+    Product b0 = test_product(2, "Wal", 20);
+    Product b1 = test_product(2, "Wal", 21);
+    Product c1 = test_product(3, "Wal", 30);
+
+    TEST_CHECK(wal_open());
+    TEST_CHECK(wal_append(0, NULL, &a0));
+    TEST_CHECK(wal_append(1, NULL, &b0));
+    wal_begin_batch();
+    TEST_CHECK(wal_append(0, &a0, &a1));
+    TEST_CHECK(wal_end_batch());
+
+    /*This batch never gets its commit record*/
+    wal_begin_batch();
+    TEST_CHECK(wal_append(1, &b0, &b1));
+    TEST_CHECK(wal_append(2, NULL, &c1));
+    TEST_CHECK(wal_sync());
+    wal_close();
+
+    /*A later batch commits after the lost one*/
+    TEST_CHECK(wal_open());
+    wal_begin_batch();
+    TEST_CHECK(wal_append(0, &a1, &a2));
+    TEST_CHECK(wal_end_batch());
+    wal_close();
+
+    WalRecoveryStats stats;
+    TEST_CHECK(wal_recover(wal_test_apply, &stats));
+    TEST_CHECK(stats.redone == 6);
+    TEST_CHECK(stats.undone == 2);
+    TEST_CHECK(stats.discarded == 0);
+    TEST_CHECK(wal_slot_live[0] && wal_slots[0].quantity == 12);
+    TEST_CHECK(wal_slot_live[1] && wal_slots[1].quantity == 20);
+    TEST_CHECK(!wal_slot_live[2]); // Appended by the lost batch, so left a tombstone
+    return 0;
+}
+
+/*===== CSV import =====*/
+/*Writing a text file in one go*/
+static bool test_write_text(const char* path, const char* text) {
+    FILE* fptr = fopen(path, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fputs(text, fptr) >= 0;
+    return fclose(fptr) == 0 && ok;
+}
+
+/*Checking the name of a stored product*/
+static bool test_has_name(int id, const char* name) {
+    Product* p = get_product(id);
+    bool same = p && strcmp(p->name, name) == 0;
+    free(p);
+    return same;
+}
+
+/*Bad rows are rejected and counted, repeated IDs skipped, missing IDs numbered above the file's*/
+static int test_import() {
+    TEST_CHECK(test_write_text("catalogue.csv",
+        "\xEF\xBB\xBFid,name,price,quantity,category\r\n"
+        "5,Widget,1.5,10,Tools\r\n"
+        "5,Widget again,1.0,1,Tools\n"
+        ",Gadget,2.0,3,Tools\n"
+        "0,Gizmo,2.0,3,Toys\n"
+        "\n"
+        "7,,1.0,1,Toys\n"
+        "8,Bad price,abc,1,Toys\n"
+        "9,Bad quantity,1.0,-2,Toys\n"
+        "x,Bad id,1.0,1,Toys\n"
+        "10,Short,1.0\n"
+        "11,\"Quoted, name\",1.25,4,\"Home \"\"Garden\"\"\"\n"));
+
+    ImportStats stats;
+    TEST_CHECK(import_products("catalogue.csv", 0, &stats));
+    TEST_CHECK(stats.rows == 10);
+    TEST_CHECK(stats.imported == 4);
+    TEST_CHECK(stats.rejected == 5);
+    TEST_CHECK(stats.duplicates == 1);
+    TEST_CHECK(stats.ids_assigned == 2);
+
+    TEST_CHECK(test_has_name(5, "Widget") && test_stock(5) == 10);
+    TEST_CHECK(test_has_name(11, "Quoted, name"));
+    Product* quoted = get_product(11);
+    TEST_CHECK(quoted && strcmp(quoted->category, "Home \"Garden\"") == 0);
+    free(quoted);
+    TEST_CHECK(test_has_name(12, "Gadget"));
+    TEST_CHECK(test_has_name(13, "Gizmo"));
+    for (int id = 7; id <= 10; id++) {
+        TEST_CHECK(test_stock(id) == -1);
+    }
+
+    /*Headerless TSV without an ID column, then a row whose ID is already stored*/
+    TEST_CHECK(test_write_text("more.tsv", "Lamp\t3.5\t2\tHome\n"));
+    TEST_CHECK(import_products("more.tsv", 0, &stats));
+    TEST_CHECK(stats.imported == 1 && stats.ids_assigned == 1);
+    TEST_CHECK(test_has_name(14, "Lamp") && test_stock(14) == 2);
+    TEST_CHECK(test_write_text("again.csv", "5,Widget,1.5,99,Tools\n"));
+    TEST_CHECK(import_products("again.csv", 0, &stats));
+    TEST_CHECK(stats.imported == 0 && stats.duplicates == 1);
+    TEST_CHECK(test_stock(5) == 10);
+
+    TEST_CHECK(!import_products("missing.csv", 0, &stats));
+    return 0;
+}
+
+/*===== Data export =====*/
+/*Checking that a file holds exactly the given text*/
+static bool test_file_is(const char* path, const char* text) {
+    long size = 0;
+    unsigned char* data = test_read_file(path, &size);
+    bool same = data && size == (long)strlen(text) && memcmp(data, text, (size_t)size) == 0;
+    free(data);
+    return same;
+}
+
+/*Adding a product with the given name and category*/
+static bool test_add_text(int id, const char* name, const char* category) {
+    Product p = test_product(id, category, id + 3);
+    snprintf(p.name, sizeof(p.name), "%s", name);
+    return add_product(p);
+}
+
+/*Commas, quotes, line breaks and control characters survive both formats; filters narrow the rows*/
+static int test_export() {
+    TEST_CHECK(test_add_text(1, "Bolt, hex", "Tools"));
+    TEST_CHECK(test_add_text(2, "Say \"hi\"", "Tools"));
+    TEST_CHECK(test_add_text(3, "Back\\slash", "Line\nbreak"));
+    TEST_CHECK(test_add_text(4, "Tab\tname", "Toys"));
+    log_commit();
+
+    ExportFilter filter;
+    ExportStats stats;
+    export_filter_init(&filter);
+    TEST_CHECK(export_inventory("inventory.csv", &filter, &stats));
+    TEST_CHECK(stats.rows == 4);
+    TEST_CHECK(test_file_is("inventory.csv",
+        "id,name,price,quantity,category\n"
+        "1,\"Bolt, hex\",2.50,4,Tools\n"
+        "2,\"Say \"\"hi\"\"\",2.50,5,Tools\n"
+        "3,Back\\slash,2.50,6,\"Line\nbreak\"\n"
+        "4,Tab\tname,2.50,7,Toys\n"));
+
+    filter.format = EXPORT_JSONL;
+    TEST_CHECK(export_inventory("inventory.jsonl", &filter, &stats));
+    TEST_CHECK(stats.rows == 4);
+    TEST_CHECK(test_file_is("inventory.jsonl",
+        "{\"id\":1,\"name\":\"Bolt, hex\",\"price\":2.50,\"quantity\":4,\"category\":\"Tools\"}\n"
+        "{\"id\":2,\"name\":\"Say \\\"hi\\\"\",\"price\":2.50,\"quantity\":5,\"category\":\"Tools\"}\n"
+        "{\"id\":3,\"name\":\"Back\\\\slash\",\"price\":2.50,\"quantity\":6,\"category\":\"Line\\u000abreak\"}\n"
+        "{\"id\":4,\"name\":\"Tab\\u0009name\",\"price\":2.50,\"quantity\":7,\"category\":\"Toys\"}\n"));
+
+    /*Filters: one category, one product, one product's transactions*/
+    filter.format = EXPORT_CSV;
+    filter.category = "Tools";
+    TEST_CHECK(export_inventory("tools.csv", &filter, &stats) && stats.rows == 2);
+    filter.category = NULL;
+    filter.product_id = 4;
+    TEST_CHECK(export_inventory("one.csv", &filter, &stats) && stats.rows == 1);
+    TEST_CHECK(test_file_is("one.csv", "id,name,price,quantity,category\n4,Tab\tname,2.50,7,Toys\n"));
+    filter.product_id = 2;
+    TEST_CHECK(export_transactions("history.csv", &filter, &stats) && stats.rows == 1);
+    char history[1024] = { 0 };
+    FILE* fptr = fopen("history.csv", "rb");
+    TEST_CHECK(fptr);
+    size_t got = fread(history, 1, sizeof(history) - 1, fptr);
+    fclose(fptr);
+    TEST_CHECK(got > 0 && strstr(history, ",ADD,2,5,") && strstr(history, "\"\"hi\"\""));
+    return 0;
+}
+
+/*===== Workload traces =====*/
+/*Writing the first size bytes of a file to another (cutting a trace short)*/
+static bool test_truncate_copy(const char* from, const char* to, long cut) {
+    long size = 0;
+    unsigned char* data = test_read_file(from, &size);
+    FILE* fptr = data && size > cut ? fopen(to, "wb") : NULL;
+    bool ok = fptr && fwrite(data, 1, (size_t)(size - cut), fptr) == (size_t)(size - cut);
+    if (fptr) {
+        ok = fclose(fptr) == 0 && ok;
+    }
+    free(data);
+    return ok;
+}
+
+/*A recorded session replays call for call with the same outcomes; a trace cut inside a group fails*/
+static int test_trace() {
+    TEST_CHECK(trace_start("session.trace"));
+    TEST_CHECK(add_product(test_product(1, "Trace", 10)));
+    TEST_CHECK(add_product(test_product(2, "Trace", 5)));
+    TEST_CHECK(test_stock(1) == 10);
+    StockMovement group[2] = {
+        { .id = 1, .type = SALE, .quantity = 3 },
+        { .id = 2, .type = RESTOCK, .quantity = 4 }
+    };
+    TEST_CHECK(apply_stock_movements(group, 2) == 2);
+    sell_product(2, 100); // Refused: recorded as insufficient stock
+    Product changed = test_product(1, "Trace", 20);
+    TEST_CHECK(update_product(1, changed));
+    TEST_CHECK(test_stock(3) == -1);
+    TEST_CHECK(delete_product(1));
+    trace_stop();
+
+    /*Back to the starting point: the session added product 2, so it goes*/
+    TEST_CHECK(delete_product(2));
+    TEST_CHECK(test_stock(2) == -1);
+
+    TraceReplayOptions options;
+    trace_replay_options_init(&options);
+    TraceReplayStats* stats = malloc(sizeof(TraceReplayStats));
+    TEST_CHECK(stats);
+    bool replayed = trace_replay("session.trace", &options, stats);
+    long long calls = stats->calls;
+    long long mismatches = stats->mismatches;
+    TEST_CHECK(replayed);
+    TEST_CHECK(calls == 8);
+    TEST_CHECK(mismatches == 0);
+    TEST_CHECK(test_stock(1) == -1);
+    TEST_CHECK(test_stock(2) == 9);
+
+    /*The last movement of a group is missing: nothing of the group is applied*/
+    TEST_CHECK(trace_start("group.trace"));
+    TEST_CHECK(apply_stock_movements(group, 2) == 1); // Product 1 is gone
+    trace_stop();
+    TEST_CHECK(test_stock(2) == 13);
+    TEST_CHECK(test_truncate_copy("group.trace", "torn.trace", (long)sizeof(TraceRecord)));
+    replayed = trace_replay("torn.trace", &options, stats);
+    free(stats);
+    TEST_CHECK(!replayed);
+    TEST_CHECK(test_stock(2) == 13);
+    return 0;
+}
+
+/*===== Request engine =====*/
+#ifndef _WIN32
+/*Selling one unit at a time through the engine, counting the sales that went through*/
+static void* engine_seller(void* arg) {
+    int* sold = arg;
+    for (int i = 0; i < ENGINE_TEST_SALES; i++) {
+        Request req = { .type = REQUEST_SELL, .id = 1, .quantity = 1 };
+        if (engine_submit(&req)) {
+            engine_wait(&req);
+            *sold += req.success;
+        }
+    }
+    return NULL;
+}
+#endif
+
+/*Many threads selling one SKU: no sale lost or doubled, statistics in step*/
+static int test_engine_threads() {
+#ifdef _WIN32
+    printf("The request engine runs requests inline on this platform\n");
+    return TEST_SKIPPED;
+#else
+    inventory_init();
+    TEST_CHECK(add_product(test_product(1, "Contended", ENGINE_TEST_STOCK)));
+    TEST_CHECK(add_product(test_product(2, "Bystander", 5)));
+    TEST_CHECK(engine_start(ENGINE_TEST_THREADS));
+
+    pthread_t threads[ENGINE_TEST_THREADS];
+    int sold[ENGINE_TEST_THREADS] = { 0 };
+    for (int i = 0; i < ENGINE_TEST_THREADS; i++) {
+        TEST_CHECK(pthread_create(&threads[i], NULL, engine_seller, &sold[i]) == 0);
+    }
+    int total_sold = 0;
+    for (int i = 0; i < ENGINE_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total_sold += sold[i];
+    }
+    engine_stop();
+    log_commit();
+
+    int expected = ENGINE_TEST_STOCK - ENGINE_TEST_THREADS * ENGINE_TEST_SALES;
+    TEST_CHECK(total_sold == ENGINE_TEST_THREADS * ENGINE_TEST_SALES);
+    Product* p = get_product(1);
+    TEST_CHECK(p != NULL);
+    int stock = p->quantity;
+    free(p);
+    TEST_CHECK(stock == expected);
+
+    const InventoryStats* stats = stats_get();
+    TEST_CHECK(stats->product_count == 2);
+    TEST_CHECK(stats->units == expected + 5);
+    TEST_CHECK(fabs(stats->total_value - (double)(expected + 5) * TEST_PRICE) < 1e-6);
+    TEST_CHECK(stats->low_stock_count == 1);
+    const CategoryStats* c = stats_category("Contended");
+    TEST_CHECK(c != NULL && c->units == expected && c->product_count == 1);
+    TEST_CHECK(verify_inventory_stats(false));
+    TEST_CHECK(log_record_count() == 2 + total_sold);
+    return 0;
+#endif
+}
+
+/*===== Test table =====*/
+static const TestCase tests[] = {
+    { "index", test_index },
+    { "compaction", test_compaction },
+    { "log_flush", test_log_flush },
+    { "movements", test_movements },
+    { "stats", test_stats },
+    { "stock_index", test_stock_index },
+    { "category", test_category },
+    { "name_search", test_name_search },
+    { "columns", test_columns },
+    { "log_query", test_log_query },
+    { "lz", test_lz },
+    { "segments", test_segments },
+    { "backup", test_backup },
+    { "copy", test_copy },
+    { "checksum", test_checksum },
+    { "catalog", test_catalog },
+    { "snapshot", test_snapshot },
+    { "pitr", test_pitr },
+    { "wal", test_wal },
+    { "import", test_import },
+    { "export", test_export },
+    { "trace", test_trace },
+    { "engine", test_engine_threads }
+};
+
+#define TEST_COUNT (int)(sizeof(tests) / sizeof(tests[0]))
+
+/*Printing the tests this program knows*/
+static void test_usage() {
+    fprintf(stderr, "Usage: ims-tests <test>\nTests:");
+    for (int i = 0; i < TEST_COUNT; i++) {
+        fprintf(stderr, " %s", tests[i].name);
+    }
+    fprintf(stderr, "\nEach test runs in a new scratch directory under the working directory.\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        test_usage();
+        return 1;
+    }
+    for (int i = 0; i < TEST_COUNT; i++) {
+        if (strcmp(argv[1], tests[i].name) == 0) {
+            int status = test_run(&tests[i]);
+            printf("%s: %s\n", tests[i].name,
+                status == 0 ? "passed" : status == TEST_SKIPPED ? "skipped" : "FAILED");
+            return status;
+        }
+    }
+    test_usage();
+    return 1;
+}
@@ -0,0 +1,318 @@
+#include "include/inventory-stats.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include "include/category-index.h"
+#include "include/column-snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*Sidecar header (followed by category_count CategoryStats)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    long long file_size; // inventory.dat size when the sidecar was written
+    long long file_mtime; // inventory.dat mtime when the sidecar was written
+    long product_count;
+    long units;
+    double total_value;
+    long low_stock_count;
+    long out_of_stock_count;
+    int category_count;
+} StatsHeader;
+
+/*Cached aggregates*/
+static InventoryStats stats = { 0 };
+
+/*===== Internal helpers =====*/
+/*Finding (or creating) the totals of a category, indexed by category ID*/
+static CategoryStats* find_category(InventoryStats* s, const char* name, bool create) {
+    int id = create ? category_intern(name) : category_find(name);
+    if (id < 0) {
+        return NULL;
+    }
+    if (id < s->category_count) {
+        return &s->categories[id];
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    if (id >= s->category_capacity) {
+        int new_capacity = s->category_capacity ? s->category_capacity : 16;
+        while (new_capacity <= id) {
+            new_capacity *= 2;
+        }
+        CategoryStats* categories = realloc(s->categories, new_capacity * sizeof(CategoryStats));
+        if (!categories) {
+            return NULL;
+        }
+        s->categories = categories;
+        s->category_capacity = new_capacity;
+    }
+
+    /*Filling the gap up to this ID with empty totals*/
+    for (int i = s->category_count; i <= id; i++) {
+        memset(&s->categories[i], 0, sizeof(CategoryStats));
+        strncpy(s->categories[i].name, category_name(i), MAX_CATEGORY_LEN - 1);
+    }
+    s->category_count = id + 1;
+    return &s->categories[id];
+}
+
+/*Adding (sign = 1) or removing (sign = -1) one product from the totals*/
+static void account_product(InventoryStats* s, const Product* p, int sign) {
+    double value = (double)p->price * p->quantity;
+
+    s->product_count += sign;
+    s->units += sign * (long)p->quantity;
+    s->total_value += sign * value;
+    if (p->quantity == 0) {
+        s->out_of_stock_count += sign;
+    }
+    if (p->quantity > 0 && p->quantity < LOW_STOCK_LIMIT) {
+        s->low_stock_count += sign;
+    }
+
+    CategoryStats* c = find_category(s, p->category, true);
+    if (c) {
+        c->product_count += sign;
+        c->units += sign * (long)p->quantity;
+        c->total_value += sign * value;
+    }
+}
+
+/*Computing every aggregate from a columnar snapshot of the store*/
+static void scan_stats(InventoryStats* s, const ColumnSnapshot* snap) {
+    free(s->categories);
+    memset(s, 0, sizeof(InventoryStats));
+    if (!snap) {
+        return;
+    }
+
+    /*Global value and stock bands come from the SIMD kernels*/
+    s->total_value = column_total_value(snap);
+    s->low_stock_count = column_count_range(snap, 1, LOW_STOCK_LIMIT);
+    s->out_of_stock_count = column_count_range(snap, 0, 1);
+
+    /*Per-category totals in one pass over the category column*/
+    int total = category_total();
+    if (total > 0 && !find_category(s, category_name(total - 1), true)) {
+        return;
+    }
+    for (long slot = 0; slot < snap->count; slot++) {
+        int id = snap->category_id[slot];
+        if (id == COLUMN_DEAD_CATEGORY) {
+            continue;
+        }
+        CategoryStats* c = &s->categories[id];
+        c->product_count++;
+        c->units += snap->quantity[slot];
+        c->total_value += (double)snap->price[slot] * snap->quantity[slot];
+    }
+    for (int id = 0; id < s->category_count; id++) {
+        s->product_count += s->categories[id].product_count;
+        s->units += s->categories[id].units;
+    }
+    s->valid = true;
+}
+
+/*Comparing money totals with a small tolerance for float drift*/
+static bool values_match(double a, double b) {
+    double diff = a > b ? a - b : b - a;
+    double scale = (a > 0 ? a : -a) + 1.0;
+    return diff <= 0.005 || diff / scale <= 1e-9;
+}
+
+/*===== Stats lifecycle =====*/
+/*Loading the sidecar if it still matches inventory.dat*/
+bool stats_load() {
+    stats_reset();
+
+    FILE* fptr = fopen(STATS_FILE, "rb");
+    if (!fptr) {
+        return false;
+    }
+
+    StatsHeader header;
+    struct stat st;
+    bool ok = (fread(&header, sizeof(header), 1, fptr) == 1) &&
+        header.magic == STATS_MAGIC &&
+        header.version == STATS_VERSION &&
+        header.category_count >= 0 &&
+        stat(FILENAME, &st) == 0 &&
+        header.file_size == (long long)st.st_size &&
+        header.file_mtime == (long long)st.st_mtime;
+
+    /*Category totals are stored by name and re-filed under interned IDs*/
+    CategoryStats entry;
+    for (int i = 0; ok && i < header.category_count; i++) {
+        ok = fread(&entry, sizeof(CategoryStats), 1, fptr) == 1;
+        CategoryStats* c = ok ? find_category(&stats, entry.name, true) : NULL;
+        ok = ok && c != NULL;
+        if (ok) {
+            *c = entry;
+        }
+    }
+    fclose(fptr);
+
+    /*A crash before the next clean shutdown must not leave a stale sidecar*/
+    remove(STATS_FILE);
+
+    if (!ok) {
+        stats_reset();
+        return false;
+    }
+
+    stats.product_count = header.product_count;
+    stats.units = header.units;
+    stats.total_value = header.total_value;
+    stats.low_stock_count = header.low_stock_count;
+    stats.out_of_stock_count = header.out_of_stock_count;
+    stats.valid = true;
+    return true;
+}
+
+/*Writing the sidecar (inventory.dat must be closed and trimmed)*/
+bool stats_save() {
+    struct stat st;
+    if (!stats.valid || stat(FILENAME, &st) != 0) {
+        return false;
+    }
+
+    StatsHeader header = {
+        .magic = STATS_MAGIC,
+        .version = STATS_VERSION,
+        .file_size = (long long)st.st_size,
+        .file_mtime = (long long)st.st_mtime,
+        .product_count = stats.product_count,
+        .units = stats.units,
+        .total_value = stats.total_value,
+        .low_stock_count = stats.low_stock_count,
+        .out_of_stock_count = stats.out_of_stock_count,
+        .category_count = stats.category_count
+    };
+
+    FILE* fptr = fopen(STATS_FILE, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(stats.categories, sizeof(CategoryStats), stats.category_count, fptr) ==
+        (size_t)stats.category_count;
+    if (fclose(fptr) != 0 || !ok) {
+        remove(STATS_FILE);
+        return false;
+    }
+    return true;
+}
+
+/*Recomputing the cache from the store*/
+bool stats_rebuild() {
+    scan_stats(&stats, column_snapshot_get());
+    return stats.valid;
+}
+
+/*Dropping the cache (e.g. after a restore)*/
+void stats_reset() {
+    free(stats.categories);
+    memset(&stats, 0, sizeof(stats));
+}
+
+/*===== Incremental maintenance =====*/
+/*Moving the totals from the old record image to the new one*/
+void stats_apply(const Product* before, const Product* after) {
+    if (!stats.valid) {
+        return; // Rebuilt from the store on next use
+    }
+    if (before) {
+        account_product(&stats, before, -1);
+    }
+    if (after) {
+        account_product(&stats, after, 1);
+    }
+}
+
+/*===== Queries =====*/
+/*Getting the cached aggregates (rebuilt once if missing)*/
+const InventoryStats* stats_get() {
+    if (!stats.valid) {
+        stats_rebuild();
+    }
+    return &stats;
+}
+
+/*Getting the totals of one category (NULL if unknown)*/
+const CategoryStats* stats_category(const char* category) {
+    return find_category((InventoryStats*)stats_get(), category, false);
+}
+
+/*Cross-checking the cache against a full scan (verification mode)*/
+bool verify_inventory_stats(bool repair) {
+    const InventoryStats* cached = stats_get();
+    InventoryStats fresh = { 0 };
+
+    /*A private snapshot, so the check does not trust any maintained state*/
+    ColumnSnapshot snap = { 0 };
+    scan_stats(&fresh, column_snapshot_build(&snap) ? &snap : NULL);
+    column_snapshot_free(&snap);
+    if (!fresh.valid) {
+        return false;
+    }
+
+    bool match = cached->product_count == fresh.product_count &&
+        cached->units == fresh.units &&
+        cached->low_stock_count == fresh.low_stock_count &&
+        cached->out_of_stock_count == fresh.out_of_stock_count &&
+        values_match(cached->total_value, fresh.total_value);
+
+    for (int i = 0; match && i < fresh.category_count; i++) {
+        const CategoryStats* c = find_category((InventoryStats*)cached, fresh.categories[i].name, false);
+        if (!c) {
+            match = fresh.categories[i].product_count == 0; // Interned but unused
+            continue;
+        }
+        match = c->product_count == fresh.categories[i].product_count &&
+            c->units == fresh.categories[i].units &&
+            values_match(c->total_value, fresh.categories[i].total_value);
+    }
+
+    if (!match) {
+        printf("Warning: cached statistics out of date "
+            "(value %.2f vs %.2f, products %ld vs %ld)\n",
+            cached->total_value, fresh.total_value,
+            cached->product_count, fresh.product_count);
+    }
+
+    if (!match && repair) {
+        free(stats.categories);
+        stats = fresh;
+    }
+    else {
+        free(fresh.categories);
+    }
+    return match;
+}
+
+/*Printing the summary section from the cache in O(1)*/
+void display_inventory_summary() {
+    const InventoryStats* s = stats_get();
+
+    printf("\nSummary\n");
+    printf("Total Inventory Value: %.2f\n", s->total_value);
+    printf("Low Stock Items (<%d): %ld\n", LOW_STOCK_LIMIT, s->low_stock_count);
+    printf("Out-of-Stock Items: %ld\n", s->out_of_stock_count);
+
+    /*Per-category totals*/
+    if (s->category_count > 0) {
+        printf("\n%-15s %-8s %-10s %s\n", "Category", "Items", "Units", "Value");
+        for (int i = 0; i < s->category_count; i++) {
+            const CategoryStats* c = &s->categories[i];
+            if (c->product_count > 0) {
+                printf("%-15s %-8ld %-10ld $%.2f\n",
+                    c->name, c->product_count, c->units, c->total_value);
+            }
+        }
+    }
+}
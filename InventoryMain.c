@@ -1,5 +1,16 @@
 #include "include/inventory.h"
+#include "include/product-index.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include "include/inventory-stats.h"
+#include "include/stock-index.h"
+#include "include/category-index.h"
+#include "include/name-index.h"
+#include "include/column-snapshot.h"
+#include "include/request-engine.h"
+#include "include/workload-trace.h"
 #include "include/ui.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -34,18 +45,105 @@ bool file_exists() {
     return false;
 }
 
+/*Cross-checking cached statistics on every report (verification mode)*/
+static bool report_verification = false;
+
+/*Next ID handed out by generate_id() (-1 until the store was scanned)*/
+static int max_id = -1;
+
+/*Helper function to keep derived data in sync with a record change*/
+static void record_changed(long slot, const Product* before, const Product* after) {
+    stats_apply(before, after);
+    stock_index_update(slot, before, after);
+    category_index_update(slot, before, after);
+    name_index_update(slot, before, after);
+    column_snapshot_update(slot, before, after);
+}
+
+/*Helper function to keep generate_id() ahead of IDs chosen by the caller*/
+static void note_used_id(int id) {
+    if (max_id != -1 && id >= max_id) {
+        max_id = id + 1;
+    }
+}
+
+/*Helper function to publish a change to derived data and the log (safe from any thread)*/
+static void publish_change(long slot, const Product* before, const Product* after, Transaction t) {
+    engine_lock_shared_state();
+    record_changed(slot, before, after);
+    engine_unlock_shared_state();
+
+    /*The log has its own lock, and a group write runs without it*/
+    log_transaction(t);
+}
+
+/*Helper function to rebuild every slot-based index after slots moved*/
+static bool rebuild_indexes() {
+    /*The name index and columns are rebuilt on next use*/
+    name_index_reset();
+    column_snapshot_reset();
+    return index_build() && stock_index_build() && category_index_build();
+}
+
+/*===== Lifecycle =====*/
+/*Function to load cached state at startup (secondary indexes are built on first use)*/
+void inventory_init() {
+    /*Sidecars must be checked before the store touches inventory.dat*/
+    stats_load();
+    index_load(); // Without a valid sidecar the first lookup scans the store
+
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+    if (fptr) {
+        char line[256];
+        int verify = 0;
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "report_verify=%d", &verify) == 1) {
+                report_verification = (verify != 0);
+            }
+        }
+        fclose(fptr);
+    }
+
+    /*Recording calls if storage.cfg names a trace file*/
+    load_trace_config();
+
+    static bool atexit_registered = false;
+    if (!atexit_registered) {
+        atexit(inventory_shutdown);
+        atexit_registered = true;
+    }
+}
+
+/*Function to flush everything and persist cached state on exit*/
+void inventory_shutdown() {
+    trace_stop();
+    log_close();
+    store_close();
+    stats_save();
+    index_save();
+}
+
+/*Function to drop in-memory state after inventory.dat was replaced*/
+void inventory_reload() {
+    index_reset();
+    stock_index_reset();
+    stats_reset();
+    category_index_reset();
+    name_index_reset();
+    column_snapshot_reset();
+}
+
+/*Function to toggle report cross-checking*/
+void set_report_verification(bool enabled) {
+    report_verification = enabled;
+}
+
 /*=== Core Features ===*/
 
 /*===== CRUD functions =====*/
 /*Function to add product to inventory*/
 bool add_product(Product p) {
-    /*Opening the file*/
-    FILE* fptr = open_file("ab");
-    /*Checking if file is open*/
-    if (!fptr) {
-        return false;
-    }
-
+    long long traced = trace_begin();
     // Addding transaction logging for adding a product
     Transaction t = {
         .timestamp = time(NULL),
@@ -53,63 +151,125 @@ bool add_product(Product p) {
         .product_id = p.id,
         .quantity_change = p.quantity,
         .price_change = p.price,
-        .user = "system"
+        .user = "system",
+        .after = p
     };
     snprintf(t.description, 100, "Added new product: %s", p.name);
 
 
-    /*Writing product to file*/
-    bool success = (fwrite(&p, sizeof(Product), 1, fptr) == 1);
-    close_file(fptr);
+    /*Slots and the index change, so no other request may run*/
+    engine_lock_catalog(true);
 
+    /*IDs are unique: a product already stored is not added twice*/
+    long slot = -1;
+    if (index_lookup(p.id) == -1) {
+        /*Writing product to the store (reusing a deleted slot if any)*/
+        slot = store_insert(&p);
+    }
 
     /*Logging if write is successful*/
-    if (success) {
+    if (slot != -1) {
+        index_insert(p.id, slot);
+        record_changed(slot, NULL, &p);
+        store_flush();
         log_transaction(t);
-        return success;
+        note_used_id(p.id);
     }
-    return false;
+    engine_unlock_catalog();
+    trace_end(TRACE_ADD, traced, p.id, p.quantity, &p, slot != -1);
+    return slot != -1;
 }
 
-/*Function to search for search for specific product*/
-Product* get_product(int id) {
-    /*File pointer*/
-    FILE* fptr = open_file("rb");
-    /*Checking if file is open*/
-    if (!fptr) {
-        return NULL;
+/*Function to add many products with one sequential append, returns count added*/
+int add_products(const Product* products, int count) {
+    Product* fresh = malloc((count > 0 ? count : 1) * sizeof(Product));
+    if (!fresh) {
+        return 0;
+    }
+    engine_lock_catalog(true);
+
+    /*Indexing first, so IDs already stored or repeated in the batch are dropped*/
+    long first = store_count();
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        if (products[i].id > 0 && index_lookup(products[i].id) == -1 &&
+            index_insert(products[i].id, first + added)) {
+            fresh[added++] = products[i];
+        }
+    }
+
+    /*One WAL batch and one log group: the whole batch recovers together*/
+    store_begin_batch();
+    bool stored = added > 0 && store_append_many(fresh, added) == first;
+    store_end_batch();
+
+    if (stored) {
+        log_begin_group();
+        for (int i = 0; i < added; i++) {
+            Transaction t = {
+                .timestamp = time(NULL),
+                .type = ADD,
+                .product_id = fresh[i].id,
+                .quantity_change = fresh[i].quantity,
+                .price_change = fresh[i].price,
+                .user = "import",
+                .after = fresh[i]
+            };
+            snprintf(t.description, 100, "Added new product: %s", fresh[i].name);
+            record_changed(first + i, NULL, &fresh[i]);
+            log_transaction(t);
+            note_used_id(fresh[i].id);
+        }
+        store_flush();
+        log_end_group();
+    }
+    else {
+        for (int i = 0; i < added; i++) {
+            index_remove(fresh[i].id);
+        }
+        added = 0;
     }
 
-    /*Searching for product*/
+    engine_unlock_catalog();
+    free(fresh);
+    return added;
+}
+
+/*Function to search for search for specific product*/
+Product* get_product(int id) {
+    long long traced = trace_begin();
     Product* result = malloc(sizeof(Product));
     if (!result) {
-        close_file(fptr);
         return NULL;
     }
 
-    while (fread(result, sizeof(Product), 1, fptr)) {
-        if (result->id == id) {
-            close_file(fptr);
-            return result;
-        }
-    }
+    /*Looking up and reading the product under its record lock*/
+    engine_lock_catalog(false);
+    engine_lock_record(id, false);
+    long slot = index_lookup(id);
+    bool found = (slot != -1 && store_read(slot, result) && result->id == id);
+    engine_unlock_record(id);
+    engine_unlock_catalog();
+    trace_end(TRACE_GET, traced, id, 0, NULL, found);
 
-    close_file(fptr);
+    if (found) {
+        return result;
+    }
     free(result);
     return NULL;
 };
 
 /*Function to update specific product data*/
 bool update_product(int id, Product new_data) {
-    /*File pointer*/
-    FILE* fptr = open_file("rb+");
-    if (!fptr) {
-        return false;
-    }
+    long long traced = trace_begin();
+    /*Only this record changes, so other products stay available*/
+    engine_lock_catalog(false);
+    engine_lock_record(id, true);
 
     Product old;
-    bool found = false;
-    long pos = 0;
+    long slot = index_lookup(id);
+    bool found = (slot != -1 && store_read(slot, &old) && old.id == id);
+    bool success = false;
     Transaction t = {
         .timestamp = time(NULL),
         .type = UPDATE,
@@ -117,123 +277,147 @@ bool update_product(int id, Product new_data) {
         .user = "system"
     };
 
-    /*Searching for the product to update*/
-    while (fread(&old, sizeof(Product), 1, fptr)) {
-        if (old.id == id) {
-            found = true;
-            break;
-        }
-        pos = ftell(fptr);
-    }
     /*Product found*/
     if (found) {
 
         // Calculating changes
         t.quantity_change = new_data.quantity - old.quantity;
         t.price_change = new_data.price - old.price;
+        t.after = new_data;
         snprintf(t.description, 100, "Updated %s | Qty %d -> %d | Price $%.2f -> $%.2f",
             old.name,
             old.quantity, new_data.quantity,
             old.price, new_data.price);
 
-        fseek(fptr, pos - sizeof(Product), SEEK_SET);
-        bool success = (fwrite(&new_data, sizeof(Product), 1, fptr) == 1);
-        close_file(fptr);
+        success = store_write(slot, &new_data);
 
         if (success) {
-            log_transaction(t);
+            publish_change(slot, &old, &new_data, t);
+            store_flush();
         }
-        return success;
     }
 
-    /*If failed*/
-    close_file(fptr);
-    return false;
+    engine_unlock_record(id);
+    engine_unlock_catalog();
+    trace_end(TRACE_UPDATE, traced, id, new_data.quantity, &new_data, success);
+    return success;
 }
 
-/*Function to delete a specific product*/
-bool delete_product(int id) {
-    /*File pointer*/
-    FILE* src = open_file("rb");
-    FILE* dst = fopen(TEMP_FILE, "wb");
-    if (!src || !dst) {
-        if (src) {
-            close_file(src);
-        }
-
-        if (dst) {
-            fclose(dst);
-        }
+/*Helper function to tombstone one product without compacting*/
+static bool delete_record(int id) {
+    /*Finding the record through the index*/
+    Product old;
+    long slot = index_lookup(id);
+    if (slot == -1 || !store_read(slot, &old) || old.id != id) {
         return false;
     }
 
-    Product p;
-    bool deleted = false;
     Transaction t = {
         .timestamp = time(NULL),
         .type = DELETE,
         .product_id = id,
+        .quantity_change = -old.quantity,
         .user = "system"
     };
+    snprintf(t.description, 100, "Deleted product: %s", old.name);
 
-    /*Deleting the product*/
-    while (fread(&p, sizeof(Product), 1, src)) {
-        if (p.id == id) {
-            /*Recording details before deletion*/
-            t.quantity_change = -p.quantity;
-            snprintf(t.description, 100, "Deleted product: %s", p.name);
-            deleted = true;
-        }
-        else {
-            fwrite(&p, sizeof(Product), 1, dst);
-        }
+    /*Flipping the record to a tombstone in place*/
+    if (!store_delete(slot)) {
+        return false;
     }
+    index_remove(id);
+    record_changed(slot, &old, NULL);
+    log_transaction(t);
+    return true;
+}
 
-    close_file(src);
-    fclose(dst);
+/*Helper function to compact once enough records are dead*/
+static void compact_if_needed() {
+    if (store_needs_compaction(load_compaction_threshold())) {
+        compact_inventory();
+    }
+}
 
-    /*Checking if product is deleted*/
+/*Function to delete a specific product*/
+bool delete_product(int id) {
+    long long traced = trace_begin();
+    engine_lock_catalog(true);
+    bool deleted = delete_record(id);
     if (deleted) {
-        log_transaction(t);
-        remove(FILENAME);
-        rename(TEMP_FILE, FILENAME);
-        return true;
+        store_flush();
+        compact_if_needed();
     }
+    engine_unlock_catalog();
+    trace_end(TRACE_DELETE, traced, id, 0, NULL, deleted);
+    return deleted;
+}
 
-    remove(TEMP_FILE);
-    return false;
+/*Function to delete many products (e.g. weekly delistings), returns count deleted*/
+int delete_products(const int* ids, int count) {
+    int deleted = 0;
+    engine_lock_catalog(true);
+    store_begin_batch();
+    for (int i = 0; i < count; i++) {
+        if (delete_record(ids[i])) {
+            deleted++;
+        }
+    }
+    store_end_batch();
+
+    /*Compacting at most once for the whole batch*/
+    if (deleted > 0) {
+        store_flush();
+        compact_if_needed();
+    }
+    engine_unlock_catalog();
+    return deleted;
+}
+
+/*Function to reclaim tombstoned records*/
+bool compact_inventory() {
+    engine_lock_catalog(true);
+    /*Surviving records move, so the indexes are rebuilt*/
+    bool compacted = store_compact() && rebuild_indexes();
+    engine_unlock_catalog();
+    return compacted;
 }
 
 /*===== Helper functions =====*/
 /*Function to generate id for product*/
 int generate_id() {
-    static int max_id = -1; // -1 indicates not initialized
+    return reserve_ids(1);
+}
 
+/*Function to reserve count consecutive new IDs, returns the first*/
+int reserve_ids(int count) {
+    /*Callers on different threads must not be handed the same IDs*/
+    engine_lock_catalog(false);
+    engine_lock_shared_state();
     if (max_id == -1) { // Initialize max_id once
         max_id = 0;
-        FILE* fptr = fopen(FILENAME, "rb");
-        if (fptr) {
-            Product p;
-            while (fread(&p, sizeof(Product), 1, fptr)) {
-                if (p.id > max_id) {
-                    max_id = p.id;
-                }
+        long records = store_count();
+        for (long slot = 0; slot < records; slot++) {
+            const Product* p = store_record(slot);
+            if (store_is_live(p) && p->id > max_id) {
+                max_id = p->id;
             }
-            fclose(fptr);
         }
         max_id++; // Next ID is max existing +1
     }
 
-    int new_id = max_id;
-    max_id++;
-    return new_id;
+    int first_id = max_id;
+    max_id += count;
+    engine_unlock_shared_state();
+    engine_unlock_catalog();
+    return first_id;
 }
 
 /*Function to check if product exists*/
 bool product_exists(int id) {
-    Product* p = get_product(id);
-    bool exists = (p != NULL);
-    free(p);
+    /*The index is rebuilt under the exclusive catalog lock*/
+    engine_lock_catalog(false);
+    bool exists = index_lookup(id) != -1;
+    engine_unlock_catalog();
     return exists;
 }
 
@@ -277,242 +461,411 @@ void display_product(Product p) {
     printf("------------------------------\n");
 }
 
+/*Helper function to count live products (the free list is built on first use, so writers are held off)*/
+static long live_products() {
+    engine_lock_shared_state();
+    long live = store_live_count();
+    engine_unlock_shared_state();
+    return live;
+}
+
+/*Helper function to copy a live record under its record lock (catalog lock held)*/
+static bool copy_live_record(long slot, Product* out) {
+    const Product* p = store_record(slot);
+    if (!store_is_live(p)) {
+        return false;
+    }
+
+    /*A slot only changes owner under the exclusive catalog lock, so its ID picks the lock*/
+    int id = p->id;
+    engine_lock_record(id, false);
+    bool copied = store_read(slot, out) && out->id == id;
+    engine_unlock_record(id);
+    return copied;
+}
+
 /*Function to display all products in inventory system*/
 void display_all_products() {
-    /*FILE pointer*/
-    FILE* fptr = open_file("rb");
-    /*Checking if file is open*/
-    if (!fptr) {
+    engine_lock_catalog(false);
+    long records = store_count();
+    /*Checking if there is anything to list*/
+    if (live_products() == 0) {
         printf("\nNo Products found!\n");
+        engine_unlock_catalog();
         return;
     }
 
-    Product p;
     printf("\n=== Inventory Listing ===\n");
-    while (fread(&p, sizeof(Product), 1, fptr)) {
-        display_product(p);
+    Product p;
+    for (long slot = 0; slot < records; slot++) {
+        if (copy_live_record(slot, &p)) {
+            display_product(p);
+        }
     }
-    close_file(fptr);
+    engine_unlock_catalog();
 }
 
 /*Function to generate a report of all products in inventory system*/
 void generate_report() {
-    /*File pointer*/
-    FILE* fptr = open_file("rb");
-    /*Checking if file is open*/
-    if (!fptr) {
+    long long traced = trace_begin();
+    engine_lock_catalog(false);
+    long records = store_count();
+    /*Checking if there is anything to report*/
+    if (live_products() == 0) {
         printf("\nInventory is empty!\n");
+        engine_unlock_catalog();
+        trace_end(TRACE_REPORT, traced, 0, 0, NULL, 1);
         return;
     }
 
-    Product p;
-    float total_value = 0.0;
-    int low_stock_count = 0;
-    int out_of_stock_count = 0;
-
     /*Inventory report*/
     printf("\n=== Inventory Report ===\n");
     printf("%-5s %-20s %-10s %-8s %-15s\n",
         "ID", "Name", "Price", "Qty", "Category");
 
-    while (fread(&p, sizeof(Product), 1, fptr)) {
+    /*Rows need the name and category, so they come from the records rather than the columns*/
+    Product p;
+    for (long slot = 0; slot < records; slot++) {
+        if (!copy_live_record(slot, &p)) {
+            continue;
+        }
+
         /*Table view*/
         printf("%-5d %-20s $%-9.2f %-8d %-15s\n",
             p.id, p.name, p.price, p.quantity, p.category);
-
-        /*Calculating totals*/
-        total_value += p.price * p.quantity;
-
-        if (p.quantity == 0) {
-            out_of_stock_count++;
-        }
-
-        if (p.quantity < 10 && p.quantity > 0) {
-            low_stock_count++;
-        }
     }
 
-    /*Summary*/
-    printf("\nSummary\n");
-    printf("Total Inventory Value: %.2f\n", total_value);
-    printf("Low Stock Items (<10): %d\n", low_stock_count);
-    printf("Out-of-Stock Items: %d\n", out_of_stock_count);
+    /*Cross-checking the cached totals against the column kernels over a fresh snapshot*/
+    engine_lock_shared_state();
+    if (report_verification) {
+        verify_inventory_stats(true);
+    }
 
-    close_file(fptr);
+    /*Summary (maintained incrementally, rebuilt with the column kernels when missing)*/
+    display_inventory_summary();
+    engine_unlock_shared_state();
+    engine_unlock_catalog();
+    trace_end(TRACE_REPORT, traced, 0, 0, NULL, 1);
 }
 
 /*Function to give an alert on low stock*/
 void low_stock_alert(int threshold) {
-    /*File pointer*/
-    FILE* fptr = open_file("rb");
-    /*Checking if file is open*/
-    if (!fptr) {
-        return;
-    }
-
-    Product p;
+    long* slots = NULL;
     bool alert_shown = false;
 
+    /*Only the matching products are visited, lowest stock first*/
+    engine_lock_catalog(false);
+    engine_lock_shared_state();
+    int matches = stock_index_query(threshold, &slots);
+    engine_unlock_shared_state();
+
     /*Low stock alert*/
-    printf("\n=== Low Stock Alert (Threshold: %d ===\n)", threshold);
-    while (fread(&p, sizeof(Product), 1, fptr)) {
-        if (p.quantity < threshold) {
+    printf("\n=== Low Stock Alert (Threshold: %d) ===\n", threshold);
+    Product p;
+    for (int i = 0; i < matches; i++) {
+        if (copy_live_record(slots[i], &p)) {
             printf("! %s (ID: %d) - Only %d left!\n",
                 p.name, p.id, p.quantity);
             alert_shown = true;
         }
     }
+    engine_unlock_catalog();
+    free(slots);
 
     /*If items are not below threshold*/
     if (!alert_shown) {
         printf("No items below stock threshold\n");
     }
-    close_file(fptr);
 }
 
-/*===== Inventory operations =====*/
-/*Function to restock a specific product*/
-void restock_product(int id, int quantity) {
-    Product* product = get_product(id);
-    /*Checking if product is found*/
-    if (!product) {
-        printf("Error: Product ID %d not found!\n", id);
+/*Function to list the products in one category*/
+void list_products_by_category(const char* category) {
+    const long* postings = NULL;
+    long* slots = NULL;
+    engine_lock_catalog(false);
+
+    /*Writers change the postings, so a copy is listed*/
+    engine_lock_shared_state();
+    long count = category_postings(category_find(category), &postings);
+    if (count > 0) {
+        slots = malloc(count * sizeof(long));
+        if (slots) {
+            memcpy(slots, postings, count * sizeof(long));
+        }
+        else {
+            count = 0;
+        }
+    }
+    engine_unlock_shared_state();
+
+    /*Checking if the category has any products*/
+    if (count <= 0) {
+        printf("\nNo products in category '%s'\n", category);
+        engine_unlock_catalog();
         return;
     }
 
-    Transaction t = {
-        .timestamp = time(NULL),
-        .type = RESTOCK,
-        .product_id = id,
-        .quantity_change = quantity,
-        .user = "system"
-    };
-    snprintf(t.description, 100, "Restocked %d units of %s",
-        quantity, product->name);
+    printf("\n=== Category: %s ===\n", category);
+    Product p;
+    for (long i = 0; i < count; i++) {
+        if (copy_live_record(slots[i], &p)) {
+            display_product(p);
+        }
+    }
+    printf("Products: %ld | Value: $%.2f\n", count, value_by_category(category));
+    engine_unlock_catalog();
+    free(slots);
+}
 
-    /*Checking if quantity is valid*/
-    if (quantity <= 0) {
-        printf("Error: Invalid restock quantity!\n");
-        free(product);
-        return;
+/*Function to find products whose name contains query, best matches first*/
+int search_products_by_name(const char* query, Product* results, int max_results) {
+    NameMatch* matches = malloc(max_results * sizeof(NameMatch));
+    if (!matches) {
+        return 0;
+    }
+
+    engine_lock_catalog(false);
+    engine_lock_shared_state();
+    int count = name_index_search(query, matches, max_results);
+    engine_unlock_shared_state();
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        if (copy_live_record(matches[i].slot, &results[found])) {
+            found++;
+        }
     }
+    engine_unlock_catalog();
+    free(matches);
+    return found;
+}
 
-    product->quantity += quantity;
+/*Function to display a name search*/
+void display_name_search(const char* query) {
+    Product results[MAX_SEARCH_RESULTS];
+    int count = search_products_by_name(query, results, MAX_SEARCH_RESULTS);
 
-    /*Checking if product stock is updated*/
-    if (update_product(id, *product)) {
-        log_transaction(t);
-        printf("Restock successfull!\n"
-            "Restocked %d units. New quantity: %d\n", quantity,
-            product->quantity);
+    /*Checking if anything matched*/
+    if (count == 0) {
+        printf("\nNo products matching '%s'\n", query);
+        return;
     }
-    else {
-        printf("Failed to update stock!\n");
+
+    printf("\n=== Search Results: %s ===\n", query);
+    printf("%-5s %-20s %-10s %-8s %-15s\n",
+        "ID", "Name", "Price", "Qty", "Category");
+    for (int i = 0; i < count; i++) {
+        printf("%-5d %-20s $%-9.2f %-8d %-15s\n",
+            results[i].id, results[i].name, results[i].price,
+            results[i].quantity, results[i].category);
     }
+}
 
-    free(product);
+/*Function to get the number of products in one category*/
+long count_by_category(const char* category) {
+    engine_lock_catalog(false);
+    engine_lock_shared_state();
+    const CategoryStats* c = stats_category(category);
+    long count = c ? c->product_count : 0;
+    engine_unlock_shared_state();
+    engine_unlock_catalog();
+    return count;
 }
 
-/*Function that will sell a product*/
-void sell_product(int id, int quantity) {
-    /*Searching for the product*/
-    Product* product = get_product(id);
+/*Function to get the stock value of one category*/
+double value_by_category(const char* category) {
+    engine_lock_catalog(false);
+    engine_lock_shared_state();
+    const CategoryStats* c = stats_category(category);
+    double value = c ? c->total_value : 0.0;
+    engine_unlock_shared_state();
+    engine_unlock_catalog();
+    return value;
+}
+
+/*===== Inventory operations =====*/
+/*Helper function to apply one movement to the record at slot (record lock held)*/
+static void apply_locked_movement(long slot, StockMovement* m) {
+    Product product, before;
     /*Checking if product is found*/
-    if (!product) {
-        printf("Error: Product ID %d not found!\n", id);
+    if (slot == -1 || !store_read(slot, &product) || product.id != m->id) {
+        m->result = STOCK_NOT_FOUND;
         return;
     }
 
-    Transaction t = {
-        .timestamp = time(NULL),
-        .type = SALE,
-        .product_id = id,
-        .quantity_change = -quantity,
-        .user = "system"
-    };
-    snprintf(t.description, 100, "Sold %d units of %s",
-        quantity, product->name);
-
-    /*Checking if product stock is still available*/
-    if (quantity <= 0) {
-        printf("Error: Invalid sale quantity!\n");
-        free(product);
+    /*Checking if quantity is valid*/
+    if (m->quantity <= 0) {
+        m->result = STOCK_INVALID_QUANTITY;
         return;
     }
 
-    /*Selling if product units re available*/
-    if (product->quantity < quantity) {
-        printf("Error: Only %d units available!\n", product->quantity);
-        free(product);
+    /*Selling only if product units are available*/
+    if (m->type == SALE && product.quantity < m->quantity) {
+        m->result = STOCK_INSUFFICIENT;
+        m->stock_after = product.quantity;
         return;
     }
 
-    product->quantity -= quantity;
+    /*Restocking only up to what the stock counter can hold*/
+    if (m->type == RESTOCK && product.quantity > INT_MAX - m->quantity) {
+        m->result = STOCK_LIMIT_EXCEEDED;
+        m->stock_after = product.quantity;
+        return;
+    }
 
-    /*Updating product stock when it is sold*/
-    if (update_product(id, *product)) {
-        log_transaction(t);
-        printf("Sale Successful!\n"
-            "Sold %d units. Remaining stock: %d\n", quantity,
-            product->quantity);
+    Transaction t = {
+        .timestamp = time(NULL),
+        .type = m->type,
+        .product_id = m->id,
+        .quantity_change = (m->type == SALE) ? -m->quantity : m->quantity,
+        .user = "system"
+    };
+    if (m->type == SALE) {
+        snprintf(t.description, 100, "Sold %d units of %s",
+            m->quantity, product.name);
     }
     else {
-        printf("Sale Failed!\n");
+        snprintf(t.description, 100, "Restocked %d units of %s",
+            m->quantity, product.name);
     }
 
-    free(product);
+    before = product;
+    product.quantity += t.quantity_change;
+
+    /*Updating stock in place (logged as RESTOCK/SALE only)*/
+    if (!store_write(slot, &product)) {
+        m->result = STOCK_WRITE_FAILED;
+        return;
+    }
+    t.after = product;
+    publish_change(slot, &before, &product, t);
+    m->result = STOCK_OK;
+    m->stock_after = product.quantity;
 }
 
-/*==================================================================*/
+/*Helper function to apply one movement, holding its record for the check and the write*/
+static void apply_movement(long slot, StockMovement* m) {
+    /*Oversell protection: no other sale of this product between reading and writing stock*/
+    engine_lock_record(m->id, true);
+    apply_locked_movement(slot, m);
+    engine_unlock_record(m->id);
+}
 
-/*=== Logging ===*/
-/*Code for logging transactions*/
-void log_transaction(Transaction t) {
-    /*Opening file*/
-    FILE* fptr = fopen(LOG_FILE, "ab");
-    if (!fptr) {
-        printf("Transaction log error");
+/*Ordering movements by record slot, keeping input order per slot*/
+typedef struct {
+    long slot;
+    int pos;
+} MovementRef;
+
+static int compare_movement_refs(const void* a, const void* b) {
+    const MovementRef* ref_a = (const MovementRef*)a;
+    const MovementRef* ref_b = (const MovementRef*)b;
+    if (ref_a->slot != ref_b->slot) {
+        return ref_a->slot < ref_b->slot ? -1 : 1;
     }
-    fwrite(&t, sizeof(Transaction), 1, fptr);
-    fclose(fptr);
+    return ref_a->pos - ref_b->pos;
 }
 
-/*Displaying transactions*/
-void display_transaction_log() {
-    /*Opening file*/
-    FILE* fptr = fopen(LOG_FILE, "rb");
-    if (!fptr) {
-        printf("\nNo transactions recorded\n");
-        return;
+/*Function to apply many stock movements in one pass, returns count applied*/
+int apply_stock_movements(StockMovement* movements, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    long long traced = trace_begin();
+
+    /*A batch shares one WAL batch and log group, so it runs alone; single movements run side by side*/
+    bool batched = count > 1;
+    engine_lock_catalog(batched);
+
+    MovementRef* order = malloc(count * sizeof(MovementRef));
+    for (int i = 0; i < count; i++) {
+        movements[i].result = STOCK_NOT_FOUND;
+        movements[i].stock_after = 0;
+        if (order) {
+            order[i].slot = index_lookup(movements[i].id);
+            order[i].pos = i;
+        }
     }
 
-    Transaction t;
-    char time_buf[20], price_buf[20];
+    /*Visiting the store sequentially instead of once per lookup*/
+    if (order) {
+        qsort(order, count, sizeof(MovementRef), compare_movement_refs);
+    }
 
-    // Displaying transaction log
-    printf("\n=== Transaction Log ===\n");
-    printf("%-19s | %-8s | %-6s | %-5s | %s\n",
-        "Timestamp", "Type", "Qty", "ID", "Description");
+    /*Several movements recover all together; a single one needs no batch*/
+    if (batched) {
+        store_begin_batch();
+        log_begin_group();
+    }
+    int applied = 0;
+    for (int i = 0; i < count; i++) {
+        StockMovement* m = order ? &movements[order[i].pos] : &movements[i];
+        long slot = order ? order[i].slot : index_lookup(m->id);
+        apply_movement(slot, m);
+        if (m->result == STOCK_OK) {
+            applied++;
+        }
+    }
+    if (batched) {
+        store_end_batch();
+    }
+    store_flush();
+    if (batched) {
+        log_end_group();
+    }
+    engine_unlock_catalog();
+    trace_end_group(traced, movements, count);
 
-    while (fread(&t, sizeof(Transaction), 1, fptr)) {
-        strftime(time_buf, 20, "%Y-%m-%d: %H:%M%S", localtime(&t.timestamp));
+    free(order);
+    return applied;
+}
 
-        // Formatting price change
-        if (t.price_change != 0) {
-            snprintf(price_buf, 20, "$%.2f", t.price_change);
+/*Function to print the outcome of a movement*/
+void report_stock_movement(const StockMovement* m) {
+    switch (m->result) {
+    case STOCK_OK:
+        if (m->type == SALE) {
+            printf("Sale Successful!\n"
+                "Sold %d units. Remaining stock: %d\n", m->quantity,
+                m->stock_after);
         }
         else {
-            strcpy(price_buf, "-");
+            printf("Restock successfull!\n"
+                "Restocked %d units. New quantity: %d\n", m->quantity,
+                m->stock_after);
         }
+        break;
+    case STOCK_NOT_FOUND:
+        printf("Error: Product ID %d not found!\n", m->id);
+        break;
+    case STOCK_INVALID_QUANTITY:
+        printf("Error: Invalid %s quantity!\n", m->type == SALE ? "sale" : "restock");
+        break;
+    case STOCK_INSUFFICIENT:
+        printf("Error: Only %d units available!\n", m->stock_after);
+        break;
+    case STOCK_WRITE_FAILED:
+        printf(m->type == SALE ? "Sale Failed!\n" : "Failed to update stock!\n");
+        break;
+    case STOCK_LIMIT_EXCEEDED:
+        printf("Error: Restock would exceed the maximum stock of %d (currently %d)!\n",
+            INT_MAX, m->stock_after);
+        break;
+    }
+}
+
+/*Running one sale or restock through the request engine and printing its outcome*/
+static void move_stock(int id, TransactionType type, int quantity) {
+    StockMovement m = { .id = id, .type = type, .quantity = quantity };
+    engine_move_stock(&m);
+    report_stock_movement(&m);
+}
+
+/*Function to restock a specific product*/
+void restock_product(int id, int quantity) {
+    move_stock(id, RESTOCK, quantity);
+}
 
-        printf("%-19s | %-8s | %+6d | %-5d | %s\n",
-            time_buf,
-            (const char* []) {
-            "ADD", "UPDATE", "DELETE", "RESTOCK", "SALE"
-        }[t.type],
-                t.quantity_change,
-                t.product_id,
-                t.description);
-    }
-    fclose(fptr);
-}
\ No newline at end of file
+/*Function that will sell a product*/
+void sell_product(int id, int quantity) {
+    move_stock(id, SALE, quantity);
+}
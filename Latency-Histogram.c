@@ -0,0 +1,76 @@
+#include "include/latency-histogram.h"
+#include <string.h>
+#include <time.h>
+
+/*===== Internal helpers =====*/
+/*Getting the upper edge of a bucket in nanoseconds*/
+static long long bucket_limit(int bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    int exponent = bucket / LATENCY_SUB_BUCKETS + 3;
+    long long sub = bucket % LATENCY_SUB_BUCKETS;
+    return ((LATENCY_SUB_BUCKETS + sub + 1) << (exponent - 4)) - 1;
+}
+
+/*===== Histogram =====*/
+/*Emptying a histogram*/
+void latency_reset(LatencyHistogram* h) {
+    memset(h, 0, sizeof(LatencyHistogram));
+}
+
+/*Recording one latency*/
+void latency_add(LatencyHistogram* h, long long ns) {
+    if (ns < 0) {
+        ns = 0;
+    }
+    int bucket;
+    if (ns < LATENCY_SUB_BUCKETS) {
+        bucket = (int)ns;
+    }
+    else {
+        int exponent = 0;
+        while ((ns >> exponent) > 1) {
+            exponent++;
+        }
+        int sub = (int)((ns >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1));
+        bucket = (exponent - 3) * LATENCY_SUB_BUCKETS + sub;
+    }
+    h->buckets[bucket]++;
+    h->count++;
+    h->total_ns += ns;
+    if (ns > h->max_ns) {
+        h->max_ns = ns;
+    }
+}
+
+/*Reading a percentile (0-100) in microseconds*/
+double latency_percentile(const LatencyHistogram* h, double percentile) {
+    if (h->count == 0) {
+        return 0;
+    }
+    long long rank = (long long)(percentile / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    long long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            long long limit = bucket_limit(b);
+            return (double)(limit < h->max_ns ? limit : h->max_ns) / 1000.0;
+        }
+    }
+    return (double)h->max_ns / 1000.0;
+}
+
+/*Reading a monotonic clock in nanoseconds*/
+long long latency_clock_ns() {
+#ifdef _WIN32
+    return (long long)clock() * (1000000000LL / CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
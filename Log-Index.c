@@ -0,0 +1,595 @@
+#include "include/log-index.h"
+#include "include/inventory.h"
+#include "include/transaction-log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/*64-bit seeks into transactions.lnk*/
+#ifdef _WIN32
+#define link_seek _fseeki64
+#else
+#define link_seek fseeko
+#endif
+
+/*Index file header (followed by the time blocks, then the product heads)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    long long record_count;
+    long long last_timestamp;
+    int last_product_id;
+    long block_count;
+    long head_count;
+} LogIndexHeader;
+
+/*Global log index (opened on the first query, saved by log_close)*/
+static LogIndex log_index = { 0 };
+
+/*Lock order: opener, then the writer lock, then the index lock (never call into the log with it held)*/
+#ifndef _WIN32
+static pthread_mutex_t index_mutex = PTHREAD_MUTEX_INITIALIZER; // Guards log_index and the links file
+static pthread_mutex_t open_mutex = PTHREAD_MUTEX_INITIALIZER; // One log_index_open() at a time
+#endif
+
+/*===== Internal helpers =====*/
+/*Taking the index lock (no-op without threads)*/
+static void index_lock() {
+#ifndef _WIN32
+    pthread_mutex_lock(&index_mutex);
+#endif
+}
+
+/*Releasing the index lock*/
+static void index_unlock() {
+#ifndef _WIN32
+    pthread_mutex_unlock(&index_mutex);
+#endif
+}
+
+/*Hashing a product ID into the heads table*/
+static long head_bucket(int product_id, long table_size) {
+    return (long)(((unsigned int)product_id * 2654435761u) & (unsigned int)(table_size - 1));
+}
+
+/*Placing a head without checking the load factor*/
+static void head_place(LogProductHead* table, long table_size, LogProductHead head) {
+    long b = head_bucket(head.product_id, table_size);
+    while (table[b].last_seq != LOG_NO_RECORD) {
+        b = (b + 1) & (table_size - 1);
+    }
+    table[b] = head;
+}
+
+/*Doubling the heads table*/
+static bool heads_grow() {
+    long new_size = log_index.head_table_size ? log_index.head_table_size * 2 : LOG_HEADS_INITIAL;
+    LogProductHead* table = malloc(new_size * sizeof(LogProductHead));
+    if (!table) {
+        return false;
+    }
+    for (long i = 0; i < new_size; i++) {
+        table[i].product_id = 0;
+        table[i].last_seq = LOG_NO_RECORD;
+    }
+    for (long i = 0; i < log_index.head_table_size; i++) {
+        if (log_index.heads[i].last_seq != LOG_NO_RECORD) {
+            head_place(table, new_size, log_index.heads[i]);
+        }
+    }
+    free(log_index.heads);
+    log_index.heads = table;
+    log_index.head_table_size = new_size;
+    return true;
+}
+
+/*Finding the head of a product's chain (NULL if absent, created if asked)*/
+static LogProductHead* find_head(int product_id, bool create) {
+    if (log_index.head_table_size == 0) {
+        if (!create || !heads_grow()) {
+            return NULL;
+        }
+    }
+
+    long b = head_bucket(product_id, log_index.head_table_size);
+    while (log_index.heads[b].last_seq != LOG_NO_RECORD) {
+        if (log_index.heads[b].product_id == product_id) {
+            return &log_index.heads[b];
+        }
+        b = (b + 1) & (log_index.head_table_size - 1);
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    /*Keeping the table at most half full*/
+    if ((log_index.head_count + 1) * 2 > log_index.head_table_size) {
+        if (!heads_grow()) {
+            return NULL;
+        }
+        return find_head(product_id, true);
+    }
+    log_index.heads[b].product_id = product_id;
+    log_index.head_count++;
+    return &log_index.heads[b];
+}
+
+/*Widening the time block that record seq falls into*/
+static bool note_timestamp(long long seq, long long ts) {
+    long b = (long)(seq / LOG_INDEX_BLOCK);
+    if (b < log_index.block_count) {
+        LogTimeBlock* block = &log_index.blocks[b];
+        if (ts < block->min_ts) {
+            block->min_ts = ts;
+        }
+        if (ts > block->max_ts) {
+            block->max_ts = ts;
+        }
+        if (ts > block->running_max) {
+            block->running_max = ts;
+        }
+        return true;
+    }
+
+    if (log_index.block_count == log_index.block_capacity) {
+        long new_capacity = log_index.block_capacity ? log_index.block_capacity * 2 : 64;
+        LogTimeBlock* blocks = realloc(log_index.blocks, new_capacity * sizeof(LogTimeBlock));
+        if (!blocks) {
+            return false;
+        }
+        log_index.blocks = blocks;
+        log_index.block_capacity = new_capacity;
+    }
+
+    LogTimeBlock* block = &log_index.blocks[log_index.block_count];
+    long long previous_max = log_index.block_count > 0 ?
+        log_index.blocks[log_index.block_count - 1].running_max : ts;
+    block->min_ts = ts;
+    block->max_ts = ts;
+    block->running_max = ts > previous_max ? ts : previous_max;
+    log_index.block_count++;
+    return true;
+}
+
+/*Indexing records that were written at seq = record_count onwards*/
+static bool index_records(const Transaction* records, int count) {
+    long long links[LOG_INDEX_BLOCK];
+    long long first = log_index.record_count;
+    int done = 0;
+
+    while (done < count) {
+        int n = count - done;
+        if (n > LOG_INDEX_BLOCK) {
+            n = LOG_INDEX_BLOCK;
+        }
+
+        /*Chaining each record to the previous one of the same product*/
+        for (int i = 0; i < n; i++) {
+            const Transaction* t = &records[done + i];
+            long long seq = first + done + i;
+            LogProductHead* head = find_head(t->product_id, true);
+            if (!head || !note_timestamp(seq, (long long)t->timestamp)) {
+                return false;
+            }
+            links[i] = head->last_seq;
+            head->last_seq = seq;
+        }
+
+        if (link_seek(log_index.links, (first + done) * (long long)sizeof(long long), SEEK_SET) != 0 ||
+            fwrite(links, sizeof(long long), n, log_index.links) != (size_t)n) {
+            return false;
+        }
+        done += n;
+    }
+
+    log_index.record_count = first + count;
+    log_index.last_timestamp = (long long)records[count - 1].timestamp;
+    log_index.last_product_id = records[count - 1].product_id;
+    return true;
+}
+
+/*Indexing records that start at record seq, skipping any already indexed (index lock held)*/
+static bool index_from(long long seq, const Transaction* records, int count) {
+    /*Past a gap: the next catch-up reads them from the log*/
+    if (seq > log_index.record_count) {
+        return true;
+    }
+    long long skip = log_index.record_count - seq;
+    if (skip >= count) {
+        return true;
+    }
+    return index_records(records + skip, count - (int)skip);
+}
+
+/*Loading transactions.idx if it still describes a prefix of the log*/
+static bool load_index_file(long long records, const Transaction* last) {
+    FILE* fptr = fopen(LOG_INDEX_FILE, "rb");
+    if (!fptr) {
+        return false;
+    }
+
+    LogIndexHeader header;
+    struct stat st;
+    bool ok = fread(&header, sizeof(header), 1, fptr) == 1 &&
+        header.magic == LOG_INDEX_MAGIC &&
+        header.version == LOG_INDEX_VERSION &&
+        header.record_count >= 0 && header.record_count <= records &&
+        header.block_count >= 0 && header.head_count >= 0 &&
+        stat(LOG_LINK_FILE, &st) == 0 &&
+        (long long)st.st_size >= header.record_count * (long long)sizeof(long long);
+
+    /*The last indexed record must still be the same one*/
+    if (ok && header.record_count > 0) {
+        ok = last != NULL &&
+            (long long)last->timestamp == header.last_timestamp &&
+            last->product_id == header.last_product_id;
+    }
+
+    if (ok && header.block_count > 0) {
+        log_index.blocks = malloc(header.block_count * sizeof(LogTimeBlock));
+        ok = log_index.blocks &&
+            fread(log_index.blocks, sizeof(LogTimeBlock), header.block_count, fptr) ==
+            (size_t)header.block_count;
+        log_index.block_count = log_index.block_capacity = header.block_count;
+    }
+
+    LogProductHead head;
+    for (long i = 0; ok && i < header.head_count; i++) {
+        ok = fread(&head, sizeof(head), 1, fptr) == 1;
+        LogProductHead* slot = ok ? find_head(head.product_id, true) : NULL;
+        ok = ok && slot != NULL;
+        if (ok) {
+            slot->last_seq = head.last_seq;
+        }
+    }
+    fclose(fptr);
+
+    if (ok) {
+        log_index.record_count = header.record_count;
+        log_index.last_timestamp = header.last_timestamp;
+        log_index.last_product_id = header.last_product_id;
+    }
+    return ok;
+}
+
+/*Writing transactions.idx (the link file is already on disk)*/
+static bool save_index_file() {
+    LogIndexHeader header = {
+        .magic = LOG_INDEX_MAGIC,
+        .version = LOG_INDEX_VERSION,
+        .record_count = log_index.record_count,
+        .last_timestamp = log_index.last_timestamp,
+        .last_product_id = log_index.last_product_id,
+        .block_count = log_index.block_count,
+        .head_count = log_index.head_count
+    };
+
+    FILE* fptr = fopen(LOG_INDEX_FILE, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(log_index.blocks, sizeof(LogTimeBlock), log_index.block_count, fptr) ==
+        (size_t)log_index.block_count;
+    for (long i = 0; ok && i < log_index.head_table_size; i++) {
+        if (log_index.heads[i].last_seq != LOG_NO_RECORD) {
+            ok = fwrite(&log_index.heads[i], sizeof(LogProductHead), 1, fptr) == 1;
+        }
+    }
+    if (fclose(fptr) != 0 || !ok) {
+        remove(LOG_INDEX_FILE);
+        return false;
+    }
+    return true;
+}
+
+/*Dropping all in-memory index state*/
+static void discard_index() {
+    if (log_index.links) {
+        fclose(log_index.links);
+    }
+    free(log_index.blocks);
+    free(log_index.heads);
+    memset(&log_index, 0, sizeof(log_index));
+}
+
+/*Appending a result to a growable array*/
+static bool push_result(Transaction** results, long* count, long* capacity, const Transaction* t) {
+    if (*count == *capacity) {
+        long new_capacity = *capacity ? *capacity * 2 : 64;
+        Transaction* grown = realloc(*results, new_capacity * sizeof(Transaction));
+        if (!grown) {
+            return false;
+        }
+        *results = grown;
+        *capacity = new_capacity;
+    }
+    (*results)[(*count)++] = *t;
+    return true;
+}
+
+/*===== Index lifecycle =====*/
+/*Reading the log record the saved index ends with, before the index lock is taken*/
+static bool read_saved_last(long long records, Transaction* last) {
+    FILE* fptr = fopen(LOG_INDEX_FILE, "rb");
+    if (!fptr) {
+        return false;
+    }
+    LogIndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fptr) == 1 &&
+        header.record_count > 0 && header.record_count <= records;
+    fclose(fptr);
+    return ok && log_read(header.record_count - 1, last, 1) == 1;
+}
+
+/*Loading the saved index, or starting an empty one (opener held)*/
+static bool load_index(long long records) {
+    Transaction last;
+    bool have_last = read_saved_last(records, &last);
+
+    index_lock();
+    bool loaded = load_index_file(records, have_last ? &last : NULL);
+    if (!loaded) {
+        discard_index();
+    }
+
+    /*Link entries past record_count are overwritten as records are indexed*/
+    log_index.links = loaded ? fopen(LOG_LINK_FILE, "r+b") : NULL;
+    if (!log_index.links) {
+        discard_index();
+        log_index.links = fopen(LOG_LINK_FILE, "w+b");
+        if (!log_index.links) {
+            index_unlock();
+            return false;
+        }
+    }
+
+    /*From here on the writer indexes its appends, and catch-up fills in whatever came before them*/
+    log_index.ready = true;
+    index_unlock();
+    return true;
+}
+
+/*Indexing records written after the saved index, until the index covers the whole log*/
+static bool catch_up() {
+    Transaction buffer[LOG_INDEX_BLOCK];
+    long long records = log_record_count();
+    for (;;) {
+        index_lock();
+        bool ready = log_index.ready;
+        long long seq = log_index.record_count;
+        index_unlock();
+        if (!ready) {
+            return false; // Closed or discarded meanwhile
+        }
+
+        /*Records written to the file are counted before the writer indexes them, so recount once covered*/
+        if (seq >= records) {
+            records = log_record_count();
+            if (seq >= records) {
+                return true;
+            }
+        }
+
+        long long remaining = records - seq;
+        int want = remaining < LOG_INDEX_BLOCK ? (int)remaining : LOG_INDEX_BLOCK;
+        int got = log_read(seq, buffer, want);
+        index_lock();
+        bool ok = got > 0 && (!log_index.ready || index_from(seq, buffer, got));
+        if (!ok) {
+            discard_index();
+        }
+        index_unlock();
+        if (!ok) {
+            return false;
+        }
+    }
+}
+
+/*Loading the saved index and indexing any records written after it*/
+bool log_index_open() {
+#ifndef _WIN32
+    pthread_mutex_lock(&open_mutex);
+#endif
+    index_lock();
+    bool ready = log_index.ready;
+    index_unlock();
+
+    bool ok = (ready || load_index(log_record_count())) && catch_up();
+#ifndef _WIN32
+    pthread_mutex_unlock(&open_mutex);
+#endif
+    return ok;
+}
+
+/*Saving the index so the next run only has to index new records*/
+void log_index_close() {
+    index_lock();
+    if (log_index.ready) {
+        fflush(log_index.links);
+        save_index_file();
+        discard_index();
+    }
+    index_unlock();
+}
+
+/*===== Maintenance =====*/
+/*Indexing records the writer has just appended to the log at record number seq*/
+void log_index_append(long long seq, const Transaction* records, int count) {
+    index_lock();
+    if (log_index.ready && count > 0 && !index_from(seq, records, count)) {
+        discard_index();
+    }
+    index_unlock();
+}
+
+/*===== Queries =====*/
+/*Visiting every record with from <= timestamp <= to, in log order (count, -1 on failure)*/
+long log_scan_range(time_t from, time_t to, LogVisitor visit, void* arg) {
+    log_commit();
+    if (!log_index_open()) {
+        return -1;
+    }
+
+    /*First block that can hold a timestamp >= from (running_max is sorted)*/
+    index_lock();
+    long long records = log_index.record_count; // Appends after this are not part of the scan
+    long lo = 0;
+    long hi = log_index.block_count;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (log_index.blocks[mid].running_max < (long long)from) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    index_unlock();
+
+    /*Each block is copied under the lock and its records read without it*/
+    Transaction buffer[LOG_INDEX_BLOCK];
+    long count = 0;
+    for (long b = lo; (long long)b * LOG_INDEX_BLOCK < records; b++) {
+        index_lock();
+        bool more = log_index.ready && b < log_index.block_count;
+        LogTimeBlock block = more ? log_index.blocks[b] : (LogTimeBlock){ 0 };
+        index_unlock();
+        if (!more) {
+            break;
+        }
+
+        /*Timestamps only go up apart from clock steps, so stop past the window*/
+        if (block.min_ts > (long long)to) {
+            break;
+        }
+        if (block.max_ts < (long long)from) {
+            continue;
+        }
+
+        long long seq = (long long)b * LOG_INDEX_BLOCK;
+        long long remaining = records - seq;
+        int want = remaining < LOG_INDEX_BLOCK ? (int)remaining : LOG_INDEX_BLOCK;
+        int got = log_read(seq, buffer, want);
+        if (got != want) {
+            return -1;
+        }
+        for (int i = 0; i < got; i++) {
+            if (buffer[i].timestamp < from || buffer[i].timestamp > to) {
+                continue;
+            }
+            if (!visit(&buffer[i], arg)) {
+                return -1;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+/*Collecting a product's record numbers, newest first, by walking its back-links (index lock held)*/
+static long product_chain(int product_id, long long** seqs) {
+    *seqs = NULL;
+    LogProductHead* head = log_index.ready ? find_head(product_id, false) : NULL;
+    if (!head) {
+        return 0;
+    }
+
+    long count = 0;
+    long capacity = 0;
+    for (long long seq = head->last_seq; seq != LOG_NO_RECORD; ) {
+        if (count == capacity) {
+            long new_capacity = capacity ? capacity * 2 : 64;
+            long long* grown = realloc(*seqs, new_capacity * sizeof(long long));
+            if (!grown) {
+                return -1;
+            }
+            *seqs = grown;
+            capacity = new_capacity;
+        }
+        (*seqs)[count++] = seq;
+        if (link_seek(log_index.links, seq * (long long)sizeof(long long), SEEK_SET) != 0 ||
+            fread(&seq, sizeof(long long), 1, log_index.links) != 1) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+/*Visiting a product's records with from <= timestamp <= to, oldest first (count, -1 on failure)*/
+long log_scan_product(int product_id, time_t from, time_t to, LogVisitor visit, void* arg) {
+    log_commit();
+    if (!log_index_open()) {
+        return -1;
+    }
+
+    long long* seqs;
+    index_lock();
+    long count = product_chain(product_id, &seqs);
+    index_unlock();
+    if (count < 0) {
+        free(seqs);
+        return -1;
+    }
+
+    long visited = 0;
+    for (long i = count - 1; i >= 0; i--) {
+        Transaction t;
+        if (log_read(seqs[i], &t, 1) != 1) {
+            free(seqs);
+            return -1;
+        }
+        if (t.timestamp < from || t.timestamp > to) {
+            continue;
+        }
+        if (!visit(&t, arg)) {
+            free(seqs);
+            return -1;
+        }
+        visited++;
+    }
+    free(seqs);
+    return visited;
+}
+
+/*Growable result array filled by the query visitors*/
+typedef struct {
+    Transaction* results;
+    long count;
+    long capacity;
+} LogResults;
+
+/*Collecting one record into a LogResults*/
+static bool collect_result(const Transaction* t, void* arg) {
+    LogResults* r = arg;
+    return push_result(&r->results, &r->count, &r->capacity, t);
+}
+
+/*Getting every record with from <= timestamp <= to, in log order (count, -1 on failure)*/
+long log_query_range(time_t from, time_t to, Transaction** results) {
+    LogResults r = { NULL, 0, 0 };
+    long count = log_scan_range(from, to, collect_result, &r);
+    if (count < 0) {
+        free(r.results);
+        r.results = NULL;
+    }
+    *results = r.results;
+    return count;
+}
+
+/*Getting a product's whole history, oldest first (count, -1 on failure)*/
+long log_query_product(int product_id, Transaction** results) {
+    LogResults r = { NULL, 0, 0 };
+    long count = log_scan_product(product_id, LOG_TIME_MIN, LOG_TIME_MAX, collect_result, &r);
+    if (count < 0) {
+        free(r.results);
+        r.results = NULL;
+    }
+    *results = r.results;
+    return count;
+}
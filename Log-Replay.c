@@ -0,0 +1,263 @@
+#include "include/log-replay.h"
+#include "include/inventory.h"
+#include "include/product-index.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include "include/backup-restore.h"
+#include "include/backup-catalog.h"
+#include "include/backup-delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/*===== Internal helpers =====*/
+/*Reading a monotonic clock in seconds*/
+static double replay_clock() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/*Applying one log record's after-image straight to the store (nothing is re-logged)*/
+static bool apply_record(const Transaction* t) {
+    long slot = index_lookup(t->product_id);
+
+    switch (t->type) {
+    case ADD:
+        if (t->after.id != t->product_id) {
+            return false;
+        }
+        if (slot == -1) {
+            slot = store_insert(&t->after);
+            return slot != -1 && index_insert(t->product_id, slot);
+        }
+        return store_write(slot, &t->after); // Already there: replay is idempotent
+
+    case DELETE:
+        if (slot == -1 || !store_delete(slot)) {
+            return false;
+        }
+        return index_remove(t->product_id);
+
+    default:
+        /*UPDATE, RESTOCK and SALE all carry the full record*/
+        if (slot == -1 || t->after.id != t->product_id) {
+            return false;
+        }
+        return store_write(slot, &t->after);
+    }
+}
+
+/*Reading the ranges earlier recoveries rolled back (returns the count, 0 if none)*/
+static int load_recoveries(LogRecovery** recoveries) {
+    *recoveries = NULL;
+    FILE* fptr = fopen(RECOVERY_FILE, "rb");
+    if (!fptr) {
+        return 0;
+    }
+    int count = 0;
+    int capacity = 0;
+    LogRecovery r;
+    while (fread(&r, sizeof(r), 1, fptr) == 1) {
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            LogRecovery* grown = realloc(*recoveries, capacity * sizeof(LogRecovery));
+            if (!grown) {
+                break;
+            }
+            *recoveries = grown;
+        }
+        (*recoveries)[count++] = r;
+    }
+    fclose(fptr);
+    return count;
+}
+
+/*Recording that records [from_seq, to_seq) were rolled back (durable before new records follow)*/
+static bool save_recovery(long long from_seq, long long to_seq) {
+    LogRecovery r = {
+        .from_seq = from_seq,
+        .to_seq = to_seq,
+        .recovered_at = (long long)time(NULL)
+    };
+    FILE* fptr = fopen(RECOVERY_FILE, "ab");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&r, sizeof(r), 1, fptr) == 1 && fflush(fptr) == 0;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(fptr)) == 0;
+#endif
+    return fclose(fptr) == 0 && ok;
+}
+
+/*Finding where replay resumes if seq lies in a rolled-back range, and where the next range starts*/
+static long long next_live_seq(long long seq, const LogRecovery* recoveries, int count, long long* next_range) {
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int i = 0; i < count; i++) {
+            if (seq >= recoveries[i].from_seq && seq < recoveries[i].to_seq) {
+                seq = recoveries[i].to_seq; // Ranges may overlap, so look again
+                moved = true;
+            }
+        }
+    }
+    *next_range = -1;
+    for (int i = 0; i < count; i++) {
+        if (recoveries[i].from_seq > seq && (*next_range == -1 || recoveries[i].from_seq < *next_range)) {
+            *next_range = recoveries[i].from_seq;
+        }
+    }
+    return seq;
+}
+
+/*Finding the newest catalogued backup taken at or before target that records its log position*/
+static const BackupEntry* backup_before(time_t target, long long* log_seq) {
+    LogRecovery* recoveries;
+    int recovery_count = load_recoveries(&recoveries);
+    BackupCatalog* catalog = backup_catalog_get();
+    const BackupEntry* found = NULL;
+    for (int i = catalog->count - 1; i >= 0 && !found; i--) {
+        const BackupEntry* e = &catalog->entries[i];
+        if (e->timestamp > target) {
+            continue;
+        }
+        BackupManifest manifest;
+        if (!load_backup_manifest(e->path, &manifest)) {
+            continue;
+        }
+        *log_seq = manifest.header.log_seq;
+        free_backup_manifest(&manifest);
+
+        /*A backup taken inside a rolled-back range holds changes that no longer happened*/
+        bool abandoned = false;
+        for (int r = 0; r < recovery_count; r++) {
+            abandoned = abandoned || (*log_seq > recoveries[r].from_seq && *log_seq <= recoveries[r].to_seq);
+        }
+        if (*log_seq >= 0 && !abandoned) {
+            found = e;
+        }
+    }
+    free(recoveries);
+    return found;
+}
+
+/*===== Replay =====*/
+/*Re-applying log records from from_seq, in batches, up to the last one at or before target*/
+bool replay_log(long long from_seq, time_t target, ReplayStats* stats) {
+    memset(stats, 0, sizeof(ReplayStats));
+    stats->start_seq = from_seq;
+    stats->end_seq = from_seq;
+
+    Transaction* batch = malloc(REPLAY_BATCH * sizeof(Transaction));
+    if (!batch) {
+        return false;
+    }
+
+    double start = replay_clock();
+    long long total = log_record_count();
+    long long seq = from_seq;
+    bool reached = false;
+    LogRecovery* recoveries;
+    int recovery_count = load_recoveries(&recoveries);
+
+    while (!reached && seq < total) {
+        /*Ranges rolled back by earlier recoveries are passed over*/
+        long long next_range;
+        long long live = next_live_seq(seq, recoveries, recovery_count, &next_range);
+        stats->superseded += (live < total ? live : total) - seq;
+        seq = live;
+        long long end = next_range != -1 && next_range < total ? next_range : total;
+        if (seq >= end) {
+            continue;
+        }
+
+        int want = end - seq < REPLAY_BATCH ? (int)(end - seq) : REPLAY_BATCH;
+        int got = log_read(seq, batch, want);
+        if (got <= 0) {
+            break;
+        }
+        for (int i = 0; i < got; i++) {
+            /*The log is in commit order, so the first later record ends the replay*/
+            if (batch[i].timestamp > target) {
+                reached = true;
+                break;
+            }
+            if (apply_record(&batch[i])) {
+                stats->applied++;
+            }
+            else {
+                stats->skipped++;
+            }
+            stats->last_timestamp = batch[i].timestamp;
+            seq++;
+        }
+        store_flush();
+    }
+
+    free(batch);
+    free(recoveries);
+    stats->end_seq = seq;
+    stats->seconds = replay_clock() - start;
+
+    /*Slot-based indexes and statistics are rebuilt from the replayed store*/
+    bool ok = store_checkpoint();
+    inventory_reload();
+    return ok;
+}
+
+/*Restoring the newest backup before target, then replaying the log up to target*/
+bool recover_to_time(time_t target, ReplayStats* stats) {
+    memset(stats, 0, sizeof(ReplayStats));
+
+    /*Buffered records must be on disk before the log is read back*/
+    log_commit();
+
+    long long log_seq = -1;
+    const BackupEntry* base = backup_before(target, &log_seq);
+    if (!base) {
+        printf("No backup with a recorded log position exists before that time.\n");
+        return false;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s", base->path);
+
+    printf("Restoring %s (log position %lld)\n", path, log_seq);
+    if (!restore_backup(path)) {
+        return false;
+    }
+    long long total = log_record_count();
+    bool ok = replay_log(log_seq, target, stats);
+
+    /*Records after target stay in the log for auditing, but a later recovery must not replay them*/
+    if (ok && stats->end_seq < total && !save_recovery(stats->end_seq, total)) {
+        printf("Error: Could not record the recovery in %s!\n", RECOVERY_FILE);
+        return false;
+    }
+    return ok;
+}
+
+/*Printing how much was replayed and how fast*/
+void report_replay(const ReplayStats* stats) {
+    long long records = stats->end_seq - stats->start_seq - stats->superseded;
+    printf("Replayed %lld log records (%lld applied, %lld skipped) in %.3f s",
+        records, stats->applied, stats->skipped, stats->seconds);
+    if (stats->seconds > 0) {
+        printf(" - %.0f records/s", (double)records / stats->seconds);
+    }
+    printf("\n");
+    if (stats->last_timestamp != 0) {
+        char when[20];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&stats->last_timestamp));
+        printf("Inventory recovered to %s\n", when);
+    }
+}
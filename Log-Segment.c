@@ -0,0 +1,550 @@
+#include "include/log-segment.h"
+#include "include/inventory.h"
+#include "include/lz-codec.h"
+#include "include/transaction-log.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+/*Segment file header (followed by the block table, then the blocks)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    long long first_seq;
+    long long first_ts;
+    long long last_ts;
+    int record_count;
+    int block_count;
+} SegmentHeader;
+
+/*Manifest header (followed by count LogSegmentInfo)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    int count;
+} ManifestHeader;
+
+/*Global segment set (loaded on first use)*/
+static LogSegmentSet segment_set = {
+    .open_segment = -1,
+    .cached_block = -1
+};
+
+/*===== Internal helpers =====*/
+/*Creating the segment directory if it does not exist*/
+static void ensure_segment_dir() {
+    struct stat st = { 0 };
+    if (stat(LOG_SEGMENT_DIR, &st) == -1) {
+#ifdef _WIN32
+        _mkdir(LOG_SEGMENT_DIR);
+#else
+        mkdir(LOG_SEGMENT_DIR, 0755);
+#endif
+    }
+}
+
+/*Building the file name of the segment that starts at first_seq*/
+static void segment_path(long long first_seq, char* path, size_t size) {
+    snprintf(path, size, "%s/segment-%012lld.lz", LOG_SEGMENT_DIR, first_seq);
+}
+
+/*Replacing a file with a freshly written one*/
+static bool replace_file(const char* temp, const char* path) {
+#ifdef _WIN32
+    remove(path); // rename() does not overwrite on Windows
+#endif
+    return rename(temp, path) == 0;
+}
+
+/*Closing the segment held open for reading*/
+static void close_open_segment() {
+    if (segment_set.open_file) {
+        fclose(segment_set.open_file);
+    }
+    free(segment_set.open_blocks);
+    segment_set.open_file = NULL;
+    segment_set.open_blocks = NULL;
+    segment_set.open_segment = -1;
+    segment_set.cached_block = -1;
+}
+
+/*Appending a segment to the in-memory manifest*/
+static bool push_segment(const LogSegmentInfo* info) {
+    if (segment_set.count == segment_set.capacity) {
+        int new_capacity = segment_set.capacity ? segment_set.capacity * 2 : 16;
+        LogSegmentInfo* segments = realloc(segment_set.segments, new_capacity * sizeof(LogSegmentInfo));
+        if (!segments) {
+            return false;
+        }
+        segment_set.segments = segments;
+        segment_set.capacity = new_capacity;
+    }
+    segment_set.segments[segment_set.count++] = *info;
+    segment_set.sealed_records = info->first_seq + info->record_count;
+    return true;
+}
+
+/*Ordering segments by their first record*/
+static int compare_segments(const void* a, const void* b) {
+    const LogSegmentInfo* x = (const LogSegmentInfo*)a;
+    const LogSegmentInfo* y = (const LogSegmentInfo*)b;
+    return (x->first_seq > y->first_seq) - (x->first_seq < y->first_seq);
+}
+
+/*Reading transactions.manifest*/
+static bool load_manifest() {
+    FILE* fptr = fopen(LOG_MANIFEST_FILE, "rb");
+    if (!fptr) {
+        return false;
+    }
+
+    ManifestHeader header;
+    LogSegmentInfo info;
+    bool ok = fread(&header, sizeof(header), 1, fptr) == 1 &&
+        header.magic == LOG_MANIFEST_MAGIC &&
+        header.version == LOG_SEGMENT_VERSION &&
+        header.count >= 0;
+    for (int i = 0; ok && i < header.count; i++) {
+        ok = fread(&info, sizeof(info), 1, fptr) == 1 && push_segment(&info);
+    }
+    fclose(fptr);
+    return ok;
+}
+
+/*Writing transactions.manifest via a temporary file*/
+static bool save_manifest() {
+    ManifestHeader header = {
+        .magic = LOG_MANIFEST_MAGIC,
+        .version = LOG_SEGMENT_VERSION,
+        .count = segment_set.count
+    };
+
+    FILE* fptr = fopen(LOG_MANIFEST_TEMP, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(segment_set.segments, sizeof(LogSegmentInfo), segment_set.count, fptr) ==
+        (size_t)segment_set.count;
+    if (fclose(fptr) != 0 || !ok) {
+        remove(LOG_MANIFEST_TEMP);
+        return false;
+    }
+    return replace_file(LOG_MANIFEST_TEMP, LOG_MANIFEST_FILE);
+}
+
+/*Reading a whole log file into memory (returns the record count, -1 on failure)*/
+static long read_log_file(const char* path, Transaction** records) {
+    *records = NULL;
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    long count = (long)log_file_records(path);
+    if (count == 0) {
+        return 0;
+    }
+
+    FILE* fptr = fopen(path, "rb");
+    LogFileHeader header;
+    *records = malloc(count * sizeof(Transaction));
+    bool ok = fptr && *records &&
+        fread(&header, sizeof(header), 1, fptr) == 1 && header.magic == LOG_MAGIC &&
+        fread(*records, sizeof(Transaction), count, fptr) == (size_t)count;
+    if (fptr) {
+        fclose(fptr);
+    }
+    if (!ok) {
+        free(*records);
+        *records = NULL;
+        return -1;
+    }
+    return count;
+}
+
+/*Opening a segment file and its block table for reading*/
+static bool open_segment(int index) {
+    if (segment_set.open_segment == index) {
+        return true;
+    }
+    close_open_segment();
+
+    const LogSegmentInfo* info = &segment_set.segments[index];
+    char path[300];
+    segment_path(info->first_seq, path, sizeof(path));
+
+    SegmentHeader header;
+    FILE* fptr = fopen(path, "rb");
+    LogSegmentBlock* blocks = malloc(info->block_count * sizeof(LogSegmentBlock));
+    bool ok = fptr && blocks &&
+        fread(&header, sizeof(header), 1, fptr) == 1 &&
+        header.magic == LOG_SEGMENT_MAGIC &&
+        header.first_seq == info->first_seq &&
+        header.block_count == info->block_count &&
+        fread(blocks, sizeof(LogSegmentBlock), info->block_count, fptr) ==
+        (size_t)info->block_count;
+    if (!ok) {
+        if (fptr) {
+            fclose(fptr);
+        }
+        free(blocks);
+        return false;
+    }
+
+    segment_set.open_file = fptr;
+    segment_set.open_blocks = blocks;
+    segment_set.open_segment = index;
+    segment_set.cached_block = -1;
+    return true;
+}
+
+/*Reading one block of records of the given size from a segment file into out*/
+static bool read_block(FILE* fptr, const LogSegmentBlock* b, size_t record_size, void* out) {
+    size_t raw_size = (size_t)b->records * record_size;
+    if (b->records <= 0 || b->records > LOG_SEGMENT_BLOCK || b->stored_size <= 0 ||
+        (size_t)b->stored_size > lz_bound(raw_size)) {
+        return false;
+    }
+
+    unsigned char* stored = malloc(b->stored_size);
+    bool ok = stored &&
+        fseek(fptr, (long)b->offset, SEEK_SET) == 0 &&
+        fread(stored, 1, b->stored_size, fptr) == (size_t)b->stored_size;
+    if (ok && b->compressed) {
+        ok = lz_decompress(stored, b->stored_size, out, raw_size) == (long)raw_size;
+    }
+    else if (ok) {
+        ok = (size_t)b->stored_size == raw_size;
+        if (ok) {
+            memcpy(out, stored, raw_size);
+        }
+    }
+    free(stored);
+    return ok;
+}
+
+/*Decoding one block of the open segment into the cache*/
+static bool decode_block(int block) {
+    if (segment_set.cached_block == block) {
+        return true;
+    }
+    bool ok = read_block(segment_set.open_file, &segment_set.open_blocks[block],
+        sizeof(Transaction), segment_set.cache);
+    segment_set.cached_block = ok ? block : -1;
+    return ok;
+}
+
+/*Compressing records into the segment file that starts at first_seq (info describes it)*/
+static bool write_segment(const Transaction* records, long count, long long first_seq, LogSegmentInfo* info) {
+    ensure_segment_dir();
+    SegmentHeader header = {
+        .magic = LOG_SEGMENT_MAGIC,
+        .version = LOG_SEGMENT_VERSION,
+        .first_seq = first_seq,
+        .first_ts = (long long)records[0].timestamp,
+        .last_ts = (long long)records[count - 1].timestamp,
+        .record_count = (int)count,
+        .block_count = (int)((count + LOG_SEGMENT_BLOCK - 1) / LOG_SEGMENT_BLOCK)
+    };
+
+    char final_path[300], temp_path[310];
+    segment_path(header.first_seq, final_path, sizeof(final_path));
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", final_path);
+
+    size_t bound = lz_bound(LOG_SEGMENT_BLOCK * sizeof(Transaction));
+    LogSegmentBlock* blocks = calloc(header.block_count, sizeof(LogSegmentBlock));
+    unsigned char* packed = malloc(bound);
+    FILE* fptr = fopen(temp_path, "wb");
+    bool ok = blocks && packed && fptr;
+
+    /*Blocks follow the header and the block table*/
+    long long offset = (long long)sizeof(header) + (long long)header.block_count * sizeof(LogSegmentBlock);
+    ok = ok && fseek(fptr, (long)offset, SEEK_SET) == 0;
+
+    for (int b = 0; ok && b < header.block_count; b++) {
+        long first = (long)b * LOG_SEGMENT_BLOCK;
+        int n = (int)(count - first < LOG_SEGMENT_BLOCK ? count - first : LOG_SEGMENT_BLOCK);
+        const unsigned char* raw = (const unsigned char*)&records[first];
+        size_t raw_size = (size_t)n * sizeof(Transaction);
+
+        size_t size = lz_compress(raw, raw_size, packed, bound);
+        blocks[b].compressed = (size > 0 && size < raw_size);
+        if (!blocks[b].compressed) {
+            size = raw_size;
+        }
+        blocks[b].offset = offset;
+        blocks[b].stored_size = (int)size;
+        blocks[b].records = n;
+        ok = fwrite(blocks[b].compressed ? packed : raw, 1, size, fptr) == size;
+        offset += (long long)size;
+    }
+
+    ok = ok && fseek(fptr, 0, SEEK_SET) == 0 &&
+        fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(blocks, sizeof(LogSegmentBlock), header.block_count, fptr) ==
+        (size_t)header.block_count &&
+        fflush(fptr) == 0;
+#ifndef _WIN32
+    /*The segment must be durable before the manifest points at it*/
+    ok = ok && fsync(fileno(fptr)) == 0;
+#endif
+    if (fptr && fclose(fptr) != 0) {
+        ok = false;
+    }
+    free(blocks);
+    free(packed);
+
+    ok = ok && replace_file(temp_path, final_path);
+    if (!ok) {
+        remove(temp_path);
+        return false;
+    }
+
+    info->first_seq = header.first_seq;
+    info->first_ts = header.first_ts;
+    info->last_ts = header.last_ts;
+    info->stored_bytes = offset;
+    info->record_count = header.record_count;
+    info->block_count = header.block_count;
+    return true;
+}
+
+/*Rewriting a version 1 segment (records without an after-image) in place; closes fptr*/
+static bool migrate_segment(FILE* fptr, const SegmentHeader* header, LogSegmentInfo* info) {
+    LogSegmentBlock* blocks = malloc(header->block_count * sizeof(LogSegmentBlock));
+    LegacyTransaction* legacy = malloc(LOG_SEGMENT_BLOCK * sizeof(LegacyTransaction));
+    Transaction* records = malloc((size_t)header->record_count * sizeof(Transaction));
+    bool ok = blocks && legacy && records && header->record_count > 0 && header->block_count > 0 &&
+        fread(blocks, sizeof(LogSegmentBlock), header->block_count, fptr) == (size_t)header->block_count;
+
+    long done = 0;
+    for (int b = 0; ok && b < header->block_count; b++) {
+        ok = done + blocks[b].records <= header->record_count &&
+            read_block(fptr, &blocks[b], sizeof(LegacyTransaction), legacy);
+        for (int i = 0; ok && i < blocks[b].records; i++) {
+            log_upgrade_record(&legacy[i], &records[done++]);
+        }
+    }
+    fclose(fptr);
+    ok = ok && done == header->record_count &&
+        write_segment(records, done, header->first_seq, info);
+    free(blocks);
+    free(legacy);
+    free(records);
+    return ok;
+}
+
+/*Recreating the manifest from the segment file headers*/
+static bool rebuild_manifest() {
+    DIR* dir = opendir(LOG_SEGMENT_DIR);
+    if (!dir) {
+        return true; // Nothing sealed yet
+    }
+
+    struct dirent* ent;
+    char path[300];
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "segment-", 8) != 0 || !strstr(ent->d_name, ".lz") ||
+            strstr(ent->d_name, ".tmp")) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", LOG_SEGMENT_DIR, ent->d_name);
+
+        FILE* fptr = fopen(path, "rb");
+        SegmentHeader header;
+        struct stat st;
+        bool readable = fptr && fread(&header, sizeof(header), 1, fptr) == 1 &&
+            header.magic == LOG_SEGMENT_MAGIC && stat(path, &st) == 0;
+        LogSegmentInfo info = { 0 };
+        if (readable && header.version == LOG_SEGMENT_VERSION) {
+            info.first_seq = header.first_seq;
+            info.first_ts = header.first_ts;
+            info.last_ts = header.last_ts;
+            info.stored_bytes = (long long)st.st_size;
+            info.record_count = header.record_count;
+            info.block_count = header.block_count;
+        }
+        else if (readable && header.version == LOG_SEGMENT_LEGACY_VERSION) {
+            readable = migrate_segment(fptr, &header, &info);
+            fptr = NULL; // Closed by the migration
+        }
+        else {
+            readable = false;
+        }
+
+        if (readable) {
+            push_segment(&info);
+        }
+        else {
+            /*Sealing past a segment we cannot place would reuse its record numbers*/
+            segment_set.unrecognised++;
+            printf("Transaction log error: cannot read segment %s\n", path);
+        }
+        if (fptr) {
+            fclose(fptr);
+        }
+    }
+    closedir(dir);
+
+    qsort(segment_set.segments, segment_set.count, sizeof(LogSegmentInfo), compare_segments);
+    if (segment_set.count > 0) {
+        LogSegmentInfo* last = &segment_set.segments[segment_set.count - 1];
+        segment_set.sealed_records = last->first_seq + last->record_count;
+    }
+
+    /*Without a manifest the next load rebuilds (and refuses to seal) again*/
+    return segment_set.unrecognised == 0 && save_manifest();
+}
+
+/*Finishing a seal that a crash or an earlier failure interrupted (true once none is pending)*/
+bool log_finish_seal() {
+    Transaction* records;
+    long count = read_log_file(LOG_SEALING_FILE, &records);
+    if (count < 0) {
+        return true; // Nothing was being sealed
+    }
+
+    /*The manifest may already list it if the crash came after the update*/
+    if (count > 0 && segment_set.count > 0) {
+        const LogSegmentInfo* last = &segment_set.segments[segment_set.count - 1];
+        if (last->record_count == count &&
+            last->first_ts == (long long)records[0].timestamp &&
+            last->last_ts == (long long)records[count - 1].timestamp) {
+            free(records);
+            return remove(LOG_SEALING_FILE) == 0;
+        }
+    }
+    free(records);
+    return log_seal_file(LOG_SEALING_FILE);
+}
+
+/*===== Segment set lifecycle =====*/
+/*Loading the manifest (rebuilt from the segment files if missing or damaged)*/
+bool log_segments_load() {
+    if (segment_set.loaded) {
+        return true;
+    }
+    segment_set.count = 0;
+    segment_set.sealed_records = 0;
+    segment_set.unrecognised = 0;
+
+    /*Log files written by older versions are converted before anything reads them*/
+    log_file_upgrade(LOG_SEALING_FILE);
+    log_file_upgrade(LOG_FILE);
+
+    if (!load_manifest()) {
+        segment_set.count = 0;
+        segment_set.sealed_records = 0;
+        rebuild_manifest(); // Also migrates version 1 segments
+    }
+    segment_set.loaded = true;
+
+    log_finish_seal();
+    return true;
+}
+
+/*Releasing the manifest and any open segment*/
+void log_segments_close() {
+    close_open_segment();
+    free(segment_set.segments);
+    segment_set.segments = NULL;
+    segment_set.count = 0;
+    segment_set.capacity = 0;
+    segment_set.sealed_records = 0;
+    segment_set.unrecognised = 0;
+    segment_set.loaded = false;
+}
+
+/*===== Sealing =====*/
+/*Compressing a closed log file into the segment starting at first_seq (no shared state is changed)*/
+bool log_seal_prepare(const char* path, long long first_seq, LogSegmentInfo* info) {
+    memset(info, 0, sizeof(LogSegmentInfo));
+    info->first_seq = first_seq;
+    if (segment_set.unrecognised > 0) {
+        printf("Transaction log error: %d unreadable segment(s) in %s, not sealing\n",
+            segment_set.unrecognised, LOG_SEGMENT_DIR);
+        return false;
+    }
+
+    Transaction* records;
+    long count = read_log_file(path, &records);
+    if (count <= 0) {
+        return count == 0; // An empty file only has to be removed
+    }
+    bool ok = write_segment(records, count, first_seq, info);
+    free(records);
+    return ok;
+}
+
+/*Listing a prepared segment and deleting the file it was sealed from (log writer lock held)*/
+bool log_seal_install(const char* path, const LogSegmentInfo* info) {
+    if (info->record_count > 0) {
+        if (info->first_seq != segment_set.sealed_records ||
+            !push_segment(info) || !save_manifest()) {
+            return false;
+        }
+    }
+    remove(path);
+    return true;
+}
+
+/*Compressing a closed log file into the next segment, then deleting it*/
+bool log_seal_file(const char* path) {
+    if (!log_segments_load()) {
+        return false;
+    }
+    LogSegmentInfo info;
+    return log_seal_prepare(path, segment_set.sealed_records, &info) &&
+        log_seal_install(path, &info);
+}
+
+/*===== Reading =====*/
+/*Getting the number of records in sealed segments*/
+long long log_sealed_records() {
+    log_segments_load();
+    return segment_set.sealed_records;
+}
+
+/*Reading sealed records from the block holding seq (returns count read)*/
+int log_segment_read(long long seq, Transaction* buffer, int count) {
+    if (!log_segments_load() || seq < 0 || seq >= segment_set.sealed_records || count <= 0) {
+        return 0;
+    }
+
+    /*Finding the last segment starting at or before seq*/
+    int lo = 0;
+    int hi = segment_set.count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (segment_set.segments[mid].first_seq <= seq) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    const LogSegmentInfo* info = &segment_set.segments[lo];
+    if (seq >= info->first_seq + info->record_count) {
+        return 0; // Gap left by a lost segment
+    }
+
+    long long within = seq - info->first_seq;
+    int block = (int)(within / LOG_SEGMENT_BLOCK);
+    int offset = (int)(within % LOG_SEGMENT_BLOCK);
+    if (!open_segment(lo) || !decode_block(block)) {
+        return 0;
+    }
+
+    int available = segment_set.open_blocks[block].records - offset;
+    int n = count < available ? count : available;
+    memcpy(buffer, &segment_set.cache[offset], n * sizeof(Transaction));
+    return n;
+}
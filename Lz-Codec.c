@@ -0,0 +1,187 @@
+#include "include/lz-codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Byte-oriented LZ77 in the style of LZ4. Each sequence is:
+ *   token      high nibble = literal count, low nibble = match length - 4
+ *   [ext]      255-continued extra literal count when the nibble is 15
+ *   literals
+ *   offset     2 bytes little endian (absent after the final literals)
+ *   [ext]      255-continued extra match length when the nibble is 15
+ */
+
+/*===== Internal helpers =====*/
+/*Reading four bytes for hashing and match checks*/
+static unsigned int read32(const unsigned char* p) {
+    unsigned int v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*Hashing four bytes into the match finder table*/
+static unsigned int lz_hash(unsigned int v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/*Writing the 255-continued remainder of a length (false if out of room)*/
+static int put_length(unsigned char* dst, size_t capacity, size_t* op, size_t length) {
+    while (length >= 255) {
+        if (*op >= capacity) {
+            return 0;
+        }
+        dst[(*op)++] = 255;
+        length -= 255;
+    }
+    if (*op >= capacity) {
+        return 0;
+    }
+    dst[(*op)++] = (unsigned char)length;
+    return 1;
+}
+
+/*Reading a 255-continued length extension (false if the input ends)*/
+static int get_length(const unsigned char* src, size_t size, size_t* ip, size_t* length) {
+    unsigned char b;
+    do {
+        if (*ip >= size) {
+            return 0;
+        }
+        b = src[(*ip)++];
+        *length += b;
+    } while (b == 255);
+    return 1;
+}
+
+/*Emitting one sequence (match_length 0 marks the final literals)*/
+static int put_sequence(unsigned char* dst, size_t capacity, size_t* op,
+    const unsigned char* literals, size_t literal_count, size_t offset, size_t match_length) {
+    size_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+
+    if (*op >= capacity) {
+        return 0;
+    }
+    unsigned char* token = &dst[(*op)++];
+    *token = (unsigned char)(((literal_count < 15 ? literal_count : 15) << 4) |
+        (match_code < 15 ? match_code : 15));
+
+    if (literal_count >= 15 && !put_length(dst, capacity, op, literal_count - 15)) {
+        return 0;
+    }
+    if (*op + literal_count > capacity) {
+        return 0;
+    }
+    memcpy(&dst[*op], literals, literal_count);
+    *op += literal_count;
+
+    if (match_length == 0) {
+        return 1;
+    }
+    if (*op + 2 > capacity) {
+        return 0;
+    }
+    dst[(*op)++] = (unsigned char)(offset & 0xFF);
+    dst[(*op)++] = (unsigned char)(offset >> 8);
+    if (match_code >= 15 && !put_length(dst, capacity, op, match_code - 15)) {
+        return 0;
+    }
+    return 1;
+}
+
+/*===== Codec =====*/
+/*Worst-case compressed size of size input bytes*/
+size_t lz_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+/*Compressing src into dst (returns the compressed size, 0 if it does not fit)*/
+size_t lz_compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+    long* table = malloc(((size_t)1 << LZ_HASH_BITS) * sizeof(long));
+    if (!table) {
+        return 0;
+    }
+    for (size_t i = 0; i < ((size_t)1 << LZ_HASH_BITS); i++) {
+        table[i] = -1;
+    }
+
+    size_t ip = 0;
+    size_t anchor = 0;
+    size_t op = 0;
+    int ok = 1;
+
+    while (ok && ip + LZ_MIN_MATCH <= size) {
+        unsigned int v = read32(&src[ip]);
+        unsigned int h = lz_hash(v);
+        long candidate = table[h];
+        table[h] = (long)ip;
+
+        if (candidate < 0 || ip - (size_t)candidate > LZ_MAX_OFFSET ||
+            read32(&src[candidate]) != v) {
+            ip++;
+            continue;
+        }
+
+        /*Extending the match as far as it goes*/
+        size_t length = LZ_MIN_MATCH;
+        while (ip + length < size && src[candidate + length] == src[ip + length]) {
+            length++;
+        }
+        ok = put_sequence(dst, capacity, &op, &src[anchor], ip - anchor,
+            ip - (size_t)candidate, length);
+        ip += length;
+        anchor = ip;
+    }
+
+    ok = ok && put_sequence(dst, capacity, &op, &src[anchor], size - anchor, 0, 0);
+    free(table);
+    return ok ? op : 0;
+}
+
+/*Decompressing src into dst (returns the decompressed size, -1 if corrupt)*/
+long lz_decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < size) {
+        unsigned char token = src[ip++];
+
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !get_length(src, size, &ip, &literal_count)) {
+            return -1;
+        }
+        if (ip + literal_count > size || op + literal_count > capacity) {
+            return -1;
+        }
+        memcpy(&dst[op], &src[ip], literal_count);
+        ip += literal_count;
+        op += literal_count;
+
+        /*The final sequence has no match part*/
+        if (ip == size) {
+            break;
+        }
+        if (ip + 2 > size) {
+            return -1;
+        }
+        size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+
+        size_t length = token & 0x0F;
+        if (length == 15 && !get_length(src, size, &ip, &length)) {
+            return -1;
+        }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || op + length > capacity) {
+            return -1;
+        }
+
+        /*Byte by byte, since a match may overlap its own output*/
+        const unsigned char* from = &dst[op - offset];
+        for (size_t i = 0; i < length; i++) {
+            dst[op + i] = from[i];
+        }
+        op += length;
+    }
+    return (long)op;
+}
@@ -0,0 +1,324 @@
+#include "include/name-index.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*Global name index (built on the first search)*/
+static NameIndex name_index = { 0 };
+
+/*===== Internal helpers =====*/
+/*Lowercasing a fixed-width name into dst, returning its length*/
+static int normalize_name(const char* name, char* dst) {
+    int len = 0;
+    while (len < MAX_NAME_LEN - 1 && name[len]) {
+        dst[len] = (char)tolower((unsigned char)name[len]);
+        len++;
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+/*Packing three characters into a trigram key*/
+static unsigned int trigram_key(const char* s) {
+    return ((unsigned int)(unsigned char)s[0] << 16) |
+        ((unsigned int)(unsigned char)s[1] << 8) |
+        (unsigned int)(unsigned char)s[2];
+}
+
+/*Hashing a trigram key*/
+static long trigram_bucket(unsigned int key, long table_size) {
+    return (long)((key * 2654435761u) & (unsigned int)(table_size - 1));
+}
+
+/*Doubling the trigram table*/
+static bool grow_table() {
+    long new_size = name_index.table_size ? name_index.table_size * 2 : TRIGRAM_TABLE_INITIAL;
+    TrigramPosting* table = calloc(new_size, sizeof(TrigramPosting));
+    if (!table) {
+        return false;
+    }
+    for (long i = 0; i < new_size; i++) {
+        table[i].key = TRIGRAM_EMPTY;
+    }
+    for (long i = 0; i < name_index.table_size; i++) {
+        if (name_index.table[i].key != TRIGRAM_EMPTY) {
+            long b = trigram_bucket(name_index.table[i].key, new_size);
+            while (table[b].key != TRIGRAM_EMPTY) {
+                b = (b + 1) & (new_size - 1);
+            }
+            table[b] = name_index.table[i];
+        }
+    }
+    free(name_index.table);
+    name_index.table = table;
+    name_index.table_size = new_size;
+    return true;
+}
+
+/*Finding the posting of a trigram (NULL if absent, created if asked)*/
+static TrigramPosting* find_posting(unsigned int key, bool create) {
+    if (name_index.table_size == 0) {
+        if (!create || !grow_table()) {
+            return NULL;
+        }
+    }
+
+    long b = trigram_bucket(key, name_index.table_size);
+    while (name_index.table[b].key != TRIGRAM_EMPTY) {
+        if (name_index.table[b].key == key) {
+            return &name_index.table[b];
+        }
+        b = (b + 1) & (name_index.table_size - 1);
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    /*Keeping the table at most half full*/
+    if ((name_index.used + 1) * 2 > name_index.table_size) {
+        if (!grow_table()) {
+            return NULL;
+        }
+        return find_posting(key, true);
+    }
+    name_index.table[b].key = key;
+    name_index.used++;
+    return &name_index.table[b];
+}
+
+/*Adding a slot to the posting list of every distinct trigram of its name*/
+static void index_name(long slot, const char* name) {
+    char norm[MAX_NAME_LEN];
+    unsigned int keys[MAX_NAME_LEN];
+    int key_count = 0;
+    int len = normalize_name(name, norm);
+
+    for (int i = 0; i + 3 <= len; i++) {
+        unsigned int key = trigram_key(&norm[i]);
+        bool duplicate = false;
+        for (int k = 0; k < key_count && !duplicate; k++) {
+            duplicate = (keys[k] == key);
+        }
+        if (duplicate) {
+            continue;
+        }
+        keys[key_count++] = key;
+
+        TrigramPosting* posting = find_posting(key, true);
+        if (!posting) {
+            continue;
+        }
+        if (posting->count == posting->capacity) {
+            long new_capacity = posting->capacity ? posting->capacity * 2 : 4;
+            long* slots = realloc(posting->slots, new_capacity * sizeof(long));
+            if (!slots) {
+                continue;
+            }
+            posting->slots = slots;
+            posting->capacity = new_capacity;
+        }
+        posting->slots[posting->count++] = slot;
+    }
+    name_index.live++;
+}
+
+/*Making sure the per-slot stamp array covers the store*/
+static bool ensure_seen_capacity(long records) {
+    if (records <= name_index.seen_capacity) {
+        return true;
+    }
+    unsigned int* seen = realloc(name_index.seen, records * sizeof(unsigned int));
+    if (!seen) {
+        return false;
+    }
+    memset(seen + name_index.seen_capacity, 0,
+        (records - name_index.seen_capacity) * sizeof(unsigned int));
+    name_index.seen = seen;
+    name_index.seen_capacity = records;
+    return true;
+}
+
+/*Scoring a name against a lowercased query (0 if it does not match)*/
+static int score_name(const char* name, const char* query, int* name_len) {
+    char norm[MAX_NAME_LEN];
+    *name_len = normalize_name(name, norm);
+
+    const char* hit = strstr(norm, query);
+    if (!hit) {
+        return 0;
+    }
+    if (hit == norm) {
+        return NAME_MATCH_PREFIX;
+    }
+
+    /*Looking for any occurrence that starts a word*/
+    while (hit) {
+        if (hit == norm || !isalnum((unsigned char)hit[-1])) {
+            return NAME_MATCH_WORD;
+        }
+        hit = strstr(hit + 1, query);
+    }
+    return NAME_MATCH_SUBSTRING;
+}
+
+/*Ranking: better score, then shorter name, then lower ID*/
+static int compare_matches(const void* a, const void* b) {
+    const NameMatch* x = (const NameMatch*)a;
+    const NameMatch* y = (const NameMatch*)b;
+    if (x->score != y->score) {
+        return y->score - x->score;
+    }
+    if (x->name_len != y->name_len) {
+        return x->name_len - y->name_len;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/*Appending a hit to a growable match array*/
+static bool push_match(NameMatch** matches, int* count, int* capacity, long slot, const Product* p, int score, int name_len) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        NameMatch* grown = realloc(*matches, new_capacity * sizeof(NameMatch));
+        if (!grown) {
+            return false;
+        }
+        *matches = grown;
+        *capacity = new_capacity;
+    }
+    NameMatch* m = &(*matches)[(*count)++];
+    m->slot = slot;
+    m->id = p->id;
+    m->score = score;
+    m->name_len = name_len;
+    return true;
+}
+
+/*===== Index lifecycle =====*/
+/*Building the index with one scan of the store*/
+bool name_index_build() {
+    name_index_reset();
+
+    long records = store_count();
+    for (long slot = 0; slot < records; slot++) {
+        const Product* p = store_record(slot);
+        if (store_is_live(p)) {
+            index_name(slot, p->name);
+        }
+    }
+
+    name_index.built = true;
+    return true;
+}
+
+/*Dropping the index so the next search rebuilds it*/
+void name_index_reset() {
+    for (long i = 0; i < name_index.table_size; i++) {
+        free(name_index.table[i].slots);
+    }
+    free(name_index.table);
+    free(name_index.seen);
+    memset(&name_index, 0, sizeof(name_index));
+}
+
+/*===== Maintenance =====*/
+/*Indexing a new or renamed product (old postings are dropped lazily)*/
+void name_index_update(long slot, const Product* before, const Product* after) {
+    if (!name_index.built) {
+        return; // Built from the store on next search
+    }
+    if (before && after && strncmp(before->name, after->name, MAX_NAME_LEN) == 0) {
+        return;
+    }
+    if (before) {
+        name_index.live--;
+        name_index.stale++;
+    }
+    if (after) {
+        index_name(slot, after->name);
+    }
+
+    /*Rebuilding once stale postings outnumber live names*/
+    if (name_index.stale > 1024 && name_index.stale > name_index.live) {
+        name_index_reset();
+    }
+}
+
+/*===== Queries =====*/
+/*Searching names for a substring, best matches first (returns count)*/
+int name_index_search(const char* query, NameMatch* results, int max_results) {
+    char q[MAX_NAME_LEN];
+    int q_len = normalize_name(query, q);
+    if (q_len == 0 || max_results <= 0) {
+        return 0;
+    }
+    if (!name_index.built && !name_index_build()) {
+        return -1;
+    }
+
+    long records = store_count();
+    NameMatch* matches = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    if (q_len < 3) {
+        /*Too short for a trigram: scan the names directly*/
+        for (long slot = 0; slot < records; slot++) {
+            const Product* p = store_record(slot);
+            int name_len;
+            int score = store_is_live(p) ? score_name(p->name, q, &name_len) : 0;
+            if (score > 0) {
+                push_match(&matches, &count, &capacity, slot, p, score, name_len);
+            }
+        }
+    }
+    else {
+        /*Driving the search from the rarest trigram of the query*/
+        TrigramPosting* rarest = NULL;
+        for (int i = 0; i + 3 <= q_len; i++) {
+            TrigramPosting* posting = find_posting(trigram_key(&q[i]), false);
+            if (!posting) {
+                return 0; // Some trigram never occurs, nothing can match
+            }
+            if (!rarest || posting->count < rarest->count) {
+                rarest = posting;
+            }
+        }
+
+        if (!ensure_seen_capacity(records)) {
+            return -1;
+        }
+        if (++name_index.stamp == 0) {
+            memset(name_index.seen, 0, name_index.seen_capacity * sizeof(unsigned int));
+            name_index.stamp = 1;
+        }
+
+        /*Verifying each candidate against its current record*/
+        for (long i = 0; i < rarest->count; i++) {
+            long slot = rarest->slots[i];
+            if (slot >= records || name_index.seen[slot] == name_index.stamp) {
+                continue;
+            }
+            name_index.seen[slot] = name_index.stamp;
+
+            const Product* p = store_record(slot);
+            int name_len;
+            int score = store_is_live(p) ? score_name(p->name, q, &name_len) : 0;
+            if (score > 0) {
+                push_match(&matches, &count, &capacity, slot, p, score, name_len);
+            }
+        }
+    }
+
+    qsort(matches, count, sizeof(NameMatch), compare_matches);
+    if (count > max_results) {
+        count = max_results;
+    }
+    if (count > 0) {
+        memcpy(results, matches, count * sizeof(NameMatch));
+    }
+    free(matches);
+    return count;
+}
@@ -0,0 +1,259 @@
+#include "include/product-index.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+/*Sidecar header (followed by capacity IndexEntry buckets)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    long long file_size; // inventory.dat size when the sidecar was written
+    long long file_mtime; // inventory.dat mtime when the sidecar was written
+    long long capacity;
+    long long count;
+} IndexHeader;
+
+/*Global product index (built once, kept in sync by the CRUD functions)*/
+static ProductIndex product_index = { 0 };
+
+/*===== Internal helpers =====*/
+/*Hashing a product ID (Knuth multiplicative hash)*/
+static size_t index_hash(int id, size_t capacity) {
+    unsigned int h = (unsigned int)id * 2654435761u;
+    return (size_t)h & (capacity - 1);
+}
+
+/*Allocating an empty bucket array*/
+static IndexEntry* index_alloc_entries(size_t capacity) {
+    IndexEntry* entries = malloc(capacity * sizeof(IndexEntry));
+    if (!entries) {
+        return NULL;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        entries[i].id = 0;
+        entries[i].slot = INDEX_EMPTY_SLOT;
+    }
+    return entries;
+}
+
+/*Placing an entry without checking load factor*/
+static void index_place(IndexEntry* entries, size_t capacity, int id, long slot) {
+    size_t i = index_hash(id, capacity);
+    while (entries[i].slot != INDEX_EMPTY_SLOT) {
+        i = (i + 1) & (capacity - 1);
+    }
+    entries[i].id = id;
+    entries[i].slot = slot;
+}
+
+/*Doubling the bucket array when the load factor passes 0.7*/
+static bool index_grow() {
+    size_t new_capacity = product_index.capacity * 2;
+    IndexEntry* entries = index_alloc_entries(new_capacity);
+    if (!entries) {
+        return false;
+    }
+
+    for (size_t i = 0; i < product_index.capacity; i++) {
+        if (product_index.entries[i].slot != INDEX_EMPTY_SLOT) {
+            index_place(entries, new_capacity,
+                product_index.entries[i].id, product_index.entries[i].slot);
+        }
+    }
+
+    free(product_index.entries);
+    product_index.entries = entries;
+    product_index.capacity = new_capacity;
+    return true;
+}
+
+/*Finding the bucket holding an ID (-1 if absent)*/
+static long index_find_bucket(int id) {
+    if (!product_index.entries) {
+        return -1;
+    }
+    size_t i = index_hash(id, product_index.capacity);
+    while (product_index.entries[i].slot != INDEX_EMPTY_SLOT) {
+        if (product_index.entries[i].id == id) {
+            return (long)i;
+        }
+        i = (i + 1) & (product_index.capacity - 1);
+    }
+    return -1;
+}
+
+/*===== Index lifecycle =====*/
+/*Building the index by scanning the record store once*/
+bool index_build() {
+    index_reset();
+
+    product_index.capacity = INDEX_INITIAL_CAPACITY;
+    product_index.entries = index_alloc_entries(product_index.capacity);
+    if (!product_index.entries) {
+        product_index.capacity = 0;
+        return false;
+    }
+
+    long records = store_count();
+    for (long slot = 0; slot < records; slot++) {
+        const Product* p = store_record(slot);
+        /*First record wins, matching the old linear scan*/
+        if (store_is_live(p) && index_find_bucket(p->id) == -1) {
+            index_insert(p->id, slot);
+        }
+    }
+
+    product_index.built = true;
+    return true;
+}
+
+/*Dropping the index so the next lookup rebuilds it (e.g. after a restore)*/
+void index_reset() {
+    free(product_index.entries);
+    product_index.entries = NULL;
+    product_index.capacity = 0;
+    product_index.count = 0;
+    product_index.built = false;
+}
+
+/*Making sure the index is built before use*/
+bool index_ready() {
+    if (product_index.built) {
+        return true;
+    }
+    return index_build();
+}
+
+/*Loading the sidecar if it still matches inventory.dat (instead of scanning the store)*/
+bool index_load() {
+    index_reset();
+
+    FILE* fptr = fopen(INDEX_FILE, "rb");
+    if (!fptr) {
+        return false;
+    }
+
+    IndexHeader header;
+    struct stat st;
+    bool ok = (fread(&header, sizeof(header), 1, fptr) == 1) &&
+        header.magic == INDEX_MAGIC &&
+        header.version == INDEX_VERSION &&
+        header.capacity >= INDEX_INITIAL_CAPACITY &&
+        (header.capacity & (header.capacity - 1)) == 0 &&
+        header.count >= 0 && header.count * 10 <= header.capacity * 7 &&
+        stat(FILENAME, &st) == 0 &&
+        header.file_size == (long long)st.st_size &&
+        header.file_mtime == (long long)st.st_mtime;
+
+    IndexEntry* entries = ok ? malloc((size_t)header.capacity * sizeof(IndexEntry)) : NULL;
+    ok = ok && entries &&
+        fread(entries, sizeof(IndexEntry), (size_t)header.capacity, fptr) == (size_t)header.capacity;
+    fclose(fptr);
+
+    /*A crash before the next clean shutdown must not leave a stale sidecar*/
+    remove(INDEX_FILE);
+
+    if (!ok) {
+        free(entries);
+        return false;
+    }
+
+    product_index.entries = entries;
+    product_index.capacity = (size_t)header.capacity;
+    product_index.count = (size_t)header.count;
+    product_index.built = true;
+    return true;
+}
+
+/*Writing the sidecar (inventory.dat must be closed and trimmed)*/
+bool index_save() {
+    struct stat st;
+    if (!product_index.built || stat(FILENAME, &st) != 0) {
+        return false;
+    }
+
+    IndexHeader header = {
+        .magic = INDEX_MAGIC,
+        .version = INDEX_VERSION,
+        .file_size = (long long)st.st_size,
+        .file_mtime = (long long)st.st_mtime,
+        .capacity = (long long)product_index.capacity,
+        .count = (long long)product_index.count
+    };
+
+    FILE* fptr = fopen(INDEX_FILE, "wb");
+    if (!fptr) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fptr) == 1 &&
+        fwrite(product_index.entries, sizeof(IndexEntry), product_index.capacity, fptr) ==
+        product_index.capacity;
+    if (fclose(fptr) != 0 || !ok) {
+        remove(INDEX_FILE);
+        return false;
+    }
+    return true;
+}
+
+/*===== Index operations =====*/
+/*Looking up the record slot of a product (-1 if not found)*/
+long index_lookup(int id) {
+    if (!index_ready()) {
+        return -1;
+    }
+    long bucket = index_find_bucket(id);
+    return bucket == -1 ? -1 : product_index.entries[bucket].slot;
+}
+
+/*Inserting or replacing the slot of a product*/
+bool index_insert(int id, long slot) {
+    /*An index that was never built is built first (index_build() allocates before inserting)*/
+    if (!product_index.entries && !index_ready()) {
+        return false;
+    }
+    long bucket = index_find_bucket(id);
+    if (bucket != -1) {
+        product_index.entries[bucket].slot = slot;
+        return true;
+    }
+
+    /*Keeping load factor below 0.7*/
+    if ((product_index.count + 1) * 10 > product_index.capacity * 7) {
+        if (!index_grow()) {
+            return false;
+        }
+    }
+
+    index_place(product_index.entries, product_index.capacity, id, slot);
+    product_index.count++;
+    return true;
+}
+
+/*Removing a product using backward-shift deletion (no tombstones)*/
+bool index_remove(int id) {
+    long bucket = index_find_bucket(id);
+    if (bucket == -1) {
+        return false;
+    }
+
+    size_t mask = product_index.capacity - 1;
+    size_t hole = (size_t)bucket;
+    size_t i = (hole + 1) & mask;
+
+    while (product_index.entries[i].slot != INDEX_EMPTY_SLOT) {
+        size_t home = index_hash(product_index.entries[i].id, product_index.capacity);
+        /*Shifting back entries whose probe path crosses the hole*/
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            product_index.entries[hole] = product_index.entries[i];
+            hole = i;
+        }
+        i = (i + 1) & mask;
+    }
+
+    product_index.entries[hole].id = 0;
+    product_index.entries[hole].slot = INDEX_EMPTY_SLOT;
+    product_index.count--;
+    return true;
+}
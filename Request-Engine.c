@@ -0,0 +1,400 @@
+#include "include/request-engine.h"
+#include "include/inventory.h"
+#include "include/product-index.h"
+#include "include/storage-engine.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/*Worker pool and its request queue*/
+typedef struct {
+    bool running;
+    bool stopping;
+    int threads;
+    Request* queue[ENGINE_QUEUE_CAPACITY]; // Ring of waiting requests
+    int head;
+    int count;
+    int in_flight; // Queued or being run
+#ifndef _WIN32
+    pthread_t workers[MAX_ENGINE_THREADS];
+    pthread_mutex_t lock; // Guards the queue and done flags
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_cond_t finished;
+#endif
+} RequestEngine;
+
+static RequestEngine engine = {
+    .running = false,
+#ifndef _WIN32
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty = PTHREAD_COND_INITIALIZER,
+    .not_full = PTHREAD_COND_INITIALIZER,
+    .finished = PTHREAD_COND_INITIALIZER
+#endif
+};
+
+#ifndef _WIN32
+/*One record lock, padded to its own cache line so stripes do not share one*/
+typedef struct {
+    pthread_rwlock_t lock;
+    char pad[64 - sizeof(pthread_rwlock_t) % 64];
+} RecordLock;
+
+/*Locks shared by every caller, engine threads or not*/
+typedef struct {
+    pthread_once_t once;
+    pthread_rwlock_t catalog; // Shared for record operations, exclusive for structural ones
+    pthread_mutex_t shared_state; // Statistics, secondary indexes, transaction ring
+    RecordLock stripes[ENGINE_LOCK_STRIPES];
+} EngineLocks;
+
+static EngineLocks locks = {
+    .once = PTHREAD_ONCE_INIT,
+    .shared_state = PTHREAD_MUTEX_INITIALIZER
+};
+
+static _Thread_local int catalog_depth = 0; // Catalog locks this thread holds (outermost counts)
+static _Thread_local bool catalog_exclusive = false; // The outermost hold is the write lock
+#endif
+
+/*===== Internal helpers =====*/
+#ifndef _WIN32
+/*Creating the catalog and record locks once*/
+static void init_locks() {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    /*Adds and deletes must not starve behind a steady stream of sales*/
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&locks.catalog, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    for (int i = 0; i < ENGINE_LOCK_STRIPES; i++) {
+        pthread_rwlock_init(&locks.stripes[i].lock, NULL);
+    }
+}
+
+/*Picking the stripe of a product (neighbouring IDs land on different stripes)*/
+static pthread_rwlock_t* record_lock(int id) {
+    pthread_once(&locks.once, init_locks);
+    unsigned int h = (unsigned int)id * 2654435761u;
+    return &locks.stripes[(h >> 16) % ENGINE_LOCK_STRIPES].lock;
+}
+#endif
+
+/*Running one request through the inventory API (which takes its own locks)*/
+static void run_request(Request* req) {
+    switch (req->type) {
+    case REQUEST_GET: {
+        Product* p = get_product(req->id);
+        req->success = (p != NULL);
+        if (p) {
+            req->product = *p;
+            free(p);
+        }
+        break;
+    }
+    case REQUEST_ADD:
+        req->success = add_product(req->product);
+        break;
+    case REQUEST_UPDATE:
+        req->success = update_product(req->id, req->product);
+        break;
+    case REQUEST_DELETE:
+        req->success = delete_product(req->id);
+        break;
+    case REQUEST_SELL:
+    case REQUEST_RESTOCK: {
+        StockMovement m = {
+            .id = req->id,
+            .type = req->type == REQUEST_SELL ? SALE : RESTOCK,
+            .quantity = req->quantity
+        };
+        apply_stock_movements(&m, 1);
+        req->result = m.result;
+        req->stock_after = m.stock_after;
+        req->success = (m.result == STOCK_OK);
+        break;
+    }
+    }
+}
+
+#ifndef _WIN32
+/*Serving requests from the queue until the engine stops*/
+static void* engine_worker(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&engine.lock);
+        while (engine.count == 0 && !engine.stopping) {
+            pthread_cond_wait(&engine.not_empty, &engine.lock);
+        }
+        if (engine.count == 0) {
+            pthread_mutex_unlock(&engine.lock);
+            return NULL; // Stopping and nothing left
+        }
+        Request* req = engine.queue[engine.head];
+        engine.head = (engine.head + 1) % ENGINE_QUEUE_CAPACITY;
+        engine.count--;
+        pthread_cond_signal(&engine.not_full);
+        pthread_mutex_unlock(&engine.lock);
+
+        run_request(req);
+
+        pthread_mutex_lock(&engine.lock);
+        req->done = 1;
+        engine.in_flight--;
+        pthread_cond_broadcast(&engine.finished);
+        pthread_mutex_unlock(&engine.lock);
+    }
+}
+#endif
+
+/*===== Engine lifecycle =====*/
+/*Starting the worker pool (requests run on the caller where threads are unavailable)*/
+bool engine_start(int threads) {
+    if (engine.running) {
+        return true;
+    }
+#ifdef _WIN32
+    (void)threads;
+    return false;
+#else
+    if (threads <= 0) {
+        threads = DEFAULT_ENGINE_THREADS;
+    }
+    if (threads > MAX_ENGINE_THREADS) {
+        threads = MAX_ENGINE_THREADS;
+    }
+
+    /*Workers only look products up, so the index must exist before they start*/
+    engine_lock_catalog(true);
+    bool ready = store_open() && index_ready();
+    engine_unlock_catalog();
+    if (!ready) {
+        return false;
+    }
+
+    engine.stopping = false;
+    engine.head = 0;
+    engine.count = 0;
+    engine.in_flight = 0;
+    engine.threads = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&engine.workers[i], NULL, engine_worker, NULL) != 0) {
+            break;
+        }
+        engine.threads++;
+    }
+    engine.running = engine.threads > 0;
+    return engine.running;
+#endif
+}
+
+/*Finishing queued requests and stopping the workers*/
+void engine_stop() {
+    if (!engine.running) {
+        return;
+    }
+#ifndef _WIN32
+    pthread_mutex_lock(&engine.lock);
+    engine.stopping = true;
+    pthread_cond_broadcast(&engine.not_empty);
+    pthread_mutex_unlock(&engine.lock);
+    for (int i = 0; i < engine.threads; i++) {
+        pthread_join(engine.workers[i], NULL);
+    }
+#endif
+    engine.threads = 0;
+    engine.running = false;
+}
+
+/*Checking whether the worker pool is up*/
+bool engine_running() {
+    return engine.running;
+}
+
+/*Reading the worker count from storage.cfg*/
+int load_engine_threads() {
+    int threads = DEFAULT_ENGINE_THREADS;
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+
+    if (fptr) {
+        char line[256];
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "engine_threads=%d", &threads) == 1) {
+                continue;
+            }
+        }
+        fclose(fptr);
+    }
+
+    /*Falling back to the default on nonsense values*/
+    if (threads <= 0 || threads > MAX_ENGINE_THREADS) {
+        threads = DEFAULT_ENGINE_THREADS;
+    }
+    return threads;
+}
+
+/*===== Requests =====*/
+/*Queueing a request (blocks while the queue is full)*/
+bool engine_submit(Request* req) {
+    req->done = 0;
+    if (!engine.running) {
+        run_request(req);
+        req->done = 1;
+        return true;
+    }
+#ifndef _WIN32
+    pthread_mutex_lock(&engine.lock);
+    while (engine.count == ENGINE_QUEUE_CAPACITY && !engine.stopping) {
+        pthread_cond_wait(&engine.not_full, &engine.lock);
+    }
+    if (engine.stopping) {
+        pthread_mutex_unlock(&engine.lock);
+        return false;
+    }
+    engine.queue[(engine.head + engine.count) % ENGINE_QUEUE_CAPACITY] = req;
+    engine.count++;
+    engine.in_flight++;
+    pthread_cond_signal(&engine.not_empty);
+    pthread_mutex_unlock(&engine.lock);
+#endif
+    return true;
+}
+
+/*Waiting until a submitted request has been served*/
+void engine_wait(Request* req) {
+#ifndef _WIN32
+    pthread_mutex_lock(&engine.lock);
+    while (!req->done) {
+        pthread_cond_wait(&engine.finished, &engine.lock);
+    }
+    pthread_mutex_unlock(&engine.lock);
+#else
+    (void)req;
+#endif
+}
+
+/*Running a request and waiting for its outcome*/
+bool engine_execute(Request* req) {
+    if (!engine_submit(req)) {
+        return false;
+    }
+    engine_wait(req);
+    return req->success;
+}
+
+/*Running one sale or restock through a worker, filling in its result and stock level*/
+bool engine_move_stock(StockMovement* m) {
+    Request req = {
+        .type = m->type == SALE ? REQUEST_SELL : REQUEST_RESTOCK,
+        .id = m->id,
+        .quantity = m->quantity
+    };
+    m->result = STOCK_WRITE_FAILED; // Unless a worker serves it (refused while stopping)
+    m->stock_after = 0;
+    if (engine_submit(&req)) {
+        engine_wait(&req);
+        m->result = req.result;
+        m->stock_after = req.stock_after;
+    }
+    return m->result == STOCK_OK;
+}
+
+/*Waiting until every queued request has been served*/
+void engine_drain() {
+#ifndef _WIN32
+    pthread_mutex_lock(&engine.lock);
+    while (engine.in_flight > 0) {
+        pthread_cond_wait(&engine.finished, &engine.lock);
+    }
+    pthread_mutex_unlock(&engine.lock);
+#endif
+}
+
+/*Running fn with every request held off (reports, backups, restores, compaction)*/
+void engine_exclusive(void (*fn)(void* arg), void* arg) {
+    engine_lock_catalog(true);
+    fn(arg);
+    /*A restore or replay drops the index; workers expect it built*/
+    index_ready();
+    engine_unlock_catalog();
+}
+
+/*===== Locking =====*/
+/*Taking the catalog lock: shared for record operations, exclusive when slots or files change*/
+void engine_lock_catalog(bool exclusive) {
+#ifndef _WIN32
+    if (catalog_depth++ > 0) {
+        /*A shared hold cannot be upgraded: other readers may be inside as well*/
+        assert(!exclusive || catalog_exclusive);
+        return; // Nested call: the outer lock already covers it
+    }
+    pthread_once(&locks.once, init_locks);
+
+    /*The stdio store shares one stream, so its readers serialize too*/
+    catalog_exclusive = exclusive || store_engine() != STORE_MMAP;
+    if (catalog_exclusive) {
+        pthread_rwlock_wrlock(&locks.catalog);
+    }
+    else {
+        pthread_rwlock_rdlock(&locks.catalog);
+    }
+#else
+    (void)exclusive;
+#endif
+}
+
+/*Releasing the catalog lock*/
+void engine_unlock_catalog() {
+#ifndef _WIN32
+    if (--catalog_depth > 0) {
+        return;
+    }
+    pthread_rwlock_unlock(&locks.catalog);
+#endif
+}
+
+/*Locking one product's record: shared to read it, exclusive to change it*/
+void engine_lock_record(int id, bool exclusive) {
+#ifndef _WIN32
+    if (exclusive) {
+        pthread_rwlock_wrlock(record_lock(id));
+    }
+    else {
+        pthread_rwlock_rdlock(record_lock(id));
+    }
+#else
+    (void)id;
+    (void)exclusive;
+#endif
+}
+
+/*Unlocking one product's record*/
+void engine_unlock_record(int id) {
+#ifndef _WIN32
+    pthread_rwlock_unlock(record_lock(id));
+#else
+    (void)id;
+#endif
+}
+
+/*Guarding state every change updates (statistics, secondary indexes, the log ring)*/
+void engine_lock_shared_state() {
+#ifndef _WIN32
+    pthread_mutex_lock(&locks.shared_state);
+#endif
+}
+
+/*Releasing the shared state*/
+void engine_unlock_shared_state() {
+#ifndef _WIN32
+    pthread_mutex_unlock(&locks.shared_state);
+#endif
+}
@@ -0,0 +1,235 @@
+#include "include/stock-index.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*Global quantity index (kept in sync on every stock change)*/
+static StockIndex stock_index = { 0 };
+
+/*===== Internal helpers =====*/
+/*Mapping a quantity to its bucket*/
+static int bucket_for(int quantity) {
+    if (quantity < 0) {
+        return STOCK_NEGATIVE;
+    }
+    return quantity < STOCK_BUCKETS ? quantity : STOCK_OVERFLOW;
+}
+
+/*Growing the per-slot arrays so slot fits*/
+static bool ensure_capacity(long slot) {
+    if (slot < stock_index.capacity) {
+        return true;
+    }
+
+    long new_capacity = stock_index.capacity ? stock_index.capacity : 1024;
+    while (new_capacity <= slot) {
+        new_capacity *= 2;
+    }
+
+    long* next = realloc(stock_index.next, new_capacity * sizeof(long));
+    if (!next) {
+        return false;
+    }
+    stock_index.next = next;
+    long* prev = realloc(stock_index.prev, new_capacity * sizeof(long));
+    if (!prev) {
+        return false;
+    }
+    stock_index.prev = prev;
+    int* bucket = realloc(stock_index.bucket, new_capacity * sizeof(int));
+    if (!bucket) {
+        return false;
+    }
+    stock_index.bucket = bucket;
+
+    for (long i = stock_index.capacity; i < new_capacity; i++) {
+        stock_index.bucket[i] = -1;
+    }
+    stock_index.capacity = new_capacity;
+    return true;
+}
+
+/*Linking a slot at the head of a bucket*/
+static void link_slot(long slot, int bucket) {
+    if (!ensure_capacity(slot)) {
+        return;
+    }
+    long head = stock_index.heads[bucket];
+    stock_index.next[slot] = head;
+    stock_index.prev[slot] = STOCK_NIL;
+    if (head != STOCK_NIL) {
+        stock_index.prev[head] = slot;
+    }
+    stock_index.heads[bucket] = slot;
+    stock_index.bucket[slot] = bucket;
+}
+
+/*Unlinking a slot from whatever bucket holds it*/
+static void unlink_slot(long slot) {
+    if (slot >= stock_index.capacity || stock_index.bucket[slot] == -1) {
+        return;
+    }
+    long next = stock_index.next[slot];
+    long prev = stock_index.prev[slot];
+    if (prev != STOCK_NIL) {
+        stock_index.next[prev] = next;
+    }
+    else {
+        stock_index.heads[stock_index.bucket[slot]] = next;
+    }
+    if (next != STOCK_NIL) {
+        stock_index.prev[next] = prev;
+    }
+    stock_index.bucket[slot] = -1;
+}
+
+/*Ordering matches from an unsorted bucket by quantity*/
+typedef struct {
+    int quantity;
+    long slot;
+} BucketMatch;
+
+static int compare_matches(const void* a, const void* b) {
+    const BucketMatch* x = (const BucketMatch*)a;
+    const BucketMatch* y = (const BucketMatch*)b;
+    if (x->quantity != y->quantity) {
+        return x->quantity < y->quantity ? -1 : 1;
+    }
+    return x->slot < y->slot ? -1 : (x->slot > y->slot);
+}
+
+/*Appending one slot to a growing result list*/
+static bool append_slot(long** result, int* count, int* capacity, long slot) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        long* grown = realloc(*result, new_capacity * sizeof(long));
+        if (!grown) {
+            return false;
+        }
+        *result = grown;
+        *capacity = new_capacity;
+    }
+    (*result)[(*count)++] = slot;
+    return true;
+}
+
+/*Appending the slots of an unsorted bucket below threshold, in ascending quantity order*/
+static bool append_sorted(int bucket, int threshold, long** result, int* count, int* capacity) {
+    int matches = 0;
+    int match_capacity = 0;
+    BucketMatch* found = NULL;
+    for (long s = stock_index.heads[bucket]; s != STOCK_NIL; s = stock_index.next[s]) {
+        const Product* p = store_record(s);
+        if (!p || p->quantity >= threshold) {
+            continue;
+        }
+        if (matches == match_capacity) {
+            match_capacity = match_capacity ? match_capacity * 2 : 64;
+            BucketMatch* grown = realloc(found, match_capacity * sizeof(BucketMatch));
+            if (!grown) {
+                free(found);
+                return false;
+            }
+            found = grown;
+        }
+        found[matches].quantity = p->quantity;
+        found[matches].slot = s;
+        matches++;
+    }
+
+    qsort(found, matches, sizeof(BucketMatch), compare_matches);
+    bool ok = true;
+    for (int i = 0; ok && i < matches; i++) {
+        ok = append_slot(result, count, capacity, found[i].slot);
+    }
+    free(found);
+    return ok;
+}
+
+/*===== Index lifecycle =====*/
+/*Building the index with one scan of the store*/
+bool stock_index_build() {
+    stock_index_reset();
+
+    long records = store_count();
+    if (records > 0 && !ensure_capacity(records - 1)) {
+        return false;
+    }
+    /*Walking backwards so each bucket lists slots in ascending order*/
+    for (long slot = records - 1; slot >= 0; slot--) {
+        const Product* p = store_record(slot);
+        if (store_is_live(p)) {
+            link_slot(slot, bucket_for(p->quantity));
+        }
+    }
+
+    stock_index.built = true;
+    return true;
+}
+
+/*Dropping the index so the next query rebuilds it*/
+void stock_index_reset() {
+    free(stock_index.next);
+    free(stock_index.prev);
+    free(stock_index.bucket);
+    stock_index.next = NULL;
+    stock_index.prev = NULL;
+    stock_index.bucket = NULL;
+    stock_index.capacity = 0;
+    for (int i = 0; i <= STOCK_NEGATIVE; i++) {
+        stock_index.heads[i] = STOCK_NIL;
+    }
+    stock_index.built = false;
+}
+
+/*===== Maintenance =====*/
+/*Moving a slot to the bucket of its new quantity*/
+void stock_index_update(long slot, const Product* before, const Product* after) {
+    if (!stock_index.built) {
+        return; // Built from the store on next query
+    }
+    if (before && after && bucket_for(before->quantity) == bucket_for(after->quantity)) {
+        return;
+    }
+    unlink_slot(slot);
+    if (after) {
+        link_slot(slot, bucket_for(after->quantity));
+    }
+}
+
+/*===== Queries =====*/
+/*Collecting the slots below threshold in ascending quantity order (caller frees)*/
+int stock_index_query(int threshold, long** slots) {
+    *slots = NULL;
+    if (!stock_index.built && !stock_index_build()) {
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    long* result = NULL;
+
+    /*Negative stock sorts below every bucket, so any threshold can match it*/
+    bool ok = append_sorted(STOCK_NEGATIVE, threshold, &result, &count, &capacity);
+
+    /*Exact buckets, lowest first*/
+    int last = threshold < STOCK_BUCKETS ? threshold : STOCK_BUCKETS;
+    for (int b = 0; ok && b < last; b++) {
+        for (long s = stock_index.heads[b]; ok && s != STOCK_NIL; s = stock_index.next[s]) {
+            ok = append_slot(&result, &count, &capacity, s);
+        }
+    }
+
+    /*Large thresholds also need the (unsorted) overflow bucket*/
+    if (ok && threshold > STOCK_BUCKETS) {
+        ok = append_sorted(STOCK_OVERFLOW, threshold, &result, &count, &capacity);
+    }
+
+    if (!ok) {
+        free(result);
+        return -1;
+    }
+    *slots = result;
+    return count;
+}
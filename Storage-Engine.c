@@ -0,0 +1,1104 @@
+#include "include/storage-engine.h"
+#include "include/inventory.h"
+#include "include/write-ahead-log.h"
+#include "include/file-copy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*Record store state (one open handle for the whole process)*/
+typedef struct {
+    StorageEngine engine;
+    bool is_open;
+    long count; // Number of records in use
+    /*stdio engine*/
+    FILE* fptr;
+    long position; // Current stream position in records (-1 unknown)
+    bool writing; // Last stream operation was a write
+    Product buffer; // Backing storage for store_record()
+    /*mmap engine*/
+    int fd;
+    Product* map;
+    size_t map_len; // Bytes mapped
+    size_t file_len; // Bytes allocated in the file (>= count records)
+    long dirty_lo; // First dirty record since the last flush
+    long dirty_hi; // One past the last dirty record
+    /*Tombstones*/
+    long* free_slots; // Stack of tombstoned slots for reuse
+    long free_count;
+    long free_capacity;
+    long dead_count; // Tombstoned records in the file
+    bool free_built; // false until the file was scanned for tombstones
+    /*Write-ahead logging*/
+    bool logged; // Writes go through inventory.wal first
+    /*Batch staging: after-images wait until the batch's WAL records are synced*/
+    Product* staged; // Images in first-write order
+    long* staged_slots;
+    long staged_count;
+    long staged_capacity;
+    long* staged_table; // Open addressing, slot -> staged index + 1 (0 = empty), 2 * capacity entries
+    long staged_end; // Record count including staged appends
+#ifndef _WIN32
+    /*Concurrent writers (mmap engine, different records)*/
+    pthread_rwlock_t access; // Shared by writers, exclusive for checkpoints
+    pthread_mutex_t dirty_lock; // Guards the dirty range
+#endif
+} RecordStore;
+
+static RecordStore store = {
+    .engine = DEFAULT_STORAGE_ENGINE,
+    .fd = -1,
+    .position = -1,
+    .dirty_lo = -1,
+#ifndef _WIN32
+    .access = PTHREAD_RWLOCK_INITIALIZER,
+    .dirty_lock = PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/*Copy-on-write snapshot: pages keep their pre-image once written after the snapshot*/
+typedef struct {
+    bool active;
+    long count; // Records captured by the snapshot
+    long pages;
+    Product** saved; // Pre-image per page, NULL while the page is unchanged
+    FILE* reader; // stdio engine: separate handle for the snapshot reader
+#ifndef _WIN32
+    pthread_mutex_t lock; // Held by writers and the snapshot reader, never for long
+#endif
+} StoreSnapshot;
+
+static StoreSnapshot snapshot = {
+    .active = false,
+#ifndef _WIN32
+    .lock = PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/*===== Internal helpers =====*/
+/*Rounding a byte length up to whole grow chunks*/
+static size_t round_to_chunk(size_t bytes) {
+    size_t chunk = (size_t)STORE_GROW_CHUNK;
+    return ((bytes + chunk - 1) / chunk) * chunk;
+}
+
+/*Checking if a record is all zero bytes (unused file tail)*/
+static bool record_is_blank(const Product* p) {
+    const unsigned char* bytes = (const unsigned char*)p;
+    for (size_t i = 0; i < sizeof(Product); i++) {
+        if (bytes[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*Remembering which records need msync at the next durability point*/
+static void mark_dirty(long slot, long n) {
+#ifndef _WIN32
+    pthread_mutex_lock(&store.dirty_lock);
+#endif
+    if (store.dirty_lo == -1 || slot < store.dirty_lo) {
+        store.dirty_lo = slot;
+    }
+    if (slot + n > store.dirty_hi) {
+        store.dirty_hi = slot + n;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&store.dirty_lock);
+#endif
+}
+
+/*Pushing a slot on the free-slot stack*/
+static bool push_free_slot(long slot) {
+    if (store.free_count == store.free_capacity) {
+        long new_capacity = store.free_capacity ? store.free_capacity * 2 : 64;
+        long* slots = realloc(store.free_slots, new_capacity * sizeof(long));
+        if (!slots) {
+            return false;
+        }
+        store.free_slots = slots;
+        store.free_capacity = new_capacity;
+    }
+    store.free_slots[store.free_count++] = slot;
+    return true;
+}
+
+/*Collecting tombstones left in the file by earlier sessions*/
+static void build_free_list() {
+    if (store.free_built) {
+        return;
+    }
+    store.free_built = true;
+    store.free_count = 0;
+    store.dead_count = 0;
+    for (long slot = 0; slot < store.count; slot++) {
+        const Product* p = store_record(slot);
+        if (p && !store_is_live(p)) {
+            push_free_slot(slot);
+            store.dead_count++;
+        }
+    }
+}
+
+/*Taking the snapshot lock (no-op without threads)*/
+static void snapshot_lock() {
+#ifndef _WIN32
+    pthread_mutex_lock(&snapshot.lock);
+#endif
+}
+
+/*Releasing the snapshot lock*/
+static void snapshot_unlock() {
+#ifndef _WIN32
+    pthread_mutex_unlock(&snapshot.lock);
+#endif
+}
+
+/*Saving a page's pre-image before its first write since the snapshot (lock held)*/
+static bool preserve_page(long slot) {
+    if (slot >= snapshot.count) {
+        return true; // Appended after the snapshot: not part of it
+    }
+    long page = slot / SNAPSHOT_PAGE_RECORDS;
+    if (snapshot.saved[page]) {
+        return true;
+    }
+
+    long first = page * SNAPSHOT_PAGE_RECORDS;
+    long n = snapshot.count - first < SNAPSHOT_PAGE_RECORDS ? snapshot.count - first : SNAPSHOT_PAGE_RECORDS;
+    Product* copy = malloc(n * sizeof(Product));
+    if (!copy) {
+        return false;
+    }
+    for (long i = 0; i < n; i++) {
+        if (!store_read(first + i, &copy[i])) {
+            free(copy);
+            return false;
+        }
+    }
+    snapshot.saved[page] = copy;
+    return true;
+}
+
+/*Auto-closing the store so inventory.dat is trimmed on exit*/
+static void store_atexit() {
+    store_close();
+}
+
+#ifndef _WIN32
+/*Mapping (or remapping) the file to at least min_len bytes*/
+static bool mmap_remap(size_t min_len) {
+    size_t new_len = round_to_chunk(min_len > 0 ? min_len : 1);
+    if (store.map && new_len <= store.map_len) {
+        return true;
+    }
+
+    void* addr = mmap(NULL, new_len, PROT_READ | PROT_WRITE, MAP_SHARED, store.fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    if (store.map) {
+        munmap(store.map, store.map_len);
+    }
+    store.map = (Product*)addr;
+    store.map_len = new_len;
+    return true;
+}
+
+/*Opening and mapping inventory.dat*/
+static bool mmap_open() {
+    store.fd = open(FILENAME, O_RDWR | O_CREAT, 0644);
+    if (store.fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(store.fd, &st) != 0) {
+        close(store.fd);
+        store.fd = -1;
+        return false;
+    }
+
+    store.file_len = (size_t)st.st_size;
+    store.count = (long)(store.file_len / sizeof(Product));
+
+    if (!mmap_remap(store.file_len)) {
+        close(store.fd);
+        store.fd = -1;
+        return false;
+    }
+
+    /*Dropping zero padding left behind if the last session crashed*/
+    while (store.count > 0 && record_is_blank(&store.map[store.count - 1])) {
+        store.count--;
+    }
+    return true;
+}
+
+/*Growing the file (and mapping) so slot fits*/
+static bool mmap_reserve(long slot) {
+    size_t needed = (size_t)(slot + 1) * sizeof(Product);
+    if (needed > store.file_len) {
+        size_t new_len = store.file_len + (size_t)STORE_GROW_CHUNK;
+        if (new_len < needed) {
+            new_len = round_to_chunk(needed);
+        }
+        if (ftruncate(store.fd, (off_t)new_len) != 0) {
+            return false;
+        }
+        store.file_len = new_len;
+    }
+    return mmap_remap(needed);
+}
+
+/*Syncing dirty pages of the mapping*/
+static bool mmap_sync(int flags) {
+    /*Taking the range under the lock; msync itself runs without it*/
+    pthread_mutex_lock(&store.dirty_lock);
+    long dirty_lo = store.dirty_lo;
+    long dirty_hi = store.dirty_hi;
+    if (flags == MS_SYNC) {
+        store.dirty_lo = -1;
+        store.dirty_hi = 0;
+    }
+    pthread_mutex_unlock(&store.dirty_lock);
+    if (dirty_lo == -1 || !store.map) {
+        return true;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    size_t lo = ((size_t)dirty_lo * sizeof(Product)) & ~((size_t)page - 1);
+    size_t hi = (size_t)dirty_hi * sizeof(Product);
+    if (hi > store.map_len) {
+        hi = store.map_len;
+    }
+    return msync((char*)store.map + lo, hi - lo, flags) == 0;
+}
+
+/*Trimming chunk padding so the file holds exactly count records*/
+static bool mmap_trim() {
+    size_t exact = (size_t)store.count * sizeof(Product);
+    if (store.file_len == exact) {
+        return true;
+    }
+    if (ftruncate(store.fd, (off_t)exact) != 0) {
+        return false;
+    }
+    store.file_len = exact;
+    return true;
+}
+
+/*Unmapping and closing inventory.dat*/
+static void mmap_close() {
+    mmap_sync(MS_SYNC);
+    mmap_trim();
+    if (store.map) {
+        munmap(store.map, store.map_len);
+    }
+    if (store.fd >= 0) {
+        close(store.fd);
+    }
+    store.map = NULL;
+    store.map_len = 0;
+    store.file_len = 0;
+    store.fd = -1;
+}
+#endif
+
+/*Opening inventory.dat through stdio, creating it if missing*/
+static bool stdio_open() {
+    store.fptr = fopen(FILENAME, "rb+");
+    if (!store.fptr) {
+        store.fptr = fopen(FILENAME, "wb+");
+    }
+    if (!store.fptr) {
+        return false;
+    }
+
+    fseek(store.fptr, 0, SEEK_END);
+    store.count = ftell(store.fptr) / (long)sizeof(Product);
+    store.position = -1;
+    store.writing = false;
+    return true;
+}
+
+/*Positioning the stream at a slot (skipped for sequential access)*/
+static bool stdio_seek(long slot, bool for_write) {
+    if (store.position != slot || store.writing != for_write) {
+        if (fseek(store.fptr, slot * (long)sizeof(Product), SEEK_SET) != 0) {
+            store.position = -1;
+            return false;
+        }
+    }
+    store.position = slot;
+    store.writing = for_write;
+    return true;
+}
+
+/*Overwriting a record in place (the snapshot lock is held if one is active)*/
+static bool write_record(long slot, const Product* p) {
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        if (!mmap_reserve(slot)) {
+            return false;
+        }
+        store.map[slot] = *p;
+        mark_dirty(slot, 1);
+        if (slot == store.count) {
+            store.count++;
+        }
+        return true;
+    }
+#endif
+    if (!stdio_seek(slot, true)) {
+        return false;
+    }
+    if (fwrite(p, sizeof(Product), 1, store.fptr) != 1) {
+        store.position = -1;
+        return false;
+    }
+    store.position++;
+    if (slot == store.count) {
+        store.count++;
+    }
+    return true;
+}
+
+/*Writing n consecutive records from first with one copy (the snapshot lock is held if one is active)*/
+static bool write_records(long first, const Product* products, long n) {
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        if (!mmap_reserve(first + n - 1)) {
+            return false;
+        }
+        memcpy(&store.map[first], products, (size_t)n * sizeof(Product));
+        mark_dirty(first, n);
+        if (first + n > store.count) {
+            store.count = first + n;
+        }
+        return true;
+    }
+#endif
+    if (!stdio_seek(first, true)) {
+        return false;
+    }
+    if (fwrite(products, sizeof(Product), (size_t)n, store.fptr) != (size_t)n) {
+        store.position = -1;
+        return false;
+    }
+    store.position += n;
+    if (first + n > store.count) {
+        store.count = first + n;
+    }
+    return true;
+}
+
+/*Applying images to consecutive slots, keeping the snapshot's view of their pages first*/
+static bool apply_records(long first, const Product* products, long n) {
+    if (!snapshot.active) {
+        return n == 1 ? write_record(first, products) : write_records(first, products, n);
+    }
+    snapshot_lock();
+    bool ok = true;
+    for (long i = 0; ok && i < n; i++) {
+        ok = preserve_page(first + i);
+    }
+    ok = ok && (n == 1 ? write_record(first, products) : write_records(first, products, n));
+    snapshot_unlock();
+    return ok;
+}
+
+/*Checking if writes are being staged (a logged batch is open)*/
+static bool batch_staging() {
+    return store.logged && wal_in_batch();
+}
+
+/*Getting the record count as readers see it (staged appends included)*/
+static long visible_count() {
+    return store.staged_count > 0 ? store.staged_end : store.count;
+}
+
+/*Hashing a slot into the staging table*/
+static long staged_bucket(long slot) {
+    return (long)(((unsigned long)slot * 0x9E3779B97F4A7C15UL) & (unsigned long)(2 * store.staged_capacity - 1));
+}
+
+/*Finding the staged image of a slot (-1 if the slot was not written in this batch)*/
+static long staged_find(long slot) {
+    if (store.staged_count == 0) {
+        return -1;
+    }
+    for (long b = staged_bucket(slot); store.staged_table[b] != 0; b = (b + 1) & (2 * store.staged_capacity - 1)) {
+        long i = store.staged_table[b] - 1;
+        if (store.staged_slots[i] == slot) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*Doubling the staging area and rehashing it*/
+static bool grow_staging() {
+    long new_capacity = store.staged_capacity ? store.staged_capacity * 2 : 256;
+    Product* images = realloc(store.staged, new_capacity * sizeof(Product));
+    if (images) {
+        store.staged = images;
+    }
+    long* slots = realloc(store.staged_slots, new_capacity * sizeof(long));
+    if (slots) {
+        store.staged_slots = slots;
+    }
+    long* table = calloc(2 * new_capacity, sizeof(long));
+    if (!images || !slots || !table) {
+        free(table);
+        return false;
+    }
+    free(store.staged_table);
+    store.staged_table = table;
+    store.staged_capacity = new_capacity;
+    for (long i = 0; i < store.staged_count; i++) {
+        long b = staged_bucket(store.staged_slots[i]);
+        while (table[b] != 0) {
+            b = (b + 1) & (2 * new_capacity - 1);
+        }
+        table[b] = i + 1;
+    }
+    return true;
+}
+
+/*Holding an image back until the batch commits (a later write to the slot replaces it)*/
+static bool stage_write(long slot, const Product* p) {
+    long i = staged_find(slot);
+    if (i != -1) {
+        store.staged[i] = *p;
+        return true;
+    }
+    if (store.staged_count == 0) {
+        store.staged_end = store.count;
+    }
+    if (store.staged_count == store.staged_capacity && !grow_staging()) {
+        return false;
+    }
+
+    i = store.staged_count++;
+    store.staged[i] = *p;
+    store.staged_slots[i] = slot;
+    long b = staged_bucket(slot);
+    while (store.staged_table[b] != 0) {
+        b = (b + 1) & (2 * store.staged_capacity - 1);
+    }
+    store.staged_table[b] = i + 1;
+    if (slot >= store.staged_end) {
+        store.staged_end = slot + 1;
+    }
+    return true;
+}
+
+/*Forgetting every staged image*/
+static void clear_staging() {
+    if (store.staged_count > 0) {
+        memset(store.staged_table, 0, 2 * store.staged_capacity * sizeof(long));
+    }
+    store.staged_count = 0;
+}
+
+/*Writing the staged images to the store once the commit record is durable*/
+static bool apply_staged() {
+    long n = store.staged_count;
+    store.staged_count = 0; // Reads (and snapshot pre-images) must see the store itself again
+
+#ifndef _WIN32
+    pthread_rwlock_rdlock(&store.access);
+#endif
+    bool ok = true;
+    for (long i = 0; ok && i < n; ) {
+        /*Runs of consecutive slots (bulk appends) go in with one copy*/
+        long run = 1;
+        while (i + run < n && store.staged_slots[i + run] == store.staged_slots[i] + run) {
+            run++;
+        }
+        ok = apply_records(store.staged_slots[i], &store.staged[i], run);
+        i += run;
+    }
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+
+    store.staged_count = n;
+    clear_staging();
+    return ok;
+}
+
+/*Logging a write before it is applied (the current record is its before-image)*/
+static bool log_write_ahead(long slot, const Product* p) {
+    if (slot == visible_count()) {
+        return wal_append(slot, NULL, p);
+    }
+    Product before;
+    return store_read(slot, &before) && wal_append(slot, &before, p);
+}
+
+/*Forcing written records (and the file size) to stable storage*/
+static bool sync_data() {
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        return mmap_sync(MS_SYNC) && mmap_trim() && fsync(store.fd) == 0;
+    }
+    return fflush(store.fptr) == 0 && fsync(fileno(store.fptr)) == 0;
+#else
+    return fflush(store.fptr) == 0;
+#endif
+}
+
+/*Applying one recovered image without logging it again (NULL leaves a tombstone)*/
+static bool recover_record(long slot, const Product* p) {
+    if (slot < 0 || slot > store.count) {
+        return false; // A gap the log cannot fill
+    }
+    Product tombstone = { 0 };
+    tombstone.id = TOMBSTONE_ID;
+    return write_record(slot, p ? p : &tombstone);
+}
+
+/*Bringing inventory.dat back in line with the WAL of an interrupted session*/
+static void recover_from_wal() {
+    WalRecoveryStats stats;
+    bool complete = wal_recover(recover_record, &stats);
+    if (stats.redone > 0 || stats.undone > 0) {
+        printf("Recovered %s from %s: %lld writes redone, %lld rolled back\n",
+            FILENAME, WAL_FILE, stats.redone, stats.undone);
+    }
+    if (!complete) {
+        printf("Warning: some %s records did not fit %s and were skipped\n", WAL_FILE, FILENAME);
+    }
+
+    /*Recovered records must be on disk before the log describing them goes*/
+    if (stats.redone > 0 || stats.undone > 0) {
+        sync_data();
+    }
+    store.logged = load_wal_config().enabled;
+    if (store.logged) {
+        wal_reset();
+    }
+    else {
+        remove(WAL_FILE);
+    }
+}
+
+/*===== Store lifecycle =====*/
+/*Opening the record store with the selected engine*/
+bool store_open() {
+    if (store.is_open) {
+        return true;
+    }
+
+    static bool atexit_registered = false;
+    if (!atexit_registered) {
+        atexit(store_atexit);
+        atexit_registered = true;
+    }
+
+    bool opened = false;
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        opened = mmap_open();
+    }
+#endif
+    if (store.engine == STORE_STDIO) {
+        opened = stdio_open();
+    }
+
+    store.is_open = opened;
+    if (opened) {
+        recover_from_wal();
+    }
+    return opened;
+}
+
+/*Closing the store (syncs and trims inventory.dat)*/
+void store_close() {
+    if (!store.is_open) {
+        return;
+    }
+    /*A snapshot still being read is abandoned; its reader sees it end*/
+    store_snapshot_end();
+
+    /*A clean shutdown leaves the WAL empty*/
+    store_checkpoint();
+    wal_close();
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        mmap_close();
+    }
+#endif
+    if (store.engine == STORE_STDIO && store.fptr) {
+        fclose(store.fptr);
+        store.fptr = NULL;
+    }
+    store.count = 0;
+    store.position = -1;
+    store.dirty_lo = -1;
+    store.dirty_hi = 0;
+    free(store.free_slots);
+    store.free_slots = NULL;
+    store.free_count = 0;
+    store.free_capacity = 0;
+    store.dead_count = 0;
+    store.free_built = false;
+    clear_staging(); // An uncommitted batch is dropped, as recovery would drop it
+    free(store.staged);
+    free(store.staged_slots);
+    free(store.staged_table);
+    store.staged = NULL;
+    store.staged_slots = NULL;
+    store.staged_table = NULL;
+    store.staged_capacity = 0;
+    store.is_open = false;
+}
+
+/*Selecting the engine (mmap falls back to stdio where unavailable)*/
+bool store_set_engine(StorageEngine engine) {
+#ifdef _WIN32
+    if (engine == STORE_MMAP) {
+        return false;
+    }
+#endif
+    if (engine == store.engine) {
+        return true;
+    }
+    bool was_open = store.is_open;
+    store_close();
+    store.engine = engine;
+    return was_open ? store_open() : true;
+}
+
+/*Getting the active engine*/
+StorageEngine store_engine() {
+    return store.engine;
+}
+
+/*===== Record access =====*/
+/*Getting the number of records in the store*/
+long store_count() {
+    if (!store_open()) {
+        return 0;
+    }
+    return visible_count();
+}
+
+/*Getting a read-only view of a record (valid until the next store call)*/
+const Product* store_record(long slot) {
+    if (!store_open() || slot < 0 || slot >= visible_count()) {
+        return NULL;
+    }
+
+    /*An open batch reads its own staged writes*/
+    long staged = staged_find(slot);
+    if (staged != -1) {
+        return &store.staged[staged];
+    }
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        return &store.map[slot];
+    }
+#endif
+    if (!stdio_seek(slot, false)) {
+        return NULL;
+    }
+    if (fread(&store.buffer, sizeof(Product), 1, store.fptr) != 1) {
+        store.position = -1;
+        return NULL;
+    }
+    store.position++;
+    return &store.buffer;
+}
+
+/*Copying a record out of the store*/
+bool store_read(long slot, Product* out) {
+    const Product* p = store_record(slot);
+    if (!p) {
+        return false;
+    }
+    *out = *p;
+    return true;
+}
+
+/*Overwriting a record in place (staged until commit inside a batch)*/
+bool store_write(long slot, const Product* p) {
+    if (!store_open() || slot < 0 || slot > visible_count()) {
+        return false;
+    }
+#ifndef _WIN32
+    /*Writers of different records run together; only a checkpoint waits for them*/
+    pthread_rwlock_rdlock(&store.access);
+#endif
+    /*Logging first, so a crash part way through the write can be redone*/
+    bool ok = !store.logged || log_write_ahead(slot, p);
+    if (ok && batch_staging()) {
+        ok = stage_write(slot, p);
+    }
+    else if (ok) {
+        ok = apply_records(slot, p, 1);
+    }
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+    return ok;
+}
+
+/*Appending a record, returning its slot (-1 on failure)*/
+long store_append(const Product* p) {
+    long slot = store_count();
+    return store_write(slot, p) ? slot : -1;
+}
+
+/*Appending many records in one sequential write, returning the first slot (-1 on failure)*/
+long store_append_many(const Product* products, long n) {
+    if (!store_open() || n <= 0) {
+        return -1;
+    }
+    long first = visible_count();
+#ifndef _WIN32
+    pthread_rwlock_rdlock(&store.access);
+#endif
+    /*One WAL write per chunk of records, then one copy into the store (at commit inside a batch)*/
+    bool ok = !store.logged || wal_append_many(first, products, n);
+    bool staging = batch_staging();
+    for (long i = 0; ok && staging && i < n; i++) {
+        ok = stage_write(first + i, &products[i]);
+    }
+    if (ok && !staging) {
+        ok = apply_records(first, products, n);
+    }
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+    return ok ? first : -1;
+}
+
+/*Inserting a record into a free slot, or appending (-1 on failure)*/
+long store_insert(const Product* p) {
+    if (!store_open()) {
+        return -1;
+    }
+    build_free_list();
+
+    if (store.free_count > 0) {
+        long slot = store.free_slots[store.free_count - 1];
+        if (!store_write(slot, p)) {
+            return -1;
+        }
+        store.free_count--;
+        store.dead_count--;
+        return slot;
+    }
+    return store_append(p);
+}
+
+/*Deleting a record by writing a tombstone over it*/
+bool store_delete(long slot) {
+    if (!store_open()) {
+        return false;
+    }
+    build_free_list();
+
+    Product tombstone = { 0 };
+    tombstone.id = TOMBSTONE_ID;
+    if (!store_write(slot, &tombstone)) {
+        return false;
+    }
+    push_free_slot(slot);
+    store.dead_count++;
+    return true;
+}
+
+/*Checking if a record holds a product (not a tombstone)*/
+bool store_is_live(const Product* p) {
+    return p != NULL && p->id != TOMBSTONE_ID;
+}
+
+/*===== Space reclamation =====*/
+/*Getting the number of live products*/
+long store_live_count() {
+    if (!store_open()) {
+        return 0;
+    }
+    build_free_list();
+    return store.count - store.dead_count;
+}
+
+/*Getting the number of tombstoned records*/
+long store_dead_count() {
+    if (!store_open()) {
+        return 0;
+    }
+    build_free_list();
+    return store.dead_count;
+}
+
+/*Checking if the dead-record ratio has passed the threshold*/
+bool store_needs_compaction(double threshold) {
+    long dead = store_dead_count();
+    if (dead < MIN_COMPACTION_RECORDS || store.count == 0) {
+        return false;
+    }
+    return (double)dead / (double)store.count > threshold;
+}
+
+/*Rewriting inventory.dat without tombstones (slots change, callers reindex)*/
+bool store_compact() {
+    if (!store_open() || snapshot.active || wal_in_batch()) {
+        return false; // Compaction moves records under a running snapshot or batch
+    }
+
+    FILE* dst = fopen(TEMP_FILE, "wb");
+    if (!dst) {
+        return false;
+    }
+
+    bool success = true;
+    for (long slot = 0; slot < store.count && success; slot++) {
+        const Product* p = store_record(slot);
+        if (p && store_is_live(p)) {
+            success = (fwrite(p, sizeof(Product), 1, dst) == 1);
+        }
+    }
+
+    if (fclose(dst) != 0 || !success) {
+        remove(TEMP_FILE);
+        return false;
+    }
+
+    /*Closing empties the WAL (its slots refer to the old layout), then one rename swaps files*/
+    store_close();
+    if (!install_file(TEMP_FILE, FILENAME)) {
+        remove(TEMP_FILE);
+        store_open();
+        return false;
+    }
+    return store_open();
+}
+
+/*Reading the compaction threshold from storage.cfg*/
+double load_compaction_threshold() {
+    double threshold = DEFAULT_COMPACTION_THRESHOLD;
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+
+    if (fptr) {
+        char line[256];
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "compaction_threshold=%lf", &threshold) == 1) {
+                continue;
+            }
+        }
+        fclose(fptr);
+    }
+
+    /*Falling back to the default on nonsense values*/
+    if (threshold <= 0.0 || threshold >= 1.0) {
+        threshold = DEFAULT_COMPACTION_THRESHOLD;
+    }
+    return threshold;
+}
+
+/*===== Durability points =====*/
+/*Scheduling write-back of changes made by the last operation*/
+void store_flush() {
+    if (!store.is_open) {
+        return;
+    }
+
+    /*Data pages may only reach the disk after the log records describing them*/
+    if (store.logged && !wal_sync()) {
+        return;
+    }
+#ifndef _WIN32
+    if (store.engine == STORE_MMAP) {
+        mmap_sync(MS_ASYNC);
+    }
+#endif
+    if (store.engine == STORE_STDIO) {
+        fflush(store.fptr);
+    }
+
+    /*Checkpointing periodically keeps the WAL, and recovery, short*/
+    if (store.logged && wal_needs_checkpoint()) {
+        store_checkpoint();
+    }
+}
+
+/*Syncing data and emptying the WAL (writers held off by the caller)*/
+static bool checkpoint_locked() {
+    /*The log reaches disk before the data it describes*/
+    bool ok = wal_sync() && sync_data();
+    if (ok && store.logged && !wal_in_batch()) {
+        ok = wal_reset();
+    }
+    return ok;
+}
+
+/*Making inventory.dat complete on disk, then emptying the WAL that led up to it*/
+bool store_checkpoint() {
+    if (!store.is_open) {
+        return true;
+    }
+#ifndef _WIN32
+    /*No write may land between the data sync and emptying the WAL*/
+    pthread_rwlock_wrlock(&store.access);
+#endif
+    bool ok = checkpoint_locked();
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+    return ok;
+}
+
+/*===== Batches =====*/
+/*Grouping writes so recovery keeps all of them or none*/
+void store_begin_batch() {
+    wal_begin_batch();
+}
+
+/*Committing the batch, applying its staged writes once the commit is durable (then checkpointing if the WAL has grown)*/
+bool store_end_batch() {
+    bool outermost = wal_in_batch() && store.staged_count > 0;
+    bool ok = wal_end_batch();
+    if (outermost && !wal_in_batch()) {
+        /*A batch whose commit failed never happened: recovery would roll it back too*/
+        if (ok) {
+            ok = apply_staged();
+        }
+        else {
+            clear_staging();
+        }
+    }
+    if (store.logged && wal_needs_checkpoint()) {
+        store_checkpoint();
+    }
+    return ok;
+}
+
+/*===== Snapshots =====*/
+/*Freezing the current contents for a concurrent reader; writes keep going (at_freeze runs while frozen)*/
+bool store_snapshot_begin(SnapshotHook at_freeze, void* context) {
+    if (snapshot.active || !store_open()) {
+        return false;
+    }
+
+    /*The stdio engine's stream is not shared; unchanged pages are read from disk*/
+    FILE* reader = NULL;
+    if (store.engine == STORE_STDIO) {
+        reader = fopen(FILENAME, "rb");
+        if (!reader) {
+            return false;
+        }
+    }
+
+#ifndef _WIN32
+    /*Checkpoint, capture and activation are one critical section: no write lands between them unpreserved*/
+    pthread_rwlock_wrlock(&store.access);
+#endif
+    long pages = (store.count + SNAPSHOT_PAGE_RECORDS - 1) / SNAPSHOT_PAGE_RECORDS;
+    Product** saved = calloc(pages > 0 ? pages : 1, sizeof(Product*));
+    bool ok = saved && checkpoint_locked();
+    if (ok) {
+        snapshot_lock();
+        snapshot.count = store.count;
+        snapshot.pages = pages;
+        snapshot.saved = saved;
+        snapshot.reader = reader;
+        snapshot.active = true;
+        snapshot_unlock();
+        if (at_freeze) {
+            at_freeze(context);
+        }
+    }
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+
+    if (!ok) {
+        free(saved);
+        if (reader) {
+            fclose(reader);
+        }
+    }
+    return ok;
+}
+
+/*Getting the number of records captured by the active snapshot*/
+long store_snapshot_count() {
+    return snapshot.active ? snapshot.count : 0;
+}
+
+/*Reading records as they were at store_snapshot_begin() (safe from another thread)*/
+bool store_snapshot_read(long first, long n, Product* out) {
+    snapshot_lock();
+    bool ok = snapshot.active && first >= 0 && n >= 0 && first + n <= snapshot.count;
+
+    for (long slot = first; ok && slot < first + n; ) {
+        long page = slot / SNAPSHOT_PAGE_RECORDS;
+        long page_end = (page + 1) * SNAPSHOT_PAGE_RECORDS;
+        long run = (page_end < first + n ? page_end : first + n) - slot;
+
+        if (snapshot.saved[page]) {
+            memcpy(out, &snapshot.saved[page][slot - page * SNAPSHOT_PAGE_RECORDS], run * sizeof(Product));
+        }
+#ifndef _WIN32
+        else if (store.engine == STORE_MMAP) {
+            memcpy(out, &store.map[slot], run * sizeof(Product));
+        }
+#endif
+        else {
+            ok = fseek(snapshot.reader, slot * (long)sizeof(Product), SEEK_SET) == 0 &&
+                fread(out, sizeof(Product), run, snapshot.reader) == (size_t)run;
+        }
+        out += run;
+        slot += run;
+    }
+
+    snapshot_unlock();
+    return ok;
+}
+
+/*Dropping the snapshot and its saved pages*/
+void store_snapshot_end() {
+    if (!snapshot.active) {
+        return;
+    }
+#ifndef _WIN32
+    /*Writers test snapshot.active under the access lock, so it only changes under it*/
+    pthread_rwlock_wrlock(&store.access);
+#endif
+    snapshot_lock();
+    for (long page = 0; page < snapshot.pages; page++) {
+        free(snapshot.saved[page]);
+    }
+    free(snapshot.saved);
+    if (snapshot.reader) {
+        fclose(snapshot.reader);
+    }
+    snapshot.saved = NULL;
+    snapshot.reader = NULL;
+    snapshot.pages = 0;
+    snapshot.count = 0;
+    snapshot.active = false;
+    snapshot_unlock();
+#ifndef _WIN32
+    pthread_rwlock_unlock(&store.access);
+#endif
+}
+
+/*Checking whether a snapshot is active*/
+bool store_snapshot_active() {
+    return snapshot.active;
+}
@@ -0,0 +1,851 @@
+#include "include/transaction-log.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include "include/log-index.h"
+#include "include/log-segment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/*64-bit seeks, so the reader is not limited to 2 GB of log*/
+#ifdef _WIN32
+#define log_seek _fseeki64
+#else
+#define log_seek fseeko
+#endif
+
+/*Buffered log writer state (one open handle for the whole process)*/
+typedef struct {
+    bool is_open;
+#ifdef _WIN32
+    FILE* fptr;
+#else
+    int fd;
+#endif
+    Transaction ring[LOG_RING_CAPACITY]; // Pending transactions
+    int head; // Index of the oldest pending transaction
+    int pending; // Number of pending transactions
+    time_t oldest; // Timestamp when the oldest pending was queued
+    LogWriterConfig config;
+    bool config_loaded;
+    int group_depth; // > 0 while a caller is batching a group
+    FILE* reader; // Shared read handle for indexed queries
+    long long active_records; // Records in transactions.log (the active segment)
+    time_t active_started; // Timestamp of its first record (0 if empty)
+    bool flushing; // A group write is running with the lock released
+#ifndef _WIN32
+    bool flusher_running; // Background thread writing out records that aged past flush_seconds
+    bool stopping;
+    pthread_t flusher;
+    bool sealing; // transactions.sealing is being compressed by the sealer thread
+    bool sealer_joinable;
+    pthread_t sealer;
+    long long seal_first_seq; // Record number the segment being sealed starts at
+    pthread_mutex_t lock; // Guards everything above; never held across a group write
+    pthread_cond_t flushed; // Signalled when a group write finishes
+    pthread_cond_t queued; // Signalled when the flusher has something new to wait for
+#endif
+} LogWriter;
+
+static LogWriter writer = {
+#ifndef _WIN32
+    .fd = -1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .flushed = PTHREAD_COND_INITIALIZER,
+    .queued = PTHREAD_COND_INITIALIZER,
+#endif
+    .head = 0
+};
+
+/*===== Internal helpers =====*/
+/*Taking the writer lock (no-op without threads)*/
+static void writer_lock() {
+#ifndef _WIN32
+    pthread_mutex_lock(&writer.lock);
+#endif
+}
+
+/*Releasing the writer lock*/
+static void writer_unlock() {
+#ifndef _WIN32
+    pthread_mutex_unlock(&writer.lock);
+#endif
+}
+
+/*Auto-closing so buffered transactions reach disk on exit*/
+static void log_atexit() {
+    log_close();
+}
+
+/*Filling in the header every log file starts with*/
+static LogFileHeader log_header() {
+    LogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LOG_MAGIC;
+    header.version = LOG_VERSION;
+    header.record_size = (int)sizeof(Transaction);
+    return header;
+}
+
+/*Cutting the active segment down to a given size*/
+static bool truncate_active(long long size) {
+#ifdef _WIN32
+    fflush(writer.fptr);
+    return _chsize_s(_fileno(writer.fptr), size) == 0;
+#else
+    return ftruncate(writer.fd, (off_t)size) == 0;
+#endif
+}
+
+/*Cutting the active segment back to its last whole record (after a failed or partial write)*/
+static bool trim_active() {
+    return truncate_active(LOG_HEADER_BYTES + writer.active_records * (long long)sizeof(Transaction));
+}
+
+/*Opening the active segment for appending*/
+static bool open_active() {
+#ifdef _WIN32
+    writer.fptr = fopen(LOG_FILE, "ab");
+    if (!writer.fptr) {
+        return false;
+    }
+#else
+    writer.fd = open(LOG_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (writer.fd < 0) {
+        return false;
+    }
+#endif
+
+    /*Ageing the segment from its first record*/
+    struct stat st;
+    Transaction first;
+    writer.active_records = 0;
+    writer.active_started = 0;
+    long long size = stat(LOG_FILE, &st) == 0 ? (long long)st.st_size : 0;
+
+    /*A new file (or one whose header was torn by a crash) starts with the header*/
+    if (size < LOG_HEADER_BYTES) {
+        LogFileHeader header = log_header();
+        bool written = truncate_active(0);
+#ifdef _WIN32
+        written = written && fwrite(&header, sizeof(header), 1, writer.fptr) == 1 && fflush(writer.fptr) == 0;
+#else
+        written = written && write(writer.fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+#endif
+        return written;
+    }
+
+    /*A torn record left by a crash would misalign everything appended after it*/
+    writer.active_records = (size - LOG_HEADER_BYTES) / (long long)sizeof(Transaction);
+    if (size != LOG_HEADER_BYTES + writer.active_records * (long long)sizeof(Transaction)) {
+        trim_active();
+    }
+    FILE* fptr = writer.active_records > 0 ? fopen(LOG_FILE, "rb") : NULL;
+    if (fptr) {
+        if (log_seek(fptr, LOG_HEADER_BYTES, SEEK_SET) == 0 &&
+            fread(&first, sizeof(Transaction), 1, fptr) == 1) {
+            writer.active_started = first.timestamp;
+        }
+        fclose(fptr);
+    }
+    return true;
+}
+
+/*Closing the active segment*/
+static void close_active() {
+#ifdef _WIN32
+    fclose(writer.fptr);
+    writer.fptr = NULL;
+#else
+    close(writer.fd);
+    writer.fd = -1;
+#endif
+    if (writer.reader) {
+        fclose(writer.reader);
+        writer.reader = NULL;
+    }
+}
+
+#ifndef _WIN32
+/*Compressing transactions.sealing without the lock, then listing the segment under it*/
+static void* log_sealer(void* arg) {
+    (void)arg;
+    LogSegmentInfo info;
+    bool ok = log_seal_prepare(LOG_SEALING_FILE, writer.seal_first_seq, &info);
+    writer_lock();
+    ok = ok && log_seal_install(LOG_SEALING_FILE, &info);
+    writer.sealing = false;
+    writer_unlock();
+    if (!ok) {
+        printf("Transaction log error: could not seal segment\n"); // Retried by the next rotation
+    }
+    return NULL;
+}
+
+/*Waiting for the last seal to finish (lock not held: the sealer takes it to finish)*/
+static void wait_sealer() {
+    writer_lock();
+    bool joinable = writer.sealer_joinable;
+    writer.sealer_joinable = false;
+    writer_unlock();
+    if (joinable) {
+        pthread_join(writer.sealer, NULL);
+    }
+}
+#endif
+
+/*Sealing the active segment once it is too big or too old*/
+static void log_rotate() {
+    bool too_big = writer.active_records * (long long)sizeof(Transaction) >= writer.config.segment_bytes;
+    bool too_old = writer.config.segment_seconds > 0 && writer.active_started != 0 &&
+        difftime(time(NULL), writer.active_started) >= writer.config.segment_seconds;
+    if (!too_big && !too_old) {
+        return;
+    }
+
+#ifndef _WIN32
+    /*One seal at a time: the active segment grows until the running one is listed*/
+    if (writer.sealing) {
+        return;
+    }
+    if (writer.sealer_joinable) {
+        pthread_join(writer.sealer, NULL); // Already past its last use of the lock
+        writer.sealer_joinable = false;
+    }
+#endif
+
+    /*A previous seal that failed must be finished first (its records come earlier)*/
+    if (!log_finish_seal()) {
+        return;
+    }
+
+    /*Only the rename happens here; the segment is compressed after the lock is released*/
+    close_active();
+    bool renamed = rename(LOG_FILE, LOG_SEALING_FILE) == 0;
+    if (!open_active()) {
+        writer.is_open = false;
+    }
+    if (!renamed) {
+        return;
+    }
+#ifndef _WIN32
+    writer.seal_first_seq = log_sealed_records();
+    writer.sealing = true;
+    writer.sealer_joinable = pthread_create(&writer.sealer, NULL, log_sealer, NULL) == 0;
+    if (writer.sealer_joinable) {
+        return;
+    }
+    writer.sealing = false;
+#endif
+    if (!log_seal_file(LOG_SEALING_FILE)) {
+        printf("Transaction log error: could not seal segment\n");
+    }
+}
+
+/*Writing every pending transaction with one system call (lock held, released while writing)*/
+static bool log_write_group() {
+    /*One group write at a time; a running one may already cover our records*/
+    while (writer.flushing) {
+#ifndef _WIN32
+        pthread_cond_wait(&writer.flushed, &writer.lock);
+#endif
+    }
+    if (writer.pending == 0) {
+        return true;
+    }
+
+    /*The pending run may wrap around the end of the ring; records queued meanwhile go after it*/
+    int head = writer.head;
+    int count = writer.pending;
+    int first = LOG_RING_CAPACITY - head;
+    if (first > count) {
+        first = count;
+    }
+    int second = count - first;
+    long long first_seq = log_sealed_records() + log_file_records(LOG_SEALING_FILE) + writer.active_records;
+    bool success;
+    writer.flushing = true;
+    writer_unlock();
+
+#ifdef _WIN32
+    success = (fwrite(&writer.ring[head], sizeof(Transaction), first, writer.fptr) == (size_t)first);
+    if (success && second > 0) {
+        success = (fwrite(writer.ring, sizeof(Transaction), second, writer.fptr) == (size_t)second);
+    }
+    success = success && fflush(writer.fptr) == 0;
+#else
+    struct iovec iov[2] = {
+        { &writer.ring[head], first * sizeof(Transaction) },
+        { writer.ring, second * sizeof(Transaction) }
+    };
+    size_t expected = (size_t)count * sizeof(Transaction);
+    success = (writev(writer.fd, iov, second > 0 ? 2 : 1) == (ssize_t)expected);
+    if (success && writer.config.sync_on_flush) {
+        success = (fdatasync(writer.fd) == 0);
+    }
+#endif
+
+    writer_lock();
+    writer.flushing = false;
+#ifndef _WIN32
+    pthread_cond_broadcast(&writer.flushed);
+#endif
+    if (!success) {
+        /*Partial bytes must not stay behind: the group is written again whole*/
+        if (!trim_active()) {
+            printf("Transaction log error: could not trim %s\n", LOG_FILE);
+        }
+        printf("Transaction log error\n");
+        return false;
+    }
+    log_index_append(first_seq, &writer.ring[head], first);
+    log_index_append(first_seq + first, writer.ring, second);
+    if (writer.active_started == 0) {
+        writer.active_started = writer.ring[head].timestamp;
+    }
+    writer.active_records += count;
+    writer.head = (head + count) % LOG_RING_CAPACITY;
+    writer.pending -= count;
+
+    log_rotate();
+    return true;
+}
+
+#ifndef _WIN32
+/*Writing out pending records once the oldest is flush_seconds old, even if nothing else is logged*/
+static void* log_flusher(void* arg) {
+    (void)arg;
+    writer_lock();
+    while (!writer.stopping) {
+        /*Nothing to age, or an open group that log_end_group() writes out itself*/
+        if (!writer.is_open || writer.pending == 0 || writer.group_depth > 0) {
+            pthread_cond_wait(&writer.queued, &writer.lock);
+            continue;
+        }
+        if (writer.flushing) {
+            pthread_cond_wait(&writer.flushed, &writer.lock);
+            continue;
+        }
+        time_t due = writer.oldest + writer.config.flush_seconds;
+        if (time(NULL) < due) {
+            struct timespec until = { .tv_sec = due, .tv_nsec = 0 };
+            pthread_cond_timedwait(&writer.queued, &writer.lock, &until);
+            continue;
+        }
+        if (!log_write_group()) {
+            /*Retrying a failed write once a second, not in a tight loop*/
+            struct timespec until = { .tv_sec = time(NULL) + 1, .tv_nsec = 0 };
+            pthread_cond_timedwait(&writer.queued, &writer.lock, &until);
+        }
+    }
+    writer_unlock();
+    return NULL;
+}
+
+/*Stopping the flusher (lock not held: it takes the lock to finish)*/
+static void stop_flusher() {
+    writer_lock();
+    bool running = writer.flusher_running;
+    writer.stopping = true;
+    writer.flusher_running = false;
+    pthread_cond_broadcast(&writer.queued);
+    pthread_cond_broadcast(&writer.flushed);
+    writer_unlock();
+    if (running) {
+        pthread_join(writer.flusher, NULL);
+    }
+}
+#endif
+
+/*===== Log writer lifecycle =====*/
+/*Opening transactions.log for appending (lock held)*/
+static bool open_locked() {
+    if (writer.is_open) {
+        return true;
+    }
+    if (!writer.config_loaded) {
+        writer.config = load_log_writer_config();
+        writer.config_loaded = true;
+    }
+
+    /*Sealed segments come first in record order (finishes any interrupted seal)*/
+    log_segments_load();
+    if (!open_active()) {
+        return false;
+    }
+
+    static bool atexit_registered = false;
+    if (!atexit_registered) {
+        atexit(log_atexit);
+        atexit_registered = true;
+    }
+    writer.is_open = true;
+
+#ifndef _WIN32
+    /*Without it a lone record would wait for the next one to be flushed*/
+    if (!writer.flusher_running) {
+        writer.stopping = false;
+        writer.flusher_running = pthread_create(&writer.flusher, NULL, log_flusher, NULL) == 0;
+    }
+#endif
+    return true;
+}
+
+/*Opening transactions.log for appending (kept open)*/
+bool log_open() {
+    writer_lock();
+    bool ok = open_locked();
+    writer_unlock();
+    return ok;
+}
+
+/*Flushing pending transactions and closing the log*/
+void log_close() {
+#ifndef _WIN32
+    stop_flusher();
+#endif
+    writer_lock();
+    if (writer.is_open) {
+        log_write_group();
+        close_active();
+        writer.is_open = false;
+    }
+#ifndef _WIN32
+    /*The last rotation may still be compressing*/
+    writer_unlock();
+    wait_sealer();
+    writer_lock();
+#endif
+
+    /*The index may be open for queries even if nothing was written*/
+    log_index_close();
+    if (writer.reader) {
+        fclose(writer.reader);
+        writer.reader = NULL;
+    }
+    log_segments_close();
+    writer_unlock();
+}
+
+/*Reading group commit settings from storage.cfg*/
+LogWriterConfig load_log_writer_config() {
+    LogWriterConfig config = {
+        .flush_records = DEFAULT_LOG_FLUSH_RECORDS,
+        .flush_seconds = DEFAULT_LOG_FLUSH_SECONDS,
+        .sync_on_flush = false,
+        .segment_bytes = DEFAULT_LOG_SEGMENT_KB * 1024L,
+        .segment_seconds = DEFAULT_LOG_SEGMENT_SECONDS
+    };
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+
+    if (fptr) {
+        char line[256];
+        int sync = 0;
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "log_flush_records=%d", &config.flush_records) == 1) {
+                continue;
+            }
+            if (sscanf(line, "log_flush_seconds=%d", &config.flush_seconds) == 1) {
+                continue;
+            }
+            if (sscanf(line, "log_sync=%d", &sync) == 1) {
+                config.sync_on_flush = (sync != 0);
+                continue;
+            }
+            if (sscanf(line, "log_segment_kb=%ld", &config.segment_bytes) == 1) {
+                config.segment_bytes *= 1024L;
+                continue;
+            }
+            if (sscanf(line, "log_segment_seconds=%d", &config.segment_seconds) == 1) {
+                continue;
+            }
+        }
+        fclose(fptr);
+    }
+
+    /*Keeping the size threshold inside the ring*/
+    if (config.flush_records <= 0 || config.flush_records > LOG_RING_CAPACITY) {
+        config.flush_records = DEFAULT_LOG_FLUSH_RECORDS;
+    }
+    if (config.flush_seconds < 0) {
+        config.flush_seconds = DEFAULT_LOG_FLUSH_SECONDS;
+    }
+    if (config.segment_bytes <= 0) {
+        config.segment_bytes = DEFAULT_LOG_SEGMENT_KB * 1024L;
+    }
+    return config;
+}
+
+/*Overriding group commit settings at runtime*/
+void log_set_config(LogWriterConfig config) {
+    if (config.flush_records <= 0 || config.flush_records > LOG_RING_CAPACITY) {
+        config.flush_records = DEFAULT_LOG_FLUSH_RECORDS;
+    }
+    writer_lock();
+    writer.config = config;
+    writer.config_loaded = true;
+#ifndef _WIN32
+    pthread_cond_broadcast(&writer.queued); // The flusher's deadline may have moved
+#endif
+    writer_unlock();
+}
+
+/*===== Group commit =====*/
+/*Writing out everything queued so far*/
+bool log_commit() {
+    writer_lock();
+    bool ok = writer.is_open ? log_write_group() : writer.pending == 0;
+    writer_unlock();
+    return ok;
+}
+
+/*Getting the number of transactions not yet written*/
+int log_pending() {
+    writer_lock();
+    int pending = writer.pending;
+    writer_unlock();
+    return pending;
+}
+
+/*Holding threshold flushes until the matching log_end_group()*/
+void log_begin_group() {
+    writer_lock();
+    writer.group_depth++;
+    writer_unlock();
+}
+
+/*Writing the whole group with one system call*/
+bool log_end_group() {
+    writer_lock();
+    if (writer.group_depth > 0) {
+        writer.group_depth--;
+    }
+    bool open_group = writer.group_depth > 0;
+#ifndef _WIN32
+    if (!open_group) {
+        pthread_cond_signal(&writer.queued); // Records left behind by a failed commit age again
+    }
+#endif
+    writer_unlock();
+    return open_group ? true : log_commit();
+}
+
+/*===== File format =====*/
+/*Converting a version 1 record (it has no after-image, so replay skips it)*/
+void log_upgrade_record(const LegacyTransaction* old, Transaction* out) {
+    memset(out, 0, sizeof(Transaction));
+    out->timestamp = old->timestamp;
+    out->type = old->type;
+    out->product_id = old->product_id;
+    memcpy(out->user, old->user, sizeof(out->user));
+    out->quantity_change = old->quantity_change;
+    out->price_change = old->price_change;
+    memcpy(out->description, old->description, sizeof(out->description));
+}
+
+/*Telling the record size of a log written without a header (version 1 or early version 2)*/
+static size_t headerless_record_size(FILE* fptr, long long size) {
+    bool fits_legacy = size % (long long)sizeof(LegacyTransaction) == 0;
+    bool fits_current = size % (long long)sizeof(Transaction) == 0;
+    if (fits_legacy != fits_current) {
+        return fits_legacy ? sizeof(LegacyTransaction) : sizeof(Transaction);
+    }
+
+    /*Both (or neither) fit: version 1 records read at their own stride have sane types and times*/
+    LegacyTransaction probe[4];
+    size_t n = fread(probe, sizeof(LegacyTransaction), 4, fptr);
+    for (size_t i = 0; i < n; i++) {
+        if (probe[i].type < ADD || probe[i].type > SALE ||
+            probe[i].timestamp < probe[0].timestamp ||
+            probe[i].timestamp - probe[0].timestamp > 10L * 365 * 86400) {
+            return sizeof(Transaction);
+        }
+    }
+    return sizeof(LegacyTransaction);
+}
+
+/*Rewriting a log file that has no header (older versions) in the current format, once*/
+bool log_file_upgrade(const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        return true; // Nothing to upgrade
+    }
+    LogFileHeader header;
+    struct stat st;
+    bool current = fread(&header, sizeof(header), 1, in) == 1 && header.magic == LOG_MAGIC;
+    if (current || stat(path, &st) != 0 || st.st_size == 0) {
+        fclose(in);
+        if (current && (header.version != LOG_VERSION || header.record_size != (int)sizeof(Transaction))) {
+            printf("Transaction log error: %s has unsupported version %d\n", path, header.version);
+            return false;
+        }
+        return true;
+    }
+
+    rewind(in);
+    size_t record_size = headerless_record_size(in, (long long)st.st_size);
+    long long records = (long long)st.st_size / (long long)record_size;
+    rewind(in);
+
+    char temp[300];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* out = fopen(temp, "wb");
+    unsigned char* raw = malloc(LOG_UPGRADE_CHUNK * record_size);
+    Transaction* converted = malloc(LOG_UPGRADE_CHUNK * sizeof(Transaction));
+    header = log_header();
+    bool ok = out && raw && converted && fwrite(&header, sizeof(header), 1, out) == 1;
+
+    /*A torn last record is dropped, the rest are copied a chunk at a time*/
+    for (long long done = 0; ok && done < records; ) {
+        int n = records - done < LOG_UPGRADE_CHUNK ? (int)(records - done) : LOG_UPGRADE_CHUNK;
+        ok = fread(raw, record_size, n, in) == (size_t)n;
+        for (int i = 0; ok && i < n; i++) {
+            if (record_size == sizeof(LegacyTransaction)) {
+                log_upgrade_record((const LegacyTransaction*)raw + i, &converted[i]);
+            }
+            else {
+                memcpy(&converted[i], raw + (size_t)i * record_size, sizeof(Transaction));
+            }
+        }
+        ok = ok && fwrite(converted, sizeof(Transaction), n, out) == (size_t)n;
+        done += n;
+    }
+    fclose(in);
+    free(raw);
+    free(converted);
+    if (out) {
+        ok = fflush(out) == 0 && ok;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(out)) == 0;
+#endif
+        ok = fclose(out) == 0 && ok;
+    }
+
+#ifdef _WIN32
+    ok = ok && remove(path) == 0; // rename() does not overwrite on Windows
+#endif
+    if (!ok || rename(temp, path) != 0) {
+        remove(temp);
+        printf("Transaction log error: could not upgrade %s\n", path);
+        return false;
+    }
+    printf("Upgraded %s to log version %d (%lld records)\n", path, LOG_VERSION, records);
+    return true;
+}
+
+/*Counting the whole records of an unsealed log file (0 if missing)*/
+long long log_file_records(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0 || (long long)st.st_size < LOG_HEADER_BYTES) {
+        return 0;
+    }
+    return ((long long)st.st_size - LOG_HEADER_BYTES) / (long long)sizeof(Transaction);
+}
+
+/*===== Reading =====*/
+
+/*Getting the number of complete records in the sealed segments, a pending seal and transactions.log*/
+long long log_record_count() {
+    /*A seal moves records between the files, so it must not run while they are counted*/
+    writer_lock();
+    long long sealed = log_sealed_records();
+    long long count = sealed + log_file_records(LOG_SEALING_FILE) + log_file_records(LOG_FILE);
+    writer_unlock();
+    return count;
+}
+
+/*Reading up to count records starting at record number seq, with the writer lock held*/
+static int read_locked(long long seq, Transaction* buffer, int count) {
+    long long sealed = log_sealed_records();
+    int done = 0;
+
+    /*Records in sealed segments are decoded a block at a time*/
+    while (done < count && seq + done < sealed) {
+        int n = log_segment_read(seq + done, buffer + done, count - done);
+        if (n <= 0) {
+            return done;
+        }
+        done += n;
+    }
+    if (done == count) {
+        return done;
+    }
+
+    /*A segment whose seal has not succeeded yet sits between the sealed ones and the active log*/
+    long long sealing = log_file_records(LOG_SEALING_FILE);
+    if (seq + done < sealed + sealing) {
+        FILE* fptr = fopen(LOG_SEALING_FILE, "rb");
+        if (!fptr) {
+            return done;
+        }
+        long long want = sealed + sealing - (seq + done);
+        int n = want < count - done ? (int)want : count - done;
+        long long offset = LOG_HEADER_BYTES + (seq + done - sealed) * (long long)sizeof(Transaction);
+        bool ok = log_seek(fptr, offset, SEEK_SET) == 0;
+        int got = ok ? (int)fread(buffer + done, sizeof(Transaction), n, fptr) : 0;
+        fclose(fptr);
+        done += got;
+        if (got < n || done == count) {
+            return done;
+        }
+    }
+    sealed += sealing;
+
+    if (!writer.reader) {
+        writer.reader = fopen(LOG_FILE, "rb");
+        if (!writer.reader) {
+            return done;
+        }
+    }
+    long long active_seq = seq + done - sealed;
+    if (log_seek(writer.reader, LOG_HEADER_BYTES + active_seq * (long long)sizeof(Transaction), SEEK_SET) != 0) {
+        return done;
+    }
+    return done + (int)fread(buffer + done, sizeof(Transaction), count - done, writer.reader);
+}
+
+/*Reading up to count records starting at record number seq (returns count read)*/
+int log_read(long long seq, Transaction* buffer, int count) {
+    writer_lock();
+    int got = read_locked(seq, buffer, count);
+    writer_unlock();
+    return got;
+}
+
+/*=== Logging ===*/
+/*Code for logging transactions*/
+void log_transaction(Transaction t) {
+    writer_lock();
+    if (!open_locked()) {
+        writer_unlock();
+        printf("Transaction log error\n");
+        return;
+    }
+
+    /*Making room if the ring is full (a slot still pending must not be overwritten)*/
+    while (writer.pending == LOG_RING_CAPACITY) {
+        if (!log_write_group()) {
+            writer_unlock();
+            printf("Transaction log error: log full, transaction not recorded\n");
+            return;
+        }
+    }
+
+    if (writer.pending == 0) {
+        writer.oldest = time(NULL);
+#ifndef _WIN32
+        pthread_cond_signal(&writer.queued); // The flusher starts ageing this record
+#endif
+    }
+    writer.ring[(writer.head + writer.pending) % LOG_RING_CAPACITY] = t;
+    writer.pending++;
+
+    /*Flushing on the size or time threshold (unless a group is open or another thread is writing one)*/
+    if (writer.group_depth == 0 && !writer.flushing &&
+        (writer.pending >= writer.config.flush_records ||
+        difftime(time(NULL), writer.oldest) >= writer.config.flush_seconds)) {
+        log_write_group();
+    }
+    writer_unlock();
+}
+
+/*Printing the column headings of a transaction listing*/
+static void print_log_header(const char* title) {
+    printf("\n=== %s ===\n", title);
+    printf("%-19s | %-8s | %-6s | %-5s | %s\n",
+        "Timestamp", "Type", "Qty", "ID", "Description");
+}
+
+/*Printing one transaction as a table row*/
+static void print_transaction(const Transaction* t) {
+    char time_buf[20];
+    strftime(time_buf, 20, "%Y-%m-%d: %H:%M%S", localtime(&t->timestamp));
+
+    printf("%-19s | %-8s | %+6d | %-5d | %s\n",
+        time_buf,
+        (const char* []) {
+        "ADD", "UPDATE", "DELETE", "RESTOCK", "SALE"
+    }[t->type],
+            t->quantity_change,
+            t->product_id,
+            t->description);
+}
+
+/*Displaying transactions*/
+void display_transaction_log() {
+    /*Making buffered transactions visible to the reader*/
+    log_commit();
+
+    long long total = log_record_count();
+    if (total == 0) {
+        printf("\nNo transactions recorded\n");
+        return;
+    }
+
+    Transaction buffer[LOG_SEGMENT_BLOCK];
+
+    // Displaying transaction log (sealed segments are decoded transparently)
+    print_log_header("Transaction Log");
+    for (long long seq = 0; seq < total; ) {
+        int n = log_read(seq, buffer, LOG_SEGMENT_BLOCK);
+        if (n <= 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            print_transaction(&buffer[i]);
+        }
+        seq += n;
+    }
+}
+
+/*Displaying one product's history using the log index*/
+void display_product_history(int product_id) {
+    Transaction* results = NULL;
+    long count = log_query_product(product_id, &results);
+    if (count < 0) {
+        printf("\nTransaction log index unavailable\n");
+        return;
+    }
+    if (count == 0) {
+        printf("\nNo transactions recorded for product %d\n", product_id);
+        return;
+    }
+
+    char title[64];
+    snprintf(title, sizeof(title), "History of Product %d", product_id);
+    print_log_header(title);
+    for (long i = 0; i < count; i++) {
+        print_transaction(&results[i]);
+    }
+    free(results);
+}
+
+/*Displaying the transactions inside a time window using the log index*/
+void display_transactions_between(time_t from, time_t to) {
+    Transaction* results = NULL;
+    long count = log_query_range(from, to, &results);
+    if (count < 0) {
+        printf("\nTransaction log index unavailable\n");
+        return;
+    }
+    if (count == 0) {
+        printf("\nNo transactions in that period\n");
+        return;
+    }
+
+    print_log_header("Transactions in Period");
+    for (long i = 0; i < count; i++) {
+        print_transaction(&results[i]);
+    }
+    free(results);
+}
@@ -1,6 +1,9 @@
 #include "include/inventory.h"
 #include "include/backup-restore.h"
+#include "include/backup-delta.h"
+#include "include/log-replay.h"
 #include "include/ui.h"
+#include "include/workload-trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -26,7 +29,12 @@ void display_menu() {
     printf("10. Create backup\n");
     printf("11. Restore backup\n");
     printf("12. Configure backup rotation\n");
-    printf("13. Exit\n");
+    printf("13. View Category\n");
+    printf("14. Search Product by Name\n");
+    printf("15. View Product History\n");
+    printf("16. View Transactions by Date\n");
+    printf("17. Recover to Point in Time\n");
+    printf("18. Exit\n");
 }
 
 /*Backup rotation submenu*/
@@ -90,6 +98,9 @@ void handle_rotation_settings() {
 
 /*Handling menu function*/
 void handle_menu_choice(int choice) {
+    /*Marking the menu action in a workload trace*/
+    trace_end(TRACE_MENU, trace_begin(), choice, 0, NULL, 1);
+
     switch (choice) {
         // Adding a product 
     case 1: {
@@ -207,24 +218,10 @@ void handle_menu_choice(int choice) {
         list_backups();
         int backup_num = get_int_input("Enter backup number to restore");
 
-        // Getting selected backup path
-        DIR* dir = opendir(BACKUP_DIR);
-        struct dirent* ent;
-        int count = 0;
-        char selected_path[295] = { 0 };
-
-        while ((ent = readdir(dir)) != NULL) {
-            if (strstr(ent->d_name, ".bak")) {
-                if (count++ == backup_num) {
-                    snprintf(selected_path, sizeof(selected_path),
-                        "%s / %s", BACKUP_DIR, ent->d_name);
-                    break;
-                }
-            }
-        }
-        closedir(dir);
+        // Getting selected backup path from the catalog
+        const BackupEntry* selected = get_backup_entry(backup_num);
 
-        if (selected_path[0] && restore_backup(selected_path)) {
+        if (selected && restore_backup(selected->path)) {
             printf("\n Restoration successful!\n");
         }
         else {
@@ -239,8 +236,57 @@ void handle_menu_choice(int choice) {
         break;
     }
 
-           // Exiting system
+           // Viewing one category
     case 13: {
+        char category[MAX_CATEGORY_LEN];
+        printf("Enter category: ");
+        fgets(category, MAX_CATEGORY_LEN, stdin);
+        category[strcspn(category, "\n")] = '\0';
+        list_products_by_category(category);
+        break;
+    }
+
+           // Searching products by name
+    case 14: {
+        char query[MAX_NAME_LEN];
+        printf("Enter part of the product name: ");
+        fgets(query, MAX_NAME_LEN, stdin);
+        query[strcspn(query, "\n")] = '\0';
+        display_name_search(query);
+        break;
+    }
+
+           // Viewing one product's transactions
+    case 15: {
+        int id = get_int_input("Enter product ID");
+        display_product_history(id);
+        break;
+    }
+
+           // Viewing transactions in a date range
+    case 16: {
+        time_t from = get_date_input("Enter start date (YYYY-MM-DD)", false);
+        time_t to = get_date_input("Enter end date (YYYY-MM-DD)", true);
+        display_transactions_between(from, to);
+        break;
+    }
+
+           // Restoring a backup and replaying the log up to a moment
+    case 17: {
+        time_t target = get_date_input("Enter target time (YYYY-MM-DD HH:MM:SS)", true);
+        ReplayStats stats;
+        if (recover_to_time(target, &stats)) {
+            report_replay(&stats);
+            printf("\n Recovery successful!\n");
+        }
+        else {
+            printf("\n Recovery failed!\n");
+        }
+        break;
+    }
+
+           // Exiting system
+    case 18: {
         printf("Closing Inventory System.....Goodbye!\n");
         exit(EXIT_SUCCESS);
         system("PAUSE");
@@ -269,3 +315,33 @@ int get_int_input(const char* prompt) {
     }
 }
 
+/*Utility function for date input (start or end of the given day)*/
+time_t get_date_input(const char* prompt, bool end_of_day) {
+    char buffer[100];
+    struct tm date;
+
+    while (1) {
+        printf("\n%s: ", prompt);
+        fgets(buffer, sizeof(buffer), stdin);
+
+        memset(&date, 0, sizeof(date));
+        int fields = sscanf(buffer, "%d-%d-%d %d:%d:%d", &date.tm_year, &date.tm_mon, &date.tm_mday,
+            &date.tm_hour, &date.tm_min, &date.tm_sec);
+        if (fields >= 3) {
+            date.tm_year -= 1900;
+            date.tm_mon -= 1;
+            date.tm_isdst = -1;
+            /*A time of day, if given, overrides the end-of-day default*/
+            if (fields < 5 && end_of_day) {
+                date.tm_hour = 23;
+                date.tm_min = 59;
+                date.tm_sec = 59;
+            }
+            time_t value = mktime(&date);
+            if (value != (time_t)-1) {
+                return value;
+            }
+        }
+        printf("Invalid date! Please use YYYY-MM-DD.\n");
+    }
+}
@@ -0,0 +1,483 @@
+#include "include/workload-trace.h"
+#include "include/backup-online.h"
+#include "include/backup-restore.h"
+#include "include/inventory.h"
+#include "include/storage-engine.h"
+#include "include/transaction-log.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define trace_dup _dup
+#define trace_dup2 _dup2
+#define trace_close _close
+#define TRACE_NULL_DEVICE "NUL"
+#else
+#include <pthread.h>
+#include <unistd.h>
+#define trace_dup dup
+#define trace_dup2 dup2
+#define trace_close close
+#define TRACE_NULL_DEVICE "/dev/null"
+#endif
+
+/*Recorder state (calls from engine workers are serialized by the lock)*/
+typedef struct {
+    bool active;
+    FILE* out;
+    char* buffer;
+    size_t used;
+    long long started_ns;
+#ifndef _WIN32
+    pthread_mutex_t lock;
+#endif
+} TraceRecorder;
+
+static TraceRecorder recorder = {
+    .active = false,
+#ifndef _WIN32
+    .lock = PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/*===== Internal helpers =====*/
+/*Reading the wall clock in nanoseconds*/
+static long long trace_wall_ns() {
+#ifdef _WIN32
+    return (long long)time(NULL) * 1000000000LL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+/*Serializing recorder access*/
+static void recorder_lock() {
+#ifndef _WIN32
+    pthread_mutex_lock(&recorder.lock);
+#endif
+}
+
+static void recorder_unlock() {
+#ifndef _WIN32
+    pthread_mutex_unlock(&recorder.lock);
+#endif
+}
+
+/*Writing out buffered records (lock held)*/
+static void flush_locked() {
+    if (recorder.used > 0 && recorder.out) {
+        fwrite(recorder.buffer, 1, recorder.used, recorder.out);
+        fflush(recorder.out);
+    }
+    recorder.used = 0;
+}
+
+/*Buffering one record and its optional product (lock held)*/
+static void append_locked(const TraceRecord* r, const Product* p) {
+    size_t need = sizeof(TraceRecord) + (p ? sizeof(Product) : 0);
+    if (recorder.used + need > TRACE_BUFFER_SIZE) {
+        flush_locked();
+    }
+    memcpy(recorder.buffer + recorder.used, r, sizeof(TraceRecord));
+    recorder.used += sizeof(TraceRecord);
+    if (p) {
+        memcpy(recorder.buffer + recorder.used, p, sizeof(Product));
+        recorder.used += sizeof(Product);
+    }
+}
+
+/*Filling in the common part of a record*/
+static void fill_record(TraceRecord* r, TraceOp op, long long started, int id, int quantity, int outcome) {
+    long long latency = latency_clock_ns() - started;
+    memset(r, 0, sizeof(TraceRecord));
+    r->offset_ns = trace_wall_ns() - latency - recorder.started_ns;
+    r->latency_ns = latency > (long long)UINT_MAX ? UINT_MAX : (unsigned int)(latency < 0 ? 0 : latency);
+    r->op = (unsigned char)op;
+    r->outcome = (unsigned char)outcome;
+    r->id = id;
+    r->quantity = quantity;
+}
+
+/*Sending stdout to the null device while replayed calls print (fd is restored after)*/
+static int silence_stdout() {
+    fflush(stdout);
+    int null_fd = open(TRACE_NULL_DEVICE, O_WRONLY);
+    if (null_fd < 0) {
+        return -1;
+    }
+    int saved = trace_dup(1);
+    trace_dup2(null_fd, 1);
+    trace_close(null_fd);
+    return saved;
+}
+
+static void restore_stdout(int saved) {
+    if (saved >= 0) {
+        fflush(stdout);
+        trace_dup2(saved, 1);
+        trace_close(saved);
+    }
+}
+
+/*Waiting until a moment of the monotonic clock*/
+static void wait_until(long long target_ns) {
+    long long now = latency_clock_ns();
+#ifdef _WIN32
+    while (now < target_ns) {
+        now = latency_clock_ns();
+    }
+#else
+    if (target_ns > now) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)((target_ns - now) / 1000000000LL);
+        ts.tv_nsec = (long)((target_ns - now) % 1000000000LL);
+        nanosleep(&ts, NULL);
+    }
+#endif
+}
+
+/*===== Recording =====*/
+/*Starting to record every traced call into path (appending to an existing trace)*/
+bool trace_start(const char* path) {
+    recorder_lock();
+    if (recorder.active) {
+        recorder_unlock();
+        return true;
+    }
+
+    /*An existing trace keeps its origin, so appended sessions stay in time order*/
+    TraceHeader header = { 0 };
+    FILE* existing = fopen(path, "rb");
+    bool resume = false;
+    if (existing) {
+        size_t got = fread(&header, sizeof(header), 1, existing);
+        fclose(existing);
+        if (got == 1) {
+            if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+                printf("%s is not a workload trace, not recording\n", path);
+                recorder_unlock();
+                return false;
+            }
+            resume = true;
+        }
+    }
+
+    recorder.buffer = malloc(TRACE_BUFFER_SIZE);
+    recorder.out = fopen(path, resume ? "ab" : "wb");
+    if (!recorder.buffer || !recorder.out) {
+        free(recorder.buffer);
+        if (recorder.out) {
+            fclose(recorder.out);
+        }
+        recorder.buffer = NULL;
+        recorder.out = NULL;
+        recorder_unlock();
+        return false;
+    }
+    if (!resume) {
+        header.magic = TRACE_MAGIC;
+        header.version = TRACE_VERSION;
+        header.started_ns = trace_wall_ns();
+        fwrite(&header, sizeof(header), 1, recorder.out);
+    }
+    recorder.started_ns = header.started_ns;
+    recorder.used = 0;
+    recorder.active = true;
+    recorder_unlock();
+    return true;
+}
+
+/*Writing out what is buffered and closing the trace*/
+void trace_stop() {
+    recorder_lock();
+    if (recorder.active) {
+        flush_locked();
+        fclose(recorder.out);
+        free(recorder.buffer);
+        recorder.out = NULL;
+        recorder.buffer = NULL;
+        recorder.active = false;
+    }
+    recorder_unlock();
+}
+
+/*Checking whether calls are being recorded*/
+bool trace_recording() {
+    return recorder.active;
+}
+
+/*Writing out buffered records (at the end of each menu action)*/
+void trace_flush() {
+    if (!recorder.active) {
+        return;
+    }
+    recorder_lock();
+    if (recorder.active) {
+        flush_locked();
+    }
+    recorder_unlock();
+}
+
+/*Marking the start of a traced call (0 when not recording)*/
+long long trace_begin() {
+    if (!recorder.active) {
+        return 0;
+    }
+    long long now = latency_clock_ns();
+    return now > 0 ? now : 1;
+}
+
+/*Recording a finished call begun with trace_begin() (p: its product argument, if any)*/
+void trace_end(TraceOp op, long long started, int id, int quantity, const Product* p, int outcome) {
+    if (started == 0) {
+        return;
+    }
+    recorder_lock();
+    if (recorder.active) {
+        TraceRecord r;
+        fill_record(&r, op, started, id, quantity, outcome);
+        r.flags = p ? TRACE_FLAG_PRODUCT : 0;
+        append_locked(&r, p);
+    }
+    recorder_unlock();
+}
+
+/*Recording one apply_stock_movements() call: a record per movement, grouped*/
+void trace_end_group(long long started, const StockMovement* movements, int count) {
+    if (started == 0 || count <= 0) {
+        return;
+    }
+    recorder_lock();
+    if (recorder.active) {
+        for (int i = 0; i < count; i++) {
+            TraceRecord r;
+            TraceOp kind = movements[i].type == SALE ? TRACE_SALE : TRACE_RESTOCK;
+            fill_record(&r, kind, started, movements[i].id, movements[i].quantity, (int)movements[i].result);
+            r.flags = (i + 1 < count) ? TRACE_FLAG_GROUPED : 0;
+            append_locked(&r, NULL);
+        }
+    }
+    recorder_unlock();
+}
+
+/*Starting the recorder if storage.cfg names a trace file*/
+void load_trace_config() {
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+    if (!fptr) {
+        return;
+    }
+    char line[256];
+    char path[200] = "";
+    while (fgets(line, sizeof(line), fptr)) {
+        if (sscanf(line, "trace_file=%199s", path) == 1) {
+            continue;
+        }
+    }
+    fclose(fptr);
+
+    if (path[0]) {
+        trace_start(path);
+    }
+}
+
+/*===== Replay =====*/
+/*Setting replay options: as fast as possible, output silenced*/
+void trace_replay_options_init(TraceReplayOptions* options) {
+    options->paced = false;
+    options->speed = 1.0;
+    options->max_gap_ms = DEFAULT_TRACE_MAX_GAP_MS;
+    options->quiet = true;
+}
+
+/*Driving the calls of a trace against the store in the working directory*/
+bool trace_replay(const char* path, const TraceReplayOptions* options, TraceReplayStats* stats) {
+    memset(stats, 0, sizeof(TraceReplayStats));
+    FILE* fptr = fopen(path, "rb");
+    if (!fptr) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, fptr) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+        printf("%s is not a workload trace\n", path);
+        fclose(fptr);
+        return false;
+    }
+
+    /*Replayed calls must not land in the trace being recorded*/
+    recorder_lock();
+    bool was_recording = recorder.active;
+    recorder.active = false;
+    recorder_unlock();
+
+    StockMovement* group = NULL;
+    unsigned char* group_outcomes = NULL;
+    int group_count = 0;
+    int group_capacity = 0;
+    bool ok = true;
+
+    int saved_stdout = options->quiet ? silence_stdout() : -1;
+    double speed = options->speed > 0 ? options->speed : 1.0;
+    long long max_gap = options->max_gap_ms * 1000000LL;
+    long long start = latency_clock_ns();
+    long long previous_offset = -1;
+    long long schedule = 0; // Recorded time kept so far, idle gaps trimmed
+
+    TraceRecord r;
+    while (fread(&r, sizeof(r), 1, fptr) == 1) {
+        Product p;
+        memset(&p, 0, sizeof(p));
+        if ((r.flags & TRACE_FLAG_PRODUCT) && fread(&p, sizeof(p), 1, fptr) != 1) {
+            ok = false; // Torn tail
+            break;
+        }
+        if (r.op >= TRACE_OP_COUNT) {
+            ok = false;
+            break;
+        }
+        if (r.op == TRACE_MENU) {
+            stats->markers++;
+            continue;
+        }
+
+        /*Pacing on the first record of each call*/
+        if (options->paced && group_count == 0) {
+            if (previous_offset >= 0) {
+                long long gap = r.offset_ns - previous_offset;
+                schedule += gap < 0 ? 0 : (gap > max_gap ? max_gap : gap);
+            }
+            previous_offset = r.offset_ns;
+            wait_until(start + (long long)((double)schedule / speed));
+        }
+
+        /*Movements of one call are collected and applied together*/
+        if (r.op == TRACE_SALE || r.op == TRACE_RESTOCK) {
+            if (group_count == group_capacity) {
+                int capacity = group_capacity ? group_capacity * 2 : 16;
+                StockMovement* grown = realloc(group, capacity * sizeof(StockMovement));
+                if (grown) {
+                    group = grown;
+                }
+                unsigned char* grown_outcomes = realloc(group_outcomes, capacity);
+                if (grown_outcomes) {
+                    group_outcomes = grown_outcomes;
+                }
+                if (!grown || !grown_outcomes) {
+                    ok = false;
+                    break;
+                }
+                group_capacity = capacity;
+            }
+            StockMovement* m = &group[group_count];
+            memset(m, 0, sizeof(StockMovement));
+            m->id = r.id;
+            m->type = r.op == TRACE_SALE ? SALE : RESTOCK;
+            m->quantity = r.quantity;
+            group_outcomes[group_count] = r.outcome;
+            group_count++;
+            if (r.flags & TRACE_FLAG_GROUPED) {
+                continue;
+            }
+
+            long long t0 = latency_clock_ns();
+            apply_stock_movements(group, group_count);
+            latency_add(&stats->replayed[group[0].type == SALE ? TRACE_SALE : TRACE_RESTOCK],
+                latency_clock_ns() - t0);
+            latency_add(&stats->recorded[group[0].type == SALE ? TRACE_SALE : TRACE_RESTOCK], r.latency_ns);
+            for (int i = 0; i < group_count; i++) {
+                if ((int)group[i].result != group_outcomes[i]) {
+                    stats->mismatches++;
+                }
+            }
+            group_count = 0;
+            stats->calls++;
+            continue;
+        }
+
+        int outcome = 0;
+        long long t0 = latency_clock_ns();
+        switch ((TraceOp)r.op) {
+        case TRACE_ADD:
+            outcome = add_product(p);
+            break;
+        case TRACE_GET: {
+            Product* found = get_product(r.id);
+            outcome = (found != NULL);
+            free(found);
+            break;
+        }
+        case TRACE_UPDATE:
+            outcome = update_product(r.id, p);
+            break;
+        case TRACE_DELETE:
+            outcome = delete_product(r.id);
+            break;
+        case TRACE_REPORT:
+            generate_report();
+            outcome = 1;
+            break;
+        case TRACE_BACKUP:
+            outcome = create_backup();
+            online_backup_finish(true);
+            break;
+        default:
+            break;
+        }
+        latency_add(&stats->replayed[r.op], latency_clock_ns() - t0);
+        latency_add(&stats->recorded[r.op], r.latency_ns);
+        if (outcome != r.outcome) {
+            stats->mismatches++;
+        }
+        stats->calls++;
+        log_commit();
+    }
+
+    /*A group still open means the call's last movement never reached the trace (torn tail)*/
+    if (group_count > 0) {
+        ok = false;
+    }
+    log_commit();
+    stats->seconds = (double)(latency_clock_ns() - start) / 1e9;
+    restore_stdout(saved_stdout);
+
+    free(group);
+    free(group_outcomes);
+    fclose(fptr);
+    recorder_lock();
+    recorder.active = was_recording && recorder.out != NULL;
+    recorder_unlock();
+    return ok;
+}
+
+/*Printing replay throughput and latency by operation*/
+void report_trace_replay(const TraceReplayStats* stats) {
+    static const char* const names[TRACE_OP_COUNT] = {
+        "menu", "add", "get", "update", "delete", "sale", "restock", "report", "backup"
+    };
+
+    printf("Replayed %lld calls in %.3f s", stats->calls, stats->seconds);
+    if (stats->seconds > 0) {
+        printf(" - %.0f calls/s", (double)stats->calls / stats->seconds);
+    }
+    printf(" (%lld outcome mismatches, %lld menu markers)\n", stats->mismatches, stats->markers);
+
+    printf("%-10s %10s %12s %12s %12s %14s\n",
+        "Operation", "Calls", "p50 us", "p99 us", "max us", "recorded p50");
+    for (int op = 0; op < TRACE_OP_COUNT; op++) {
+        const LatencyHistogram* h = &stats->replayed[op];
+        if (h->count == 0) {
+            continue;
+        }
+        printf("%-10s %10lld %12.2f %12.2f %12.2f %14.2f\n", names[op], h->count,
+            latency_percentile(h, 50), latency_percentile(h, 99), (double)h->max_ns / 1000.0,
+            latency_percentile(&stats->recorded[op], 50));
+    }
+}
@@ -0,0 +1,453 @@
+#include "include/write-ahead-log.h"
+#include "include/storage-engine.h"
+#include "include/crc32c.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*Write-ahead log state (one open handle for the whole process)*/
+typedef struct {
+    bool is_open;
+#ifdef _WIN32
+    FILE* fptr;
+#else
+    int fd;
+#endif
+    WalConfig config;
+    bool config_loaded;
+    long long next_lsn;
+    long long batch; // Open batch (0 if none)
+    int batch_depth;
+    long batch_records; // Writes logged in the open batch
+    int pending; // Records written since the last fsync
+    long bytes; // Size of inventory.wal
+    long long written; // Ticket of the last finished write() (taken once the write returns)
+    long long synced; // Every write with a ticket up to this one is on stable storage
+#ifndef _WIN32
+    pthread_mutex_t sync_lock; // One fsync at a time; waiters find their ticket covered
+#endif
+} WriteAheadLog;
+
+static WriteAheadLog wal = {
+#ifndef _WIN32
+    .fd = -1,
+    .sync_lock = PTHREAD_MUTEX_INITIALIZER,
+#endif
+    .next_lsn = 1
+};
+
+/*Counters bumped by writers of different records at once (records are single write() calls)*/
+#ifdef _WIN32
+#define wal_add(counter, n) ((counter) += (n))
+#define wal_load(counter) (counter)
+#define wal_set(counter, v) ((counter) = (v))
+#else
+#define wal_add(counter, n) __atomic_add_fetch(&(counter), (n), __ATOMIC_RELAXED)
+#define wal_load(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#define wal_set(counter, v) __atomic_store_n(&(counter), (v), __ATOMIC_RELAXED)
+#endif
+
+/*===== Internal helpers =====*/
+/*Making every write up to ticket durable, sharing one fsync among concurrent callers*/
+static bool wal_sync_to(long long ticket) {
+#ifndef _WIN32
+    pthread_mutex_lock(&wal.sync_lock);
+#endif
+    bool ok = true;
+    if (wal.is_open && wal.synced < ticket) {
+        /*Writes finished before this point ride along with the caller's*/
+        long long target = wal_load(wal.written);
+        wal_set(wal.pending, 0);
+#ifdef _WIN32
+        ok = fflush(wal.fptr) == 0;
+#else
+        ok = fsync(wal.fd) == 0;
+#endif
+        if (ok) {
+            wal.synced = target;
+        }
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&wal.sync_lock);
+#endif
+    return ok;
+}
+
+/*Sealing records with their checksums and handing them to the OS in one write*/
+static bool emit_wal_records(WalRecord* records, long n) {
+    for (long i = 0; i < n; i++) {
+        records[i].magic = WAL_MAGIC;
+        records[i].crc = 0;
+        records[i].crc = crc32c(&records[i], sizeof(WalRecord));
+    }
+
+    /*Once written the record survives a process crash; the data page waits for wal_sync()*/
+    size_t bytes = (size_t)n * sizeof(WalRecord);
+#ifdef _WIN32
+    bool ok = fwrite(records, sizeof(WalRecord), (size_t)n, wal.fptr) == (size_t)n && fflush(wal.fptr) == 0;
+#else
+    bool ok = write(wal.fd, records, bytes) == (ssize_t)bytes;
+#endif
+    if (!ok) {
+        return false;
+    }
+    wal_add(wal.bytes, (long)bytes);
+    long long ticket = wal_add(wal.written, 1);
+
+    /*Batch writes are staged until the commit syncs; meanwhile fsync only bounds the backlog*/
+    if (wal_add(wal.pending, (int)n) >= wal.config.sync_records) {
+        return wal_sync_to(ticket);
+    }
+    return true;
+}
+
+/*Sealing and writing one record*/
+static bool emit_wal_record(WalRecord* r) {
+    return emit_wal_records(r, 1);
+}
+
+/*Checking a record read back from disk (torn tails fail)*/
+static bool wal_record_is_valid(const WalRecord* r) {
+    if (r->magic != WAL_MAGIC || r->lsn <= 0 ||
+        (r->kind != WAL_WRITE && r->kind != WAL_COMMIT)) {
+        return false;
+    }
+    WalRecord copy = *r;
+    copy.crc = 0;
+    return crc32c(&copy, sizeof(WalRecord)) == r->crc;
+}
+
+/*Ordering batch ids for the committed set*/
+static int compare_batches(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/*Collecting the sorted ids of every batch with a commit record (NULL if none)*/
+static long long* committed_batches(const WalRecord* records, long count, long* n) {
+    *n = 0;
+    long long* ids = NULL;
+    for (long i = 0; i < count; i++) {
+        if (records[i].kind != WAL_COMMIT) {
+            continue;
+        }
+        long long* grown = realloc(ids, (size_t)(*n + 1) * sizeof(long long));
+        if (!grown) {
+            break; // Missing ids only roll back more than needed
+        }
+        ids = grown;
+        ids[(*n)++] = records[i].batch;
+    }
+    if (*n > 1) {
+        qsort(ids, (size_t)*n, sizeof(long long), compare_batches);
+    }
+    return ids;
+}
+
+/*Reading every intact record of inventory.wal (count 0 if none)*/
+static WalRecord* read_wal_records(long* count, long long* discarded) {
+    *count = 0;
+    *discarded = 0;
+    FILE* fptr = fopen(WAL_FILE, "rb");
+    if (!fptr) {
+        return NULL;
+    }
+
+    WalRecord* records = NULL;
+    long capacity = 0;
+    WalRecord r;
+    while (fread(&r, sizeof(WalRecord), 1, fptr) == 1 && wal_record_is_valid(&r)) {
+        if (*count == capacity) {
+            long new_capacity = capacity ? capacity * 2 : 256;
+            WalRecord* grown = realloc(records, new_capacity * sizeof(WalRecord));
+            if (!grown) {
+                break;
+            }
+            records = grown;
+            capacity = new_capacity;
+        }
+        records[(*count)++] = r;
+    }
+
+    fseek(fptr, 0, SEEK_END);
+    *discarded = (long long)ftell(fptr) - (long long)*count * (long long)sizeof(WalRecord);
+    fclose(fptr);
+    return records;
+}
+
+/*===== Log lifecycle =====*/
+/*Opening inventory.wal for appending*/
+bool wal_open() {
+    if (wal.is_open) {
+        return true;
+    }
+    if (!wal.config_loaded) {
+        wal.config = load_wal_config();
+        wal.config_loaded = true;
+    }
+
+#ifdef _WIN32
+    wal.fptr = fopen(WAL_FILE, "ab");
+    if (!wal.fptr) {
+        return false;
+    }
+    fseek(wal.fptr, 0, SEEK_END);
+    wal.bytes = ftell(wal.fptr);
+#else
+    wal.fd = open(WAL_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (wal.fd < 0) {
+        return false;
+    }
+    wal.bytes = (long)lseek(wal.fd, 0, SEEK_END);
+#endif
+    wal.pending = 0;
+    wal.is_open = true;
+    return true;
+}
+
+/*Syncing and closing inventory.wal*/
+void wal_close() {
+    if (!wal.is_open) {
+        return;
+    }
+    wal_sync();
+#ifdef _WIN32
+    fclose(wal.fptr);
+    wal.fptr = NULL;
+#else
+    close(wal.fd);
+    wal.fd = -1;
+#endif
+    wal.batch = 0;
+    wal.batch_depth = 0;
+    wal.batch_records = 0;
+    wal.is_open = false;
+}
+
+/*Reading WAL settings from storage.cfg*/
+WalConfig load_wal_config() {
+    WalConfig config = {
+        .enabled = true,
+        .sync_records = DEFAULT_WAL_SYNC_RECORDS,
+        .checkpoint_bytes = DEFAULT_WAL_CHECKPOINT_KB * 1024L
+    };
+    FILE* fptr = fopen(STORAGE_CONFIG_FILE, "r");
+
+    if (fptr) {
+        char line[256];
+        int enabled = 1;
+        while (fgets(line, sizeof(line), fptr)) {
+            if (sscanf(line, "wal=%d", &enabled) == 1) {
+                config.enabled = (enabled != 0);
+                continue;
+            }
+            if (sscanf(line, "wal_sync_records=%d", &config.sync_records) == 1) {
+                continue;
+            }
+            if (sscanf(line, "wal_checkpoint_kb=%ld", &config.checkpoint_bytes) == 1) {
+                config.checkpoint_bytes *= 1024L;
+                continue;
+            }
+        }
+        fclose(fptr);
+    }
+
+    /*Falling back to the defaults on nonsense values*/
+    if (config.sync_records <= 0) {
+        config.sync_records = DEFAULT_WAL_SYNC_RECORDS;
+    }
+    if (config.checkpoint_bytes <= 0) {
+        config.checkpoint_bytes = DEFAULT_WAL_CHECKPOINT_KB * 1024L;
+    }
+    return config;
+}
+
+/*===== Logging =====*/
+/*Logging a record change before it is applied (before is NULL for an appended slot)*/
+bool wal_append(long slot, const Product* before, const Product* after) {
+    if (!wal_open()) {
+        return false;
+    }
+
+    WalRecord r;
+    memset(&r, 0, sizeof(r));
+    r.lsn = wal_add(wal.next_lsn, 1) - 1;
+    r.batch = wal.batch;
+    r.slot = slot;
+    r.kind = WAL_WRITE;
+    r.flags = (wal.batch ? WAL_FLAG_BATCH : 0) | (before ? 0 : WAL_FLAG_NEW_SLOT);
+    if (before) {
+        r.before = *before;
+    }
+    r.after = *after;
+
+    if (!emit_wal_record(&r)) {
+        return false;
+    }
+    if (wal.batch) {
+        wal.batch_records++;
+        return true;
+    }
+
+    /*Outside a batch the change is applied as soon as this returns, so the record must be durable*/
+    return wal_sync();
+}
+
+/*Logging n records appended from first_slot, WAL_APPEND_CHUNK records per write*/
+bool wal_append_many(long first_slot, const Product* after, long n) {
+    if (!wal_open()) {
+        return false;
+    }
+    WalRecord* chunk = malloc(WAL_APPEND_CHUNK * sizeof(WalRecord));
+    if (!chunk) {
+        return false;
+    }
+
+    bool ok = true;
+    for (long done = 0; ok && done < n; ) {
+        long k = n - done < WAL_APPEND_CHUNK ? n - done : WAL_APPEND_CHUNK;
+        memset(chunk, 0, (size_t)k * sizeof(WalRecord));
+        long long lsn = wal_add(wal.next_lsn, k) - k;
+        for (long i = 0; i < k; i++) {
+            chunk[i].lsn = lsn + i;
+            chunk[i].batch = wal.batch;
+            chunk[i].slot = first_slot + done + i;
+            chunk[i].kind = WAL_WRITE;
+            chunk[i].flags = (wal.batch ? WAL_FLAG_BATCH : 0) | WAL_FLAG_NEW_SLOT;
+            chunk[i].after = after[done + i];
+        }
+        ok = emit_wal_records(chunk, k);
+        done += k;
+    }
+    free(chunk);
+
+    if (ok && wal.batch) {
+        wal.batch_records += n;
+    }
+    else if (ok) {
+        ok = wal_sync(); // One fsync for every chunk, before the records are applied
+    }
+    return ok;
+}
+
+/*Starting a batch whose writes recover all together or not at all*/
+void wal_begin_batch() {
+    if (wal.batch_depth++ == 0) {
+        wal.batch = wal.next_lsn;
+        wal.batch_records = 0;
+    }
+}
+
+/*Logging the commit record of the outermost batch*/
+bool wal_end_batch() {
+    if (wal.batch_depth == 0 || --wal.batch_depth > 0) {
+        return true;
+    }
+
+    bool ok = true;
+    if (wal.batch_records > 0 && wal_open()) {
+        WalRecord r;
+        memset(&r, 0, sizeof(r));
+        r.lsn = wal.next_lsn++;
+        r.batch = wal.batch;
+        r.slot = -1;
+        r.kind = WAL_COMMIT;
+
+        /*The batch's writes are staged until this returns, so the commit must be durable*/
+        ok = emit_wal_record(&r) && wal_sync();
+    }
+    wal.batch = 0;
+    wal.batch_records = 0;
+    return ok;
+}
+
+/*Checking whether a batch is open*/
+bool wal_in_batch() {
+    return wal.batch_depth > 0;
+}
+
+/*Forcing logged records to stable storage (returns once every finished write is durable)*/
+bool wal_sync() {
+    return wal_sync_to(wal_load(wal.written));
+}
+
+/*===== Checkpoints and recovery =====*/
+/*Checking whether the WAL has grown enough to checkpoint (never inside a batch)*/
+bool wal_needs_checkpoint() {
+    return wal.is_open && wal.batch_depth == 0 && wal_load(wal.bytes) >= wal.config.checkpoint_bytes;
+}
+
+/*Emptying the WAL once the data file holds everything it describes*/
+bool wal_reset() {
+    if (wal.batch_depth > 0) {
+        return false; // An open batch still needs its before-images
+    }
+    if (!wal_open()) {
+        return false;
+    }
+#ifdef _WIN32
+    fclose(wal.fptr);
+    wal.fptr = fopen(WAL_FILE, "wb");
+    if (!wal.fptr) {
+        wal.is_open = false;
+        return false;
+    }
+#else
+    if (ftruncate(wal.fd, 0) != 0 || fsync(wal.fd) != 0) {
+        return false;
+    }
+#endif
+    wal_set(wal.bytes, 0);
+    wal_set(wal.pending, 0);
+    wal.synced = wal_load(wal.written); // Nothing left to sync
+    return true;
+}
+
+/*Redoing every logged write, then undoing every batch that never committed (apply NULL = tombstone)*/
+/*Writers of different records may log out of LSN order; each record's own writes stay in order*/
+bool wal_recover(bool (*apply)(long slot, const Product* p), WalRecoveryStats* stats) {
+    memset(stats, 0, sizeof(WalRecoveryStats));
+    long count;
+    WalRecord* records = read_wal_records(&count, &stats->discarded);
+
+    /*Redo: after-images in log order, so torn or lost data pages are rewritten*/
+    bool ok = true;
+    for (long i = 0; i < count; i++) {
+        const WalRecord* r = &records[i];
+        if (r->kind == WAL_COMMIT) {
+            continue;
+        }
+        ok = apply((long)r->slot, &r->after) && ok;
+        stats->redone++;
+    }
+
+    /*Undo: every batch without a commit record goes back to its before-images, newest first*/
+    long committed_count;
+    long long* committed = committed_batches(records, count, &committed_count);
+    for (long i = count - 1; i >= 0; i--) {
+        const WalRecord* r = &records[i];
+        if (r->kind != WAL_WRITE || !(r->flags & WAL_FLAG_BATCH) ||
+            (committed_count > 0 && bsearch(&r->batch, committed, (size_t)committed_count,
+                sizeof(long long), compare_batches))) {
+            continue;
+        }
+        ok = apply((long)r->slot, (r->flags & WAL_FLAG_NEW_SLOT) ? NULL : &r->before) && ok;
+        stats->undone++;
+    }
+    free(committed);
+
+    for (long i = 0; i < count; i++) {
+        if (records[i].lsn >= wal.next_lsn) {
+            wal.next_lsn = records[i].lsn + 1;
+        }
+    }
+    free(records);
+    return ok;
+}
@@ -0,0 +1,29 @@
+#ifndef BACKUP_CATALOG_H
+#define BACKUP_CATALOG_H
+
+#include "backup-restore.h"
+#include <stdbool.h>
+
+// Constants
+#define BACKUP_CATALOG_FILE BACKUP_DIR "/catalog.txt"
+#define BACKUP_CATALOG_TEMP BACKUP_DIR "/catalog.tmp"
+#define CATALOG_ADD_MARK '+'
+#define CATALOG_REMOVE_MARK '-'
+
+/*Every backup on disk, oldest first (replayed from the catalog journal)*/
+typedef struct {
+    BackupEntry* entries;
+    int count;
+    int capacity;
+    int journal_lines; // Lines in the file, compacted once removals dominate
+    bool loaded;
+} BackupCatalog;
+
+/*===== Catalog =====*/
+BackupCatalog* backup_catalog_get();
+bool backup_catalog_add(const BackupEntry* entry);
+bool backup_catalog_remove(const char* filename);
+int backup_catalog_find(const char* filename);
+void backup_catalog_reset();
+
+#endif // !BACKUP_CATALOG_H
@@ -0,0 +1,72 @@
+#ifndef BACKUP_DELTA_H
+#define BACKUP_DELTA_H
+
+#include "inventory.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// Constants
+#define BACKUP_CONFIG_FILE "backup.cfg"
+#define BACKUP_BLOCK_RECORDS 64 // Records per change-tracking block
+#define BACKUP_BLOCK_SIZE (BACKUP_BLOCK_RECORDS * (int)sizeof(Product))
+#define BACKUP_NAME_LEN 64
+#define BACKUP_MANIFEST_EXT ".blk"
+#define BACKUP_DELTA_EXT ".inc"
+#define BACKUP_MANIFEST_MAGIC 0x464D4249 // "IBMF"
+#define BACKUP_DELTA_MAGIC 0x4C444249 // "IBDL"
+#define BACKUP_FORMAT_VERSION 3
+#define BACKUP_CHECKSUM_FORMAT "crc32c:%08x"
+#define DEFAULT_MAX_CHAIN 24 // Deltas before the next full backup
+#define MAX_CHAIN_LIMIT 4096 // Sanity bound when following parent links
+
+/*Backup mode settings (read from backup.cfg)*/
+typedef struct {
+    bool incremental; // Write deltas against the latest backup
+    int max_chain; // Deltas allowed between full backups
+    bool online; // Snapshot in the background while sales continue
+} BackupConfig;
+
+/*Backup manifest header (followed by block_count 64-bit block checksums)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    char name[BACKUP_NAME_LEN]; // Backup file this manifest describes
+    char parent[BACKUP_NAME_LEN]; // Backup it is a delta against ("" if full)
+    long long file_size; // inventory.dat size captured by the backup
+    long long block_count; // 0 when only the whole-file checksum is kept
+    int block_size; // BACKUP_BLOCK_SIZE, or 0 without block checksums
+    int chain_length; // 0 for a full backup
+    unsigned int file_crc; // CRC32C of the backup file (past the header for deltas)
+    int reserved;
+    long long log_seq; // Transaction-log records the backup already reflects
+} BackupManifestHeader;
+
+/*Loaded block manifest*/
+typedef struct {
+    BackupManifestHeader header;
+    unsigned long long* checksums;
+} BackupManifest;
+
+/*===== Configuration =====*/
+BackupConfig load_backup_config();
+
+/*===== Manifests =====*/
+bool load_backup_manifest(const char* backup_path, BackupManifest* manifest);
+bool load_latest_manifest(BackupManifest* manifest);
+bool write_backup_manifest(const char* backup_path, unsigned int file_crc, bool with_blocks,
+    long long log_seq);
+bool save_backup_manifest(const char* backup_path, long long file_size,
+    const unsigned long long* checksums, unsigned int file_crc, long long log_seq);
+void free_backup_manifest(BackupManifest* manifest);
+void remove_backup_manifest(const char* backup_path);
+int verify_backup_checksum(const char* backup_path);
+bool backup_checksum_string(const char* backup_path, char* out, size_t size);
+
+/*===== Delta backups =====*/
+unsigned long long backup_block_checksum(const void* block, size_t length);
+bool is_delta_backup(const char* path);
+bool create_delta_backup(const char* delta_path, const BackupManifest* parent, unsigned int* checksum,
+    long long log_seq);
+bool rebuild_from_chain(const char* delta_path, const char* dest);
+
+#endif // !BACKUP_DELTA_H
@@ -0,0 +1,18 @@
+#ifndef BACKUP_ONLINE_H
+#define BACKUP_ONLINE_H
+
+#include <stdbool.h>
+
+/*Outcome of online_backup_finish()*/
+typedef enum {
+    ONLINE_BACKUP_IDLE = -1, // Nothing started, or still running (when not waiting)
+    ONLINE_BACKUP_FAILED = 0,
+    ONLINE_BACKUP_DONE = 1
+} OnlineBackupResult;
+
+/*===== Online backups =====*/
+bool online_backup_start(const char* backup_path);
+bool online_backup_running();
+OnlineBackupResult online_backup_finish(bool wait);
+
+#endif // !BACKUP_ONLINE_H
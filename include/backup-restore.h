@@ -12,10 +12,9 @@
 
 #define BACKUP_DIR "backups"
 #define BACKUP_LOG "backups.log"
-#define SAFETY_BACKUP "safety_restore.bak"
+#define RESTORE_TEMP_FILE "restore.tmp" // Restored file, renamed over inventory.dat once valid
 #define RETENTION_CONFIG_FILE "retention.cfg"
 #define ROTATION_LOG "rotation.log"
-#define MAX_BACKUPS 100
 
 #ifdef _WIN32
 // Windows doesn't have scandir, use this implementation
@@ -36,23 +35,21 @@ typedef struct {
     char filename[256];
     size_t file_size;
     time_t timestamp;
-    bool is_valid;
+    bool is_valid; // A checksum is on record
     char checksum[33];
+    char parent[256]; // Backup a delta was taken against ("" if full)
 } BackupEntry;
 
-extern BackupEntry backup_list[MAX_BACKUPS];
-extern int backup_count;
-
 /*===== Backup creation operations =====*/
 bool create_backup();
 void list_backups();
 bool validate_backup(const char* backup_path);
+void log_backup(const char* backup_path, bool success);
+void catalog_backup(const char* backup_path, unsigned int checksum, const char* parent);
 
 /*===== Backup restoration operations ======*/
 bool restore_backup(const char* backup_path);
 bool validate_backup_integrity(const char* path);
-char* create_safety_backup();
-bool restore_from_safety();
 
 /*===== Backup rotation operations ======*/
 /*Configuration management*/
@@ -63,6 +60,7 @@ time_t get_backup_timestamp(const char* filename);
 int calculate_backup_age_days(time_t backup_time);
 /*Backup listing and sorting*/
 BackupEntry* list_backups_sorted(int* count);
+const BackupEntry* get_backup_entry(int number);
 /*Rotation logic*/
 void enforce_retention_policy(const RetentionPolicy* policy);
 void delete_old_backups_by_count(int max_count);
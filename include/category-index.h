@@ -0,0 +1,43 @@
+#ifndef CATEGORY_INDEX_H
+#define CATEGORY_INDEX_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define CATEGORY_TABLE_INITIAL 64 // Hash buckets, must be a power of two
+
+/*One interned category and the record slots filed under it*/
+typedef struct {
+    char name[MAX_CATEGORY_LEN];
+    long* slots; // Posting list (unordered)
+    long count;
+    long capacity;
+} CategoryEntry;
+
+/*Category dictionary plus posting lists*/
+typedef struct {
+    CategoryEntry* entries; // Indexed by category ID
+    int count;
+    int capacity;
+    int* table; // Open-addressing name hash -> category ID (-1 empty)
+    int table_size;
+    int* slot_category; // Per-slot category ID (-1 if not indexed)
+    long* slot_position; // Per-slot position in its posting list
+    long slot_capacity;
+    bool built; // Posting lists reflect the store
+} CategoryIndex;
+
+/*===== Dictionary =====*/
+int category_intern(const char* name);
+int category_find(const char* name);
+const char* category_name(int category_id);
+int category_total();
+
+/*===== Posting lists =====*/
+bool category_index_build();
+void category_index_reset();
+void category_index_update(long slot, const Product* before, const Product* after);
+long category_postings(int category_id, const long** slots);
+
+#endif // !CATEGORY_INDEX_H
@@ -0,0 +1,35 @@
+#ifndef COLUMN_SNAPSHOT_H
+#define COLUMN_SNAPSHOT_H
+
+#include "inventory.h"
+#include <limits.h>
+#include <stdbool.h>
+
+// Constants
+#define COLUMN_DEAD_QUANTITY INT_MAX // Quantity stored for tombstoned slots
+#define COLUMN_DEAD_CATEGORY -1 // Category ID stored for tombstoned slots
+
+/*Struct-of-arrays copy of the numeric fields, one entry per record slot*/
+typedef struct {
+    int* id;
+    float* price; // 0 for dead slots, so they add nothing to value
+    int* quantity; // COLUMN_DEAD_QUANTITY for dead slots
+    int* category_id; // COLUMN_DEAD_CATEGORY for dead slots
+    long count; // Slots in the snapshot
+    long capacity;
+    bool built;
+} ColumnSnapshot;
+
+/*===== Snapshot lifecycle =====*/
+bool column_snapshot_build(ColumnSnapshot* snap);
+void column_snapshot_free(ColumnSnapshot* snap);
+const ColumnSnapshot* column_snapshot_get();
+void column_snapshot_reset();
+void column_snapshot_update(long slot, const Product* before, const Product* after);
+
+/*===== Aggregate kernels (SIMD with scalar fallback) =====*/
+double column_total_value(const ColumnSnapshot* snap);
+long column_count_range(const ColumnSnapshot* snap, int lo, int hi);
+const char* column_kernel_name();
+
+#endif // !COLUMN_SNAPSHOT_H
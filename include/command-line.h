@@ -0,0 +1,7 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+/*===== Batch mode =====*/
+int run_command(int argc, char* argv[]);
+
+#endif // !COMMAND_LINE_H
@@ -0,0 +1,14 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+
+// Constants
+#define CRC32C_POLY 0x82F63B78u // Castagnoli polynomial, reflected
+
+/*===== Checksums =====*/
+unsigned int crc32c_update(unsigned int crc, const void* data, size_t length);
+unsigned int crc32c(const void* data, size_t length);
+const char* crc32c_impl_name();
+
+#endif // !CRC32C_H
@@ -0,0 +1,38 @@
+#ifndef CSV_IMPORT_H
+#define CSV_IMPORT_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define IMPORT_CHUNK_SIZE (4 * 1024 * 1024) // Bytes read per fread
+#define IMPORT_BATCH_ROWS 8192 // Valid rows handed to add_products() at once
+#define IMPORT_MAX_FIELDS 16
+#define IMPORT_ERRORS_SHOWN 10 // Rejected lines printed before going quiet
+
+/*Columns a catalogue row can carry*/
+typedef enum {
+    COLUMN_ID,
+    COLUMN_NAME,
+    COLUMN_PRICE,
+    COLUMN_QUANTITY,
+    COLUMN_CATEGORY,
+    COLUMN_COUNT
+} ImportColumn;
+
+/*Outcome of an import*/
+typedef struct {
+    long long rows; // Data rows read (header excluded)
+    long long imported;
+    long long rejected; // Failed validation
+    long long duplicates; // ID already stored or repeated in the file
+    long long ids_assigned; // Rows that came without an ID
+    long long bytes;
+    double seconds;
+} ImportStats;
+
+/*===== Import =====*/
+bool import_products(const char* path, char delimiter, ImportStats* stats);
+void report_import(const ImportStats* stats);
+
+#endif // !CSV_IMPORT_H
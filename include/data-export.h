@@ -0,0 +1,38 @@
+#ifndef DATA_EXPORT_H
+#define DATA_EXPORT_H
+
+#include "inventory.h"
+#include <stdbool.h>
+#include <time.h>
+
+// Constants
+#define EXPORT_BUFFER_SIZE (1024 * 1024) // Bytes collected before each write
+#define EXPORT_ROW_MAX 4096 // Worst-case bytes of one escaped row
+#define EXPORT_STDOUT "-" // Path that writes to standard output
+
+/*Output formats*/
+typedef enum { EXPORT_CSV, EXPORT_JSONL } ExportFormat;
+
+/*What to export (filters are applied inside the scan, not afterwards)*/
+typedef struct {
+    ExportFormat format;
+    time_t from; // Transactions only; LOG_TIME_MIN/LOG_TIME_MAX for no bound
+    time_t to;
+    int product_id; // 0 = every product
+    const char* category; // NULL = every category
+} ExportFilter;
+
+/*Outcome of an export*/
+typedef struct {
+    long long rows;
+    long long bytes;
+    double seconds;
+} ExportStats;
+
+/*===== Export =====*/
+void export_filter_init(ExportFilter* filter);
+bool export_inventory(const char* path, const ExportFilter* filter, ExportStats* stats);
+bool export_transactions(const char* path, const ExportFilter* filter, ExportStats* stats);
+void report_export(const ExportStats* stats);
+
+#endif // !DATA_EXPORT_H
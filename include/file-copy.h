@@ -0,0 +1,41 @@
+#ifndef FILE_COPY_H
+#define FILE_COPY_H
+
+#include <stdbool.h>
+
+// Constants
+#define COPY_BUFFER_SIZE (1024 * 1024) // Fallback loop buffer
+#define COPY_BUFFER_ALIGN 4096 // Page-aligned, so the kernel can copy whole pages
+#define COPY_HASH_CHUNK (8 * 1024 * 1024) // Mapped, hashed and written per step when checksumming
+
+/*How a copy was carried out*/
+typedef enum {
+    COPY_NONE,
+    COPY_REFLINK, // Filesystem clone (FICLONE), no data moved
+    COPY_RANGE, // copy_file_range, in the kernel
+    COPY_SENDFILE, // sendfile, in the kernel
+    COPY_MAPPED, // pwrite straight from a mapping of the source
+    COPY_BUFFERED // read/write through a user-space buffer
+} CopyMethod;
+
+/*Outcome of the most recent copy_file()*/
+typedef struct {
+    CopyMethod method;
+    long long bytes;
+    double seconds;
+} CopyStats;
+
+/*===== Copy engine =====*/
+bool copy_file(const char* src, const char* dest);
+bool copy_file_checked(const char* src, const char* dest, unsigned int* checksum);
+bool checksum_file(const char* path, long long offset, unsigned int* checksum);
+void set_copy_fallback(bool forced);
+const CopyStats* last_copy_stats();
+const char* copy_method_name(CopyMethod method);
+void report_copy_throughput(const char* label);
+
+/*===== Durable replacement =====*/
+bool sync_file(const char* path);
+bool install_file(const char* temp, const char* path);
+
+#endif // !FILE_COPY_H
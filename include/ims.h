@@ -0,0 +1,18 @@
+#ifndef IMS_H
+#define IMS_H
+
+/*Public API of the ims_core library: records, stock movements, the
+  transaction log, backups, the request engine and bulk import/export*/
+#include "inventory.h"
+#include "storage-engine.h"
+#include "transaction-log.h"
+#include "log-index.h"
+#include "log-replay.h"
+#include "backup-restore.h"
+#include "backup-online.h"
+#include "request-engine.h"
+#include "csv-import.h"
+#include "data-export.h"
+#include "workload-trace.h"
+
+#endif // !IMS_H
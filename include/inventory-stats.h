@@ -0,0 +1,49 @@
+#ifndef INVENTORY_STATS_H
+#define INVENTORY_STATS_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define STATS_FILE "inventory.stats"
+#define STATS_MAGIC 0x53534D49 // "IMSS"
+#define STATS_VERSION 1
+#define LOW_STOCK_LIMIT 10 // Below this (and above 0) counts as low stock
+
+/*Running totals for one category*/
+typedef struct {
+    char name[MAX_CATEGORY_LEN];
+    long product_count;
+    long units;
+    double total_value;
+} CategoryStats;
+
+/*Aggregates maintained on every stock change*/
+typedef struct {
+    long product_count;
+    long units;
+    double total_value;
+    long low_stock_count;
+    long out_of_stock_count;
+    CategoryStats* categories;
+    int category_count;
+    int category_capacity;
+    bool valid; // false until loaded or rebuilt
+} InventoryStats;
+
+/*===== Stats lifecycle =====*/
+bool stats_load();
+bool stats_save();
+bool stats_rebuild();
+void stats_reset();
+
+/*===== Incremental maintenance =====*/
+void stats_apply(const Product* before, const Product* after);
+
+/*===== Queries =====*/
+const InventoryStats* stats_get();
+const CategoryStats* stats_category(const char* category);
+bool verify_inventory_stats(bool repair);
+void display_inventory_summary();
+
+#endif // !INVENTORY_STATS_H
@@ -10,6 +10,7 @@
 // Constants
 #define MAX_NAME_LEN 50
 #define MAX_CATEGORY_LEN 30
+#define MAX_SEARCH_RESULTS 20
 #define FILENAME "inventory.dat"
 #define TEMP_FILE "temp.dat"
 #define LOG_FILE "transactions.log"
@@ -27,6 +28,25 @@ typedef struct {
 typedef enum { ADD, UPDATE, DELETE, RESTOCK, SALE }
 TransactionType;
 
+/*Stock movement outcomes*/
+typedef enum {
+    STOCK_OK,
+    STOCK_NOT_FOUND,
+    STOCK_INVALID_QUANTITY,
+    STOCK_INSUFFICIENT,
+    STOCK_WRITE_FAILED,
+    STOCK_LIMIT_EXCEEDED
+} StockResult;
+
+/*One sale or restock in a batch*/
+typedef struct {
+    int id; // Product ID
+    TransactionType type; // SALE or RESTOCK
+    int quantity; // Units moved (positive)
+    StockResult result; // Filled in when applied
+    int stock_after; // New stock, or units available on STOCK_INSUFFICIENT/STOCK_LIMIT_EXCEEDED
+} StockMovement;
+
 typedef struct {
     time_t timestamp;
     TransactionType type;
@@ -35,6 +55,7 @@ typedef struct {
     int quantity_change;
     float price_change;
     char description[100];
+    Product after; // Record as left by the change, for replay (zeroed for DELETE)
 } Transaction;
 
 /*Function prototypes*/
@@ -42,28 +63,47 @@ typedef struct {
 FILE* open_file(const char* mode);
 void close_file(FILE* fptr);
 
+/*=== Lifecycle ===*/
+void inventory_init();
+void inventory_shutdown();
+void inventory_reload();
+void set_report_verification(bool enabled);
+
 /*=== Core CRUD operations ===*/
 bool add_product(Product p);
+int add_products(const Product* products, int count);
 bool update_product(int id, Product new_data);
 bool delete_product(int id);
+int delete_products(const int* ids, int count);
 Product* get_product(int id);
+bool compact_inventory();
 
 /*=== Display & Reporting ===*/
 void display_all_products();
 void display_product(Product p);
 void generate_report();
 void low_stock_alert(int threshold);
+void list_products_by_category(const char* category);
+int search_products_by_name(const char* query, Product* results, int max_results);
+void display_name_search(const char* query);
+long count_by_category(const char* category);
+double value_by_category(const char* category);
 
 /*=== Inventory operations ===*/
 void restock_product(int id, int quantity);
 void sell_product(int id, int quantity);
+int apply_stock_movements(StockMovement* movements, int count);
+void report_stock_movement(const StockMovement* m);
 
 /*=== Logging ===*/
 void log_transaction(Transaction t);
 void display_transaction_log();
+void display_product_history(int product_id);
+void display_transactions_between(time_t from, time_t to);
 
 /*=== Utility Functions ===*/
 int generate_id();
+int reserve_ids(int count);
 bool product_exists(int id);
 void input_product_data(Product* p);
 
@@ -0,0 +1,22 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// Constants
+#define LATENCY_SUB_BUCKETS 16 // Buckets per power of two (~6% resolution)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+
+/*Latencies of one operation as a log-linear histogram (fixed size, any sample count)*/
+typedef struct {
+    long long buckets[LATENCY_BUCKETS];
+    long long count;
+    long long max_ns;
+    long long total_ns;
+} LatencyHistogram;
+
+/*===== Histogram =====*/
+void latency_reset(LatencyHistogram* h);
+void latency_add(LatencyHistogram* h, long long ns);
+double latency_percentile(const LatencyHistogram* h, double percentile);
+long long latency_clock_ns();
+
+#endif // !LATENCY_HISTOGRAM_H
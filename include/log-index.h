@@ -0,0 +1,64 @@
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include "inventory.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+// Constants
+#define LOG_INDEX_FILE "transactions.idx"
+#define LOG_LINK_FILE "transactions.lnk"
+#define LOG_INDEX_MAGIC 0x58494C49 // "ILIX"
+#define LOG_INDEX_VERSION 2 // 2: records carry an after-image
+#define LOG_INDEX_BLOCK 256 // Log records per time block
+#define LOG_HEADS_INITIAL 1024 // Must be a power of two
+#define LOG_NO_RECORD -1LL // End of a product's back-link chain
+#define LOG_TIME_MIN ((time_t)0) // Open ends of a scan window
+#define LOG_TIME_MAX ((time_t)((1ULL << (sizeof(time_t) * 8 - 1)) - 1))
+
+/*Time span of one block of LOG_INDEX_BLOCK consecutive records*/
+typedef struct {
+    long long min_ts;
+    long long max_ts;
+    long long running_max; // Largest timestamp up to and including this block
+} LogTimeBlock;
+
+/*Newest log record of one product*/
+typedef struct {
+    int product_id;
+    long long last_seq; // LOG_NO_RECORD marks an unused bucket
+} LogProductHead;
+
+/*Sparse time index plus per-product back-link chains*/
+typedef struct {
+    LogTimeBlock* blocks;
+    long block_count;
+    long block_capacity;
+    LogProductHead* heads; // Open-addressing hash on product_id
+    long head_table_size;
+    long head_count;
+    FILE* links; // transactions.lnk: previous seq of the same product, per record
+    long long record_count; // Records covered by the index
+    long long last_timestamp; // Of record record_count - 1 (validates the log)
+    int last_product_id;
+    bool ready;
+} LogIndex;
+
+/*Called for each record of a scan; returning false stops it with a failure*/
+typedef bool (*LogVisitor)(const Transaction* t, void* arg);
+
+/*===== Index lifecycle =====*/
+bool log_index_open();
+void log_index_close();
+
+/*===== Maintenance =====*/
+void log_index_append(long long seq, const Transaction* records, int count);
+
+/*===== Queries =====*/
+long log_scan_range(time_t from, time_t to, LogVisitor visit, void* arg);
+long log_scan_product(int product_id, time_t from, time_t to, LogVisitor visit, void* arg);
+long log_query_range(time_t from, time_t to, Transaction** results);
+long log_query_product(int product_id, Transaction** results);
+
+#endif // !LOG_INDEX_H
@@ -0,0 +1,35 @@
+#ifndef LOG_REPLAY_H
+#define LOG_REPLAY_H
+
+#include "inventory.h"
+#include <stdbool.h>
+#include <time.h>
+
+// Constants
+#define REPLAY_BATCH 4096 // Log records read and applied per batch
+#define RECOVERY_FILE "transactions.recoveries" // Log ranges abandoned by point-in-time recoveries
+
+/*Log records [from_seq, to_seq) that a recovery rolled back (never replayed again)*/
+typedef struct {
+    long long from_seq;
+    long long to_seq;
+    long long recovered_at;
+} LogRecovery;
+
+/*Outcome of a replay*/
+typedef struct {
+    long long start_seq; // First log record replayed
+    long long end_seq; // One past the last record replayed
+    long long applied;
+    long long skipped; // Records that did not match the store (e.g. missing product)
+    long long superseded; // Records rolled back by an earlier recovery (passed over)
+    time_t last_timestamp; // Timestamp of the last record applied (0 if none)
+    double seconds;
+} ReplayStats;
+
+/*===== Replay =====*/
+bool replay_log(long long from_seq, time_t target, ReplayStats* stats);
+bool recover_to_time(time_t target, ReplayStats* stats);
+void report_replay(const ReplayStats* stats);
+
+#endif // !LOG_REPLAY_H
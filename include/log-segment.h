@@ -0,0 +1,68 @@
+#ifndef LOG_SEGMENT_H
+#define LOG_SEGMENT_H
+
+#include "inventory.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// Constants
+#define LOG_SEGMENT_DIR "log_segments"
+#define LOG_MANIFEST_FILE "transactions.manifest"
+#define LOG_MANIFEST_TEMP "transactions.manifest.tmp"
+#define LOG_SEALING_FILE "transactions.sealing" // Active log being sealed
+#define LOG_SEGMENT_MAGIC 0x47534C49 // "ILSG"
+#define LOG_MANIFEST_MAGIC 0x464D4C49 // "ILMF"
+#define LOG_SEGMENT_VERSION 2 // 2: records carry an after-image
+#define LOG_SEGMENT_LEGACY_VERSION 1 // Migrated to LOG_SEGMENT_VERSION when the manifest is rebuilt
+#define LOG_SEGMENT_BLOCK 256 // Records per independently compressed block
+#define DEFAULT_LOG_SEGMENT_KB 4096 // Seal the active log past this size
+#define DEFAULT_LOG_SEGMENT_SECONDS 86400 // ...or once its first record is this old
+
+/*Manifest entry for one sealed segment*/
+typedef struct {
+    long long first_seq; // Record number of the first record
+    long long first_ts;
+    long long last_ts;
+    long long stored_bytes; // Segment file size
+    int record_count;
+    int block_count;
+} LogSegmentInfo;
+
+/*Block table entry inside a segment file*/
+typedef struct {
+    long long offset; // From the start of the segment file
+    int stored_size;
+    int records;
+    int compressed; // 0 if the block did not shrink and is stored raw
+} LogSegmentBlock;
+
+/*Sealed segments plus a one-block decode cache*/
+typedef struct {
+    LogSegmentInfo* segments;
+    int count;
+    int capacity;
+    long long sealed_records; // Records in all sealed segments
+    int unrecognised; // Segment files that could be neither read nor migrated (sealing is refused)
+    bool loaded;
+    int open_segment; // Segment whose file and block table are open (-1 if none)
+    FILE* open_file;
+    LogSegmentBlock* open_blocks;
+    int cached_block; // Block of open_segment held in cache (-1 if none)
+    Transaction cache[LOG_SEGMENT_BLOCK];
+} LogSegmentSet;
+
+/*===== Segment set lifecycle =====*/
+bool log_segments_load();
+void log_segments_close();
+
+/*===== Sealing =====*/
+bool log_seal_file(const char* path);
+bool log_seal_prepare(const char* path, long long first_seq, LogSegmentInfo* info);
+bool log_seal_install(const char* path, const LogSegmentInfo* info);
+bool log_finish_seal();
+
+/*===== Reading =====*/
+long long log_sealed_records();
+int log_segment_read(long long seq, Transaction* buffer, int count);
+
+#endif // !LOG_SEGMENT_H
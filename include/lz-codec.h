@@ -0,0 +1,16 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <stddef.h>
+
+// Constants
+#define LZ_MIN_MATCH 4 // Shortest match worth encoding
+#define LZ_MAX_OFFSET 65535 // Matches must start within this many bytes
+#define LZ_HASH_BITS 14 // Match finder table size (2^bits positions)
+
+/*===== Codec =====*/
+size_t lz_bound(size_t size);
+size_t lz_compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+long lz_decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+
+#endif // !LZ_CODEC_H
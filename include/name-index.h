@@ -0,0 +1,53 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define TRIGRAM_TABLE_INITIAL 4096 // Hash buckets, must be a power of two
+#define TRIGRAM_EMPTY 0xFFFFFFFFu // Unused bucket (real keys fit in 24 bits)
+#define NAME_MATCH_PREFIX 3 // Name starts with the query
+#define NAME_MATCH_WORD 2 // A word in the name starts with the query
+#define NAME_MATCH_SUBSTRING 1 // Query appears inside a word
+
+/*Posting list of record slots for one trigram*/
+typedef struct {
+    unsigned int key; // Three lowercased bytes packed into 24 bits
+    long* slots;
+    long count;
+    long capacity;
+} TrigramPosting;
+
+/*Trigram inverted index over Product.name*/
+typedef struct {
+    TrigramPosting* table; // Open-addressing hash table
+    long table_size;
+    long used; // Buckets in use
+    unsigned int* seen; // Per-slot query stamp (dedupes candidates)
+    long seen_capacity;
+    unsigned int stamp;
+    long live; // Names indexed
+    long stale; // Postings left behind by renames/deletes
+    bool built;
+} NameIndex;
+
+/*One ranked search hit*/
+typedef struct {
+    long slot;
+    int id;
+    int score; // NAME_MATCH_* (higher ranks first)
+    int name_len;
+} NameMatch;
+
+/*===== Index lifecycle =====*/
+bool name_index_build();
+void name_index_reset();
+
+/*===== Maintenance =====*/
+void name_index_update(long slot, const Product* before, const Product* after);
+
+/*===== Queries =====*/
+int name_index_search(const char* query, NameMatch* results, int max_results);
+
+#endif // !NAME_INDEX_H
@@ -0,0 +1,40 @@
+#ifndef PRODUCT_INDEX_H
+#define PRODUCT_INDEX_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define INDEX_INITIAL_CAPACITY 1024 // Must be a power of two
+#define INDEX_EMPTY_SLOT -1L // Marks an unused bucket
+#define INDEX_FILE "inventory.idx"
+#define INDEX_MAGIC 0x58494D49 // "IMIX"
+#define INDEX_VERSION 1
+
+/*Index entry mapping a product ID to its record slot*/
+typedef struct {
+    int id; // Product ID (key)
+    long slot; // Record number in inventory.dat (offset = slot * sizeof(Product))
+} IndexEntry;
+
+/*Open-addressing hash index over product IDs*/
+typedef struct {
+    IndexEntry* entries;
+    size_t capacity; // Number of buckets (power of two)
+    size_t count; // Number of live entries
+    bool built; // false until index_build() has run
+} ProductIndex;
+
+/*===== Index lifecycle =====*/
+bool index_build();
+void index_reset();
+bool index_ready();
+bool index_load();
+bool index_save();
+
+/*===== Index operations =====*/
+long index_lookup(int id);
+bool index_insert(int id, long slot);
+bool index_remove(int id);
+
+#endif // !PRODUCT_INDEX_H
@@ -0,0 +1,57 @@
+#ifndef REQUEST_ENGINE_H
+#define REQUEST_ENGINE_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define ENGINE_LOCK_STRIPES 1024 // Record locks, picked by product ID
+#define ENGINE_QUEUE_CAPACITY 4096 // Requests waiting for a worker
+#define DEFAULT_ENGINE_THREADS 4
+#define MAX_ENGINE_THREADS 64
+
+/*Operations served by the engine*/
+typedef enum {
+    REQUEST_GET,
+    REQUEST_ADD,
+    REQUEST_UPDATE,
+    REQUEST_DELETE,
+    REQUEST_SELL,
+    REQUEST_RESTOCK
+} RequestType;
+
+/*One operation and its outcome (owned by the caller until done)*/
+typedef struct {
+    RequestType type;
+    int id;
+    int quantity; // Units sold or restocked
+    Product product; // ADD/UPDATE input, GET output
+    bool success;
+    StockResult result; // SELL/RESTOCK detail
+    int stock_after;
+    int done; // Set by the worker, read with engine_wait()
+} Request;
+
+/*===== Engine lifecycle =====*/
+bool engine_start(int threads);
+void engine_stop();
+bool engine_running();
+int load_engine_threads();
+
+/*===== Requests =====*/
+bool engine_submit(Request* req);
+void engine_wait(Request* req);
+bool engine_execute(Request* req);
+bool engine_move_stock(StockMovement* m);
+void engine_drain();
+void engine_exclusive(void (*fn)(void* arg), void* arg);
+
+/*===== Locking =====*/
+void engine_lock_catalog(bool exclusive);
+void engine_unlock_catalog();
+void engine_lock_record(int id, bool exclusive);
+void engine_unlock_record(int id);
+void engine_lock_shared_state();
+void engine_unlock_shared_state();
+
+#endif // !REQUEST_ENGINE_H
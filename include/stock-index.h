@@ -0,0 +1,33 @@
+#ifndef STOCK_INDEX_H
+#define STOCK_INDEX_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define STOCK_BUCKETS 4096 // Quantities 0..4095 get their own bucket
+#define STOCK_OVERFLOW STOCK_BUCKETS // Bucket for larger quantities
+#define STOCK_NEGATIVE (STOCK_BUCKETS + 1) // Bucket for quantities below zero
+#define STOCK_NIL -1L // End of a bucket list
+
+/*Quantity-ordered secondary index over record slots*/
+typedef struct {
+    long heads[STOCK_BUCKETS + 2]; // First slot in each bucket
+    long* next; // Per-slot links (STOCK_NIL terminated)
+    long* prev;
+    int* bucket; // Bucket each slot is in (-1 if not indexed)
+    long capacity; // Slots the per-slot arrays can hold
+    bool built;
+} StockIndex;
+
+/*===== Index lifecycle =====*/
+bool stock_index_build();
+void stock_index_reset();
+
+/*===== Maintenance =====*/
+void stock_index_update(long slot, const Product* before, const Product* after);
+
+/*===== Queries =====*/
+int stock_index_query(int threshold, long** slots);
+
+#endif // !STOCK_INDEX_H
@@ -0,0 +1,67 @@
+#ifndef STORAGE_ENGINE_H
+#define STORAGE_ENGINE_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define STORE_GROW_CHUNK (1024L * 1024L) // Mapped file grows 1 MB at a time
+#define TOMBSTONE_ID -1 // ID written over deleted records
+#define STORAGE_CONFIG_FILE "storage.cfg"
+#define DEFAULT_COMPACTION_THRESHOLD 0.25 // Compact when 25% of records are dead
+#define MIN_COMPACTION_RECORDS 64 // Never compact for fewer dead records
+#define SNAPSHOT_PAGE_RECORDS 64 // Copy-on-write granularity of snapshots
+
+/*Available record store back ends*/
+typedef enum { STORE_STDIO, STORE_MMAP } StorageEngine;
+
+/*Called while a new snapshot is frozen, before writes resume*/
+typedef void (*SnapshotHook)(void* context);
+
+/*Default engine: mmap where the platform supports it*/
+#ifdef _WIN32
+#define DEFAULT_STORAGE_ENGINE STORE_STDIO
+#else
+#define DEFAULT_STORAGE_ENGINE STORE_MMAP
+#endif
+
+/*===== Store lifecycle =====*/
+bool store_open();
+void store_close();
+bool store_set_engine(StorageEngine engine);
+StorageEngine store_engine();
+
+/*===== Record access =====*/
+long store_count();
+const Product* store_record(long slot);
+bool store_read(long slot, Product* out);
+bool store_write(long slot, const Product* p);
+long store_append(const Product* p);
+long store_append_many(const Product* products, long n);
+long store_insert(const Product* p);
+bool store_delete(long slot);
+bool store_is_live(const Product* p);
+
+/*===== Space reclamation =====*/
+long store_live_count();
+long store_dead_count();
+bool store_needs_compaction(double threshold);
+bool store_compact();
+double load_compaction_threshold();
+
+/*===== Durability points =====*/
+void store_flush();
+bool store_checkpoint();
+
+/*===== Batches =====*/
+void store_begin_batch();
+bool store_end_batch();
+
+/*===== Snapshots =====*/
+bool store_snapshot_begin(SnapshotHook at_freeze, void* context);
+long store_snapshot_count();
+bool store_snapshot_read(long first, long n, Product* out);
+void store_snapshot_end();
+bool store_snapshot_active();
+
+#endif // !STORAGE_ENGINE_H
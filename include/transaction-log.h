@@ -0,0 +1,65 @@
+#ifndef TRANSACTION_LOG_H
+#define TRANSACTION_LOG_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define LOG_RING_CAPACITY 1024 // Transactions buffered before a forced flush
+#define DEFAULT_LOG_FLUSH_RECORDS 64 // Flush once this many are pending
+#define DEFAULT_LOG_FLUSH_SECONDS 1 // Flush once the oldest pending is this old
+#define LOG_MAGIC 0x474F4C49 // "ILOG"
+#define LOG_VERSION 2 // 2: records carry an after-image
+#define LOG_HEADER_BYTES ((long long)sizeof(Transaction)) // The header fills the first record slot
+#define LOG_UPGRADE_CHUNK 4096 // Records converted per step when an old log is upgraded
+
+/*Header of transactions.log (padded to one record, so records stay aligned)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    int record_size; // sizeof(Transaction) when the file was created
+    char reserved[sizeof(Transaction) - 3 * sizeof(int)];
+} LogFileHeader;
+
+/*Version 1 record: written without a file header and without an after-image*/
+typedef struct {
+    time_t timestamp;
+    TransactionType type;
+    int product_id;
+    char user[30];
+    int quantity_change;
+    float price_change;
+    char description[100];
+} LegacyTransaction;
+
+/*Group commit settings (read from storage.cfg)*/
+typedef struct {
+    int flush_records; // Size threshold
+    int flush_seconds; // Time threshold
+    bool sync_on_flush; // fdatasync after every group write
+    long segment_bytes; // Seal the active log once it reaches this size
+    int segment_seconds; // ...or once its first record is this old (0 = never)
+} LogWriterConfig;
+
+/*===== Log writer lifecycle =====*/
+bool log_open();
+void log_close();
+LogWriterConfig load_log_writer_config();
+void log_set_config(LogWriterConfig config);
+
+/*===== Group commit =====*/
+bool log_commit();
+int log_pending();
+void log_begin_group();
+bool log_end_group();
+
+/*===== File format =====*/
+bool log_file_upgrade(const char* path);
+long long log_file_records(const char* path);
+void log_upgrade_record(const LegacyTransaction* old, Transaction* out);
+
+/*===== Reading =====*/
+long long log_record_count();
+int log_read(long long seq, Transaction* buffer, int count);
+
+#endif // !TRANSACTION_LOG_H
@@ -5,11 +5,13 @@
 #include "backup-restore.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /*Function prototypes*/
 void display_menu();
 void handle_menu_choice(int choice);
 int get_int_input(const char* prompt);
+time_t get_date_input(const char* prompt, bool end_of_day);
 void print_header(const char* text);
 
 #endif // !UI
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include "inventory.h"
+#include "latency-histogram.h"
+#include <stdbool.h>
+
+// Constants
+#define TRACE_MAGIC 0x52544D49 // "IMTR"
+#define TRACE_VERSION 1
+#define TRACE_BUFFER_SIZE (256 * 1024) // Records collected before each write
+#define TRACE_FLAG_PRODUCT 0x1 // A Product follows the record
+#define TRACE_FLAG_GROUPED 0x2 // More movements of the same call follow
+#define DEFAULT_TRACE_MAX_GAP_MS 5000 // Paced replay skips idle time beyond this
+
+/*Calls a trace can hold*/
+typedef enum {
+    TRACE_MENU, // Menu choice (id = choice); a marker, not replayed
+    TRACE_ADD,
+    TRACE_GET,
+    TRACE_UPDATE,
+    TRACE_DELETE,
+    TRACE_SALE,
+    TRACE_RESTOCK,
+    TRACE_REPORT,
+    TRACE_BACKUP,
+    TRACE_OP_COUNT
+} TraceOp;
+
+/*Start of a trace file (sessions recorded later append after it)*/
+typedef struct {
+    unsigned int magic;
+    int version;
+    long long started_ns; // Wall clock; record offsets count from here
+} TraceHeader;
+
+/*One recorded call (24 bytes, plus a Product when TRACE_FLAG_PRODUCT is set)*/
+typedef struct {
+    long long offset_ns; // When the call began
+    unsigned int latency_ns; // Saturates at about 4.3 s
+    unsigned char op;
+    unsigned char flags;
+    unsigned char outcome; // 1/0 for success, the StockResult for movements
+    unsigned char reserved;
+    int id;
+    int quantity;
+} TraceRecord;
+
+/*How to replay*/
+typedef struct {
+    bool paced; // Keep the recorded gaps between calls
+    double speed; // Pacing multiplier (2 = twice as fast)
+    long long max_gap_ms; // Longest recorded gap kept when paced
+    bool quiet; // Silence the output of replayed calls
+} TraceReplayOptions;
+
+/*Outcome of a replay*/
+typedef struct {
+    long long calls;
+    long long markers; // Menu choices passed over
+    long long mismatches; // Calls whose outcome differs from the recording
+    double seconds;
+    LatencyHistogram replayed[TRACE_OP_COUNT];
+    LatencyHistogram recorded[TRACE_OP_COUNT];
+} TraceReplayStats;
+
+/*===== Recording =====*/
+bool trace_start(const char* path);
+void trace_stop();
+bool trace_recording();
+void trace_flush();
+long long trace_begin();
+void trace_end(TraceOp op, long long started, int id, int quantity, const Product* p, int outcome);
+void trace_end_group(long long started, const StockMovement* movements, int count);
+void load_trace_config();
+
+/*===== Replay =====*/
+void trace_replay_options_init(TraceReplayOptions* options);
+bool trace_replay(const char* path, const TraceReplayOptions* options, TraceReplayStats* stats);
+void report_trace_replay(const TraceReplayStats* stats);
+
+#endif // !WORKLOAD_TRACE_H
@@ -0,0 +1,64 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include "inventory.h"
+#include <stdbool.h>
+
+// Constants
+#define WAL_FILE "inventory.wal"
+#define WAL_MAGIC 0x314C4157 // "WAL1"
+#define DEFAULT_WAL_SYNC_RECORDS 256 // fsync the WAL once this many records are pending
+#define DEFAULT_WAL_CHECKPOINT_KB 4096 // Checkpoint once the WAL grows past this
+#define WAL_APPEND_CHUNK 256 // Records per write() when logging bulk appends
+#define WAL_FLAG_BATCH 0x1 // Part of a batch: only counts once its commit record is logged
+#define WAL_FLAG_NEW_SLOT 0x2 // Appended the slot, so undo leaves a tombstone
+
+/*Kinds of WAL records*/
+typedef enum { WAL_WRITE = 1, WAL_COMMIT = 2 } WalRecordKind;
+
+/*One logged record change (before and after images), or a batch commit*/
+typedef struct {
+    unsigned int magic;
+    unsigned int crc; // CRC32C of the record with this field zeroed
+    long long lsn;
+    long long batch; // LSN of the batch's first record (0 outside batches)
+    long long slot;
+    int kind;
+    int flags;
+    Product before;
+    Product after;
+} WalRecord;
+
+/*WAL settings from storage.cfg*/
+typedef struct {
+    bool enabled;
+    int sync_records;
+    long checkpoint_bytes;
+} WalConfig;
+
+/*Outcome of startup recovery*/
+typedef struct {
+    long long redone; // Record images re-applied
+    long long undone; // Writes of an unfinished batch rolled back
+    long long discarded; // Bytes of torn tail ignored
+} WalRecoveryStats;
+
+/*===== Log lifecycle =====*/
+bool wal_open();
+void wal_close();
+WalConfig load_wal_config();
+
+/*===== Logging =====*/
+bool wal_append(long slot, const Product* before, const Product* after);
+bool wal_append_many(long first_slot, const Product* after, long n);
+void wal_begin_batch();
+bool wal_end_batch();
+bool wal_in_batch();
+bool wal_sync();
+
+/*===== Checkpoints and recovery =====*/
+bool wal_needs_checkpoint();
+bool wal_reset();
+bool wal_recover(bool (*apply)(long slot, const Product* p), WalRecoveryStats* stats);
+
+#endif // !WRITE_AHEAD_LOG_H